@@ -0,0 +1,31 @@
+// Streaming rolling-window statistics over published snapshots (src/Aggregator.cpp).
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "Telemetry.hpp"
+
+// Tracks temperature, power, usage and every per-core frequency over the
+// RM_AGG_WINDOW_* windows. Add costs O(1) amortized per metric and window;
+// Fill costs O(histogram buckets) per metric and window. Not thread-safe.
+class StreamingAggregator
+{
+public:
+    StreamingAggregator();
+    ~StreamingAggregator();
+    StreamingAggregator(const StreamingAggregator&) = delete;
+    StreamingAggregator& operator=(const StreamingAggregator&) = delete;
+
+    // Folds one sample in. Returns false if the sample was not usable (failed
+    // read) or state could not be allocated. A timestamp older than the last
+    // one, or a change in core count, starts the windows over.
+    bool Add(const RMCpuSnapshot& snapshot, uint64_t timestamp_ms);
+
+    // Writes the current statistics; cursor is left to the caller.
+    void Fill(RMAggregateSnapshot& out) const;
+
+    void Reset();
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
@@ -0,0 +1,21 @@
+// QPC clock helpers and latency summaries shared across the library
+// (src/Clock.cpp).
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <vector>
+#include "Telemetry.hpp"
+
+// Counter ticks per second, queried once per process.
+LONGLONG QpcFrequency();
+LONGLONG QpcNow();
+
+// Tick spans convert without overflow for any span; negative ones give 0.
+uint64_t QpcToMicroseconds(LONGLONG ticks);
+uint64_t QpcToNanoseconds(LONGLONG ticks);
+// In the 100 ns units of waitable timer due times.
+uint64_t QpcTo100ns(LONGLONG ticks);
+LONGLONG MicrosecondsToQpc(uint64_t us);
+
+// Percentiles of nanosecond samples, by nearest rank. Sorts `samples` in place.
+RMLatencyPercentiles SummarizeLatencies(std::vector<uint64_t>& samples);
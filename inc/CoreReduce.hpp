@@ -0,0 +1,60 @@
+// Fused reductions over the SDK's per-core arrays (src/CoreReduce.cpp).
+#pragma once
+#include <cstdint>
+#include "Telemetry.hpp"
+
+// Inputs of one reduction. Any array may be null; count is the length of the
+// non-null ones.
+struct CoreArrays
+{
+    const double* freq;
+    const double* residency;
+    const double* temp;
+    uint32_t count;
+};
+
+// A core is active when its frequency is non-zero, or always when there is no
+// frequency array. Residency and frequency figures cover active cores only, the
+// way rm_monitor_read has always averaged residency. Fields whose array was
+// null stay 0, as do freq_min/freq_max when no core is active.
+struct CoreReduction
+{
+    uint32_t active_count;
+    double residency_sum;
+    double residency_max;
+    double freq_min;
+    double freq_max;
+    double freq_sum;
+    double freq_residency_sum; // sum of freq * residency, for a weighted mean
+    double temp_max;
+};
+
+// Instruction sets ReduceCoreArrays can run on; values match RM_REDUCE_ISA_*.
+enum ReduceIsa
+{
+    kReduceScalar = RM_REDUCE_ISA_SCALAR,
+    kReduceSse2 = RM_REDUCE_ISA_SSE2,
+    kReduceAvx2 = RM_REDUCE_ISA_AVX2,
+    kReduceAvx512 = RM_REDUCE_ISA_AVX512
+};
+
+// Best instruction set this CPU and OS support, detected once.
+ReduceIsa GetReduceIsa();
+
+// One pass over the arrays. When group_size is non-zero, also writes the sum of
+// active residency and active frequency of every group_size consecutive cores
+// to group_residency / group_freq (either may be null), which must hold
+// (count + group_size - 1) / group_size entries.
+void ReduceCoreArrays(const CoreArrays& in, CoreReduction& out,
+    uint32_t group_size = 0, double* group_residency = nullptr, double* group_freq = nullptr);
+
+// Same, on an explicit instruction set. The caller checks it is supported.
+void ReduceCoreArraysWith(ReduceIsa isa, const CoreArrays& in, CoreReduction& out,
+    uint32_t group_size = 0, double* group_residency = nullptr, double* group_freq = nullptr);
+
+// Stores a reduction in the RMCpuSnapshot per-core summary fields. has_freq
+// says whether the reduction had a frequency array.
+void ApplyCoreSummary(const CoreReduction& cores, bool has_freq, RMCpuSnapshot& snapshot);
+
+// Recomputes the RMCpuSnapshot per-core summary fields from its own arrays.
+void SummarizeSnapshotCores(RMCpuSnapshot& snapshot);
@@ -0,0 +1,37 @@
+// Supported processors and per-generation hints, looked up from CPUID
+// 0x80000001 (src/CpuSupport.cpp).
+#pragma once
+#include <cstdint>
+
+// A family/model range sharing one die layout.
+struct CpuGeneration
+{
+    const char* codename;
+    const char* core;           // "Zen 3" etc.
+    uint32_t family;
+    uint32_t model_first;
+    uint32_t model_last;
+    // Cores under one L3, or 0 when the die mixes CCX sizes.
+    uint32_t cores_per_ccx;
+    uint32_t ccx_per_ccd;
+};
+
+struct CpuIdentity
+{
+    uint32_t signature;         // CPUID 0x80000001 EAX
+    uint32_t package_type;      // CPUID 0x80000001 EBX[31:28]
+    uint32_t family;
+    uint32_t model;
+    uint32_t stepping;
+    // The Monitoring SDK supports this signature in this package.
+    bool supported;
+    // nullptr for a family/model the table does not know.
+    const CpuGeneration* generation;
+};
+
+// Decodes CPUID 0x80000001 EAX/EBX. Touches no hardware, so made-up values
+// can be passed in.
+CpuIdentity IdentifyCpu(uint32_t eax, uint32_t ebx);
+
+// IdentifyCpu for the processor this runs on, computed once.
+const CpuIdentity& IdentifyThisCpu();
@@ -0,0 +1,88 @@
+// Report layouts of the supported cooler displays, keyed by USB VID/PID
+// (src/DisplayProtocol.cpp).
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Telemetry.hpp"
+
+using DisplayReport = std::array<uint8_t, RM_HID_REPORT_SIZE>;
+
+// What a display shows; the report fields round these to whole units.
+struct DisplayValues
+{
+    double temperature_c;
+    double power_w;
+    double usage_percent;
+};
+
+enum class FieldSource : uint8_t
+{
+    TemperatureC,
+    PowerW,
+    UsagePercent
+};
+
+enum class FieldEncoding : uint8_t
+{
+    U8,
+    U16BE,
+    U16LE,
+    F32BE,          // the rounded value as an IEEE float
+    F32LE
+};
+
+enum class ChecksumType : uint8_t
+{
+    None,
+    Sum8            // low byte of the sum of bytes [first, end)
+};
+
+// One value placed into a report. It is rounded to the nearest integer and
+// clamped to [min, max] (NaN counts as 0) before it is encoded.
+struct ReportField
+{
+    FieldSource source;
+    FieldEncoding encoding;
+    uint8_t offset;
+    int32_t min;
+    int32_t max;
+};
+
+#define RM_REPORT_MAX_TEMPLATE	32
+#define RM_REPORT_MAX_FIELDS	4
+
+// A report is its template bytes (zero-padded to `size`), then the fields,
+// then the checksum.
+struct ReportLayout
+{
+    uint8_t size;               // bytes per WriteFile
+    uint8_t template_size;
+    uint8_t template_bytes[RM_REPORT_MAX_TEMPLATE];
+    uint8_t field_count;
+    ReportField fields[RM_REPORT_MAX_FIELDS];
+    ChecksumType checksum;
+    uint8_t checksum_first;
+    uint8_t checksum_end;
+    uint8_t checksum_offset;
+};
+
+#define RM_DISPLAY_MAX_INIT	4
+
+struct DisplayProtocol
+{
+    const char* name;
+    uint16_t vendor_id;
+    uint16_t product_id;
+    // Shortest gap between two reports the display keeps up with.
+    uint32_t min_write_interval_ms;
+    // Sent once, in order, after the device is opened.
+    uint8_t init_count;
+    ReportLayout init[RM_DISPLAY_MAX_INIT];
+    ReportLayout status;
+};
+
+// nullptr when no table entry matches. vendor_id 0 picks the first entry.
+const DisplayProtocol* FindDisplayProtocol(uint16_t vendor_id, uint16_t product_id);
+
+void RenderDisplayInit(const DisplayProtocol& protocol, uint32_t index, DisplayReport& report);
+void RenderDisplayStatus(const DisplayProtocol& protocol, const DisplayValues& values, DisplayReport& report);
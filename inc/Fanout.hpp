@@ -0,0 +1,8 @@
+// Hook into the in-process snapshot hub (src/Fanout.cpp).
+#pragma once
+#include "Telemetry.hpp"
+
+// Writes `snapshot` into the hub's broadcast ring and wakes the sinks waiting
+// for it. It never waits on a sink, and returns at once while none is
+// registered.
+void FanoutPublish(const RMCpuSnapshot& snapshot);
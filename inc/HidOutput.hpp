@@ -0,0 +1,9 @@
+// Hook into the USB HID output stage started with rm_hid_output_start
+// (src/HidOutput.cpp).
+#pragma once
+#include "Telemetry.hpp"
+
+// Queues the temperature, power and usage of `snapshot` for the HID output
+// thread when rm_hid_output_start is active. Like RecorderSubmit it never
+// allocates or waits: a full queue or a concurrent submit drops the sample.
+void HidOutputSubmit(const RMCpuSnapshot& snapshot);
@@ -0,0 +1,54 @@
+// Hooks into the binary telemetry recorder and its log reader (src/Recorder.cpp).
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "Telemetry.hpp"
+
+// Queues a copy of `snapshot` for the recorder thread when rm_recorder_start is
+// active. Never allocates or waits: if the queue is full or another thread is
+// submitting at the same moment, the sample is dropped and counted instead.
+void RecorderSubmit(const RMCpuSnapshot& snapshot);
+
+// Sequential reader over the segments of a recording directory. Yields the
+// committed samples whose time falls in [from_utc_ms, to_utc_ms], oldest first,
+// including from a segment the recorder is still appending to.
+class LogReader
+{
+public:
+    LogReader();
+    ~LogReader();
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    // Returns an RMMonitorStatus code. An empty directory is not an error.
+    int Open(const wchar_t* directory, uint64_t from_utc_ms, uint64_t to_utc_ms);
+
+    // Returns false once the window is exhausted. `snapshot` stays valid until
+    // the next call; utc_ms is its time in milliseconds since the Unix epoch.
+    bool Next(const RMCpuSnapshot*& snapshot, uint64_t& utc_ms);
+
+    // Starts over from the beginning of the window.
+    void Rewind();
+
+private:
+    uint64_t ToUtc(uint64_t timestamp_ms) const;
+    bool OpenSegment(const std::wstring& path);
+    void CloseSegment();
+    bool LoadBlock();
+
+    std::vector<std::wstring> segments_;
+    size_t next_segment_ = 0;
+    uint64_t from_utc_ms_ = 0;
+    uint64_t to_utc_ms_ = 0;
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    const uint8_t* view_ = nullptr;
+    uint64_t committed_ = 0;
+    uint64_t offset_ = 0;
+    uint64_t created_utc_ms_ = 0;
+    uint64_t created_tick_ms_ = 0;
+    std::vector<RMCpuSnapshot> samples_;
+    uint32_t sample_count_ = 0;
+    uint32_t sample_index_ = 0;
+};
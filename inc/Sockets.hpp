@@ -0,0 +1,47 @@
+// Multi-socket reads: CPU device enumeration, parallel per-socket snapshots and
+// the combined view (src/Sockets.cpp).
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "ICPUEx.h"
+#include "IDeviceManager.h"
+#include "Telemetry.hpp"
+
+// Stores the CPU devices of `manager` in index order, at most max_cpus, and
+// returns how many. Device 0 is still tried when GetDeviceCount(dtCPU) reports
+// none, as the single-socket code always did.
+uint32_t EnumerateCPUs(IDeviceManager& manager, ICPUEx** cpus, uint32_t max_cpus);
+
+// Reads every socket once per Read call. Socket 0 is read on the calling
+// thread, every further socket on a worker thread of its own that sleeps
+// between reads, so a tick takes as long as the slowest socket rather than the
+// sum. Read must not be called from two threads at once.
+class SocketReader
+{
+public:
+    SocketReader();
+    ~SocketReader();
+    SocketReader(const SocketReader&) = delete;
+    SocketReader& operator=(const SocketReader&) = delete;
+
+    // Takes the devices (at most RM_MAX_SOCKETS) and starts the workers.
+    // Returns false if a thread or event could not be created.
+    bool Start(ICPUEx* const* cpus, uint32_t count);
+
+    // Fills out.sockets and socket_count; cursor and timestamp_ms are left to
+    // the caller. Each snapshot gets its own status and timestamp. Returns the
+    // number of sockets read successfully.
+    uint32_t Read(RMSocketSnapshots& out);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+// Folds the successfully read sockets into one package-wide snapshot.
+// Temperatures, voltages and clocks take the maximum; power and current values
+// and limits add up; usage and average voltage are core-weighted means. The
+// per-core arrays are concatenated in socket order (up to RM_MAX_CORES) and
+// only core fields every socket has are kept. With one socket this is a copy.
+// Returns false when no socket was read.
+bool CombineSocketSnapshots(const RMSocketSnapshots& sockets, RMCpuSnapshot& out);
@@ -0,0 +1,37 @@
+// Sparkline rasterizer for the plugin's graph items (src/Sparkline.cpp).
+#pragma once
+#include <cstdint>
+
+// Colors are 0x00RRGGBB, the pixel layout of a 32-bit BI_RGB DIB section.
+struct SparklineStyle
+{
+    uint32_t background;
+    uint32_t fill;          // area under the line
+    uint32_t line;
+};
+
+// A graph kept as a ring of pixel columns: each sample draws one column at
+// `head`, so a push costs O(height) however long the history is. The oldest
+// column is `head`; a painter copies columns [head, width) and then
+// [0, head). `pixels` is width * height, row-major and top-down, and belongs
+// to the caller.
+struct Sparkline
+{
+    uint32_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t head;
+    int32_t last_row;       // row of the previous sample, -1 after a gap
+    double min;
+    double max;
+    SparklineStyle style;
+};
+
+// Clears the pixels to the background. Values are scaled from [min, max] to
+// the full height and clamped.
+void SparklineInit(Sparkline& line, uint32_t* pixels, uint32_t width, uint32_t height, double min, double max,
+    const SparklineStyle& style);
+
+// Draws `value` into the next column, joined to the previous sample by a
+// vertical run. NaN leaves a gap.
+void SparklinePush(Sparkline& line, double value);
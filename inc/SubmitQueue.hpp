@@ -0,0 +1,115 @@
+// Bounded try-lock submit queue for the stages fed from the sampling path.
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+
+// Many producers, one consumer thread. A producer copies into a slot under a
+// try-lock and never waits: when another producer holds the lock or the ring
+// is full, the sample is dropped and counted. Only the consumer advances the
+// head. The slots belong to the caller, which keeps Capacity of them alive
+// from Attach until Close has returned and its consumer thread has exited.
+template <typename T, uint32_t Capacity>
+class SubmitQueue
+{
+public:
+    // Points the queue at fresh slots before the consumer thread starts.
+    // `data_event` is set after each accepted sample.
+    void Attach(T* slots, HANDLE data_event)
+    {
+        slots_ = slots;
+        data_event_ = data_event;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+    }
+
+    void Open()
+    {
+        accepting_.store(true, std::memory_order_release);
+    }
+
+    // Once this returns no producer touches the slots or data_event again:
+    // one that passed the accepting check before the store still holds the
+    // lock, and taking it once waits that producer out.
+    void Close()
+    {
+        accepting_.store(false, std::memory_order_release);
+        AcquireSRWLockExclusive(&lock_);
+        ReleaseSRWLockExclusive(&lock_);
+    }
+
+    bool Accepting() const
+    {
+        return accepting_.load(std::memory_order_acquire);
+    }
+
+    // Calls fill(T&) on the next free slot. Returns false if the sample was
+    // dropped or the queue is closed.
+    template <typename Fill>
+    bool TryPush(Fill&& fill)
+    {
+        if (!Accepting())
+        {
+            return false;
+        }
+        if (!TryAcquireSRWLockExclusive(&lock_))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        bool pushed = false;
+        if (accepting_.load(std::memory_order_relaxed))
+        {
+            const uint64_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) < Capacity)
+            {
+                fill(slots_[tail % Capacity]);
+                tail_.store(tail + 1, std::memory_order_release);
+                SetEvent(data_event_);
+                pushed = true;
+            }
+            else
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        ReleaseSRWLockExclusive(&lock_);
+        return pushed;
+    }
+
+    // Consumer thread only. Calls sink(const T&) for every queued sample,
+    // oldest first; each slot is released once sink returns.
+    template <typename Sink>
+    void Drain(Sink&& sink)
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        while (head != tail)
+        {
+            sink(static_cast<const T&>(slots_[head % Capacity]));
+            head_.store(++head, std::memory_order_release);
+        }
+    }
+
+    uint64_t Dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t TakeDropped()
+    {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    SRWLOCK lock_ = SRWLOCK_INIT;
+    std::atomic<bool> accepting_{ false };
+    T* slots_ = nullptr;
+    HANDLE data_event_ = nullptr;
+    std::atomic<uint64_t> head_{ 0 };
+    std::atomic<uint64_t> tail_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
@@ -0,0 +1,662 @@
+// Shared types for the telemetry C ABI (ryzenmaster-monitor, TM plugin, IPC consumers).
+#pragma once
+#include <cstdint>
+
+// Status codes returned by the rm_monitor_*, rm_sampler_* and rm_recorder_* calls.
+enum RMMonitorStatus
+{
+    RM_STATUS_OK = 0,
+    RM_STATUS_INVALID_ARG = 1,
+    RM_STATUS_NOT_ADMIN = 2,
+    RM_STATUS_UNSUPPORTED_OS = 3,
+    RM_STATUS_NOT_AMD = 4,
+    RM_STATUS_DRIVER = 5,
+    RM_STATUS_UNSUPPORTED_CPU = 6,
+    RM_STATUS_ALLOC_FAILED = 7,
+    RM_STATUS_SDK_INIT_FAILED = 8,
+    RM_STATUS_READ_FAILED = 9,
+    RM_STATUS_IO_FAILED = 10
+};
+
+// Number of samples retained by the v3 shared-memory ring
+// (Global\RyzenTelemetrySharedV3): per-slot seqlocks, with the header, write
+// cursor, writer fields and waiter count each on a cache line of its own. The
+// full snapshot is double-buffered in the same mapping; aggregates, topology,
+// sampler status, per-socket snapshots, inventory and stats are side pages in
+// mappings of their own.
+#define RM_IPC_RING_CAPACITY	64
+
+// One published telemetry sample as seen by IPC consumers.
+// cursor is the monotonically increasing publish index of the sample.
+struct RMIpcSample
+{
+    uint64_t cursor;
+    uint64_t timestamp_ms;
+    int32_t status;
+    uint32_t reserved;
+    double temperature_c;
+    double power_w;
+    double usage_percent;
+};
+
+// Per-core arrays in RMCpuSnapshot hold at most this many cores.
+#define RM_MAX_CORES	256
+
+// RMCpuSnapshot::core_fields bits: which per-core arrays the SDK filled in.
+#define RM_CORE_FIELD_FREQ			0x1
+#define RM_CORE_FIELD_RESIDENCY		0x2
+#define RM_CORE_FIELD_CURRENT_FREQ	0x4
+#define RM_CORE_FIELD_TEMP			0x8
+
+// Full CPUParameters sample in a fixed, cache-line-aligned layout. Scalars come
+// first; each per-core array starts on its own cache line so consumers that
+// scan one metric touch only that metric's lines.
+struct alignas(64) RMCpuSnapshot
+{
+    uint64_t cursor;
+    uint64_t timestamp_ms;
+    int32_t status;
+    uint32_t oc_mode;
+    uint32_t core_count;
+    uint32_t core_fields;
+
+    // Values derived the same way rm_monitor_read reports them.
+    double temperature_c;
+    double power_w;
+    double usage_percent;
+
+    double package_temperature_c;
+    double peak_core_voltage;
+    double peak_core_voltage_1;
+    double soc_voltage;
+    double avg_core_voltage;
+    double avg_core_voltage_1;
+    double peak_speed_mhz;
+
+    float ppt_limit_w;
+    float ppt_value_w;
+    float tdc_limit_vdd_a;
+    float tdc_value_vdd_a;
+    float tdc_value_vdd_1_a;
+    float edc_limit_vdd_a;
+    float edc_value_vdd_a;
+    float edc_value_vdd_1_a;
+    float chtc_limit_c;
+    float fclk_p0_freq_mhz;
+    float cclk_fmax_mhz;
+    float tdc_limit_soc_a;
+    float tdc_value_soc_a;
+    float edc_limit_soc_a;
+    float edc_value_soc_a;
+    float vddcr_vdd_power_w;
+    float vddcr_soc_power_w;
+    float tdc_limit_ccd_a;
+    float tdc_value_ccd_a;
+    float edc_limit_ccd_a;
+    float edc_value_ccd_a;
+
+    // Summary of the per-core arrays over active cores (non-zero frequency),
+    // computed in one pass. Frequencies are core_current_freq_mhz when present,
+    // else core_freq_mhz; weighted is the residency-weighted mean. These fill
+    // what used to be padding before the first array.
+    uint32_t active_core_count;
+    double core_freq_min_mhz;
+    double core_freq_max_mhz;
+    double core_freq_mean_mhz;
+    double core_freq_weighted_mhz;
+    double core_temp_max_c;
+
+    alignas(64) double core_freq_mhz[RM_MAX_CORES];
+    alignas(64) double core_residency[RM_MAX_CORES];
+    alignas(64) double core_current_freq_mhz[RM_MAX_CORES];
+    alignas(64) double core_temp_c[RM_MAX_CORES];
+};
+
+// Sockets a monitor context reads; further CPU devices are ignored.
+#define RM_MAX_SOCKETS	4
+
+// One snapshot per CPU device (socket), in SDK device order. The snapshot
+// returned by rm_monitor_read_snapshot and published to the ring combines them.
+// A socket whose read failed has a non-zero status and is left out of the
+// combined view. cursor matches the combined RMCpuSnapshot.
+struct RMSocketSnapshots
+{
+    uint64_t cursor;
+    uint64_t timestamp_ms;
+    uint32_t socket_count;
+    uint32_t reserved;
+    RMCpuSnapshot sockets[RM_MAX_SOCKETS];
+};
+
+// Counters kept by the sampler thread started with rm_sampler_start.
+// Lateness is how far past its scheduled deadline a tick started.
+struct RMSamplerStats
+{
+    uint64_t ticks;
+    uint64_t read_failures;
+    uint64_t missed_ticks;
+    uint64_t last_lateness_us;
+    uint64_t max_lateness_us;
+    uint64_t total_lateness_us;
+    uint64_t last_read_us;
+    uint64_t max_read_us;
+    uint32_t period_us;
+    int32_t last_status;
+    // Adaptive policy only (rm_sampler_start_adaptive); a fixed-rate sampler
+    // keeps current_period_us at period_us and never counts a speedup.
+    uint32_t current_period_us;
+    uint32_t reserved;
+    uint64_t avg_read_us;       // moving average of the SDK read cost
+    uint64_t speedups;          // ticks that dropped the period to its minimum
+    uint64_t budget_clamps;     // ticks whose period was raised to respect max_sdk_duty
+};
+
+// Rate policy of rm_sampler_start_adaptive. The temperature and power slopes
+// are measured over at least 250 ms of samples. When either reaches its fast_*
+// threshold the period drops to min_period_us; while both stay under their
+// flat_* thresholds it grows by backoff_factor per tick up to max_period_us;
+// in between it is held. The period is never shorter than the average SDK read
+// cost divided by max_sdk_duty, so sampling cannot spend more than that
+// fraction of a core in the SDK. min_period_us is therefore only reached while
+// reads average at most min_period_us * max_sdk_duty; the default 0.10 keeps
+// the 50 ms floor for reads up to 5 ms.
+struct RMSamplerPolicy
+{
+    uint32_t min_period_us;
+    uint32_t max_period_us;
+    double fast_temp_c_per_s;
+    double fast_power_w_per_s;
+    double flat_temp_c_per_s;
+    double flat_power_w_per_s;
+    double backoff_factor;
+    double max_sdk_duty;
+};
+
+// Sampler state published after every tick, read with rm_ipc_read_sampler.
+// A reader's max age has to allow for the longest period of the policy.
+struct RMSamplerStatus
+{
+    uint64_t timestamp_ms;
+    uint64_t ticks;
+    uint32_t period_us;         // period until the next tick
+    int32_t adaptive;
+    double rate_hz;
+    uint64_t last_read_us;
+    uint64_t avg_read_us;
+    uint64_t max_read_us;
+    double sdk_duty;            // avg_read_us / period_us
+    double temp_c_per_s;        // last measured slopes
+    double power_w_per_s;
+};
+
+// Counters kept by the recorder started with rm_recorder_start.
+// raw_bytes is what the written samples would take as plain RMCpuSnapshots.
+struct RMRecorderStats
+{
+    uint64_t samples_written;
+    uint64_t samples_dropped;
+    uint64_t blocks_written;
+    uint64_t segments_opened;
+    uint64_t bytes_written;
+    uint64_t raw_bytes;
+    uint64_t write_errors;
+    uint64_t writer_cpu_us;
+    uint64_t max_block_encode_us;
+    int32_t running;
+    uint32_t reserved;
+};
+
+// Parameters of rm_recorder_bench: synthetic snapshots of core_count cores
+// submitted at publish_rate_hz (0 means back to back) for duration_ms.
+struct RMRecorderBenchConfig
+{
+    uint32_t publish_rate_hz;
+    uint32_t duration_ms;
+    uint32_t core_count;
+    uint32_t reserved;
+};
+
+// Result of rm_recorder_bench. elapsed_us runs from the first submit until the
+// recorder has flushed and stopped; writer_cpu_percent is writer_cpu_us over
+// that span and compression_ratio is raw_bytes over bytes_written.
+struct RMRecorderBenchStats
+{
+    uint64_t elapsed_us;
+    uint64_t submitted;
+    uint64_t samples_written;
+    uint64_t samples_dropped;
+    uint64_t blocks_written;
+    uint64_t bytes_written;
+    uint64_t raw_bytes;
+    uint64_t writer_cpu_us;
+    uint64_t max_block_encode_us;
+    double writer_cpu_percent;
+    double compression_ratio;
+};
+
+// Called by rm_log_scan for each recorded sample in the window, oldest first.
+// utc_ms is the sample time in milliseconds since the Unix epoch. Return
+// non-zero to stop the scan.
+typedef int (*RMLogScanCallback)(const RMCpuSnapshot* snapshot, uint64_t utc_ms, void* user);
+
+// Latency distribution of one replay stage, in nanoseconds.
+struct RMLatencyPercentiles
+{
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+};
+
+// Result of rm_replay_run. read covers log decoding and the CPUParameters
+// round trip, publish covers rm_ipc_publish_snapshot, lateness is how far past
+// its paced deadline each sample started (zero at max speed) and total runs
+// from that deadline to the end of the publish.
+struct RMReplayStats
+{
+    uint64_t samples;
+    uint64_t elapsed_us;
+    uint64_t recorded_span_ms;
+    double samples_per_second;
+    RMLatencyPercentiles read;
+    RMLatencyPercentiles publish;
+    RMLatencyPercentiles lateness;
+    RMLatencyPercentiles total;
+};
+
+// Instruction sets of the per-core reduction kernels (rm_reduce_bench).
+#define RM_REDUCE_ISA_AUTO		-1
+#define RM_REDUCE_ISA_SCALAR	0
+#define RM_REDUCE_ISA_SSE2		1
+#define RM_REDUCE_ISA_AVX2		2
+#define RM_REDUCE_ISA_AVX512	3
+
+// Result of rm_reduce_bench: cost of one fused pass over core_count synthetic
+// cores on the given instruction set.
+struct RMReduceBenchStats
+{
+    int32_t isa;
+    uint32_t core_count;
+    uint64_t iterations;
+    double ns_per_call;
+    double cores_per_us;
+};
+
+// Result of rm_sparkline_bench: one sample pushed into a graph's column ring,
+// against redrawing the graph's whole width-sample history.
+struct RMSparklineBenchStats
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t iterations;
+    double ns_per_push;
+    double ns_per_redraw;
+    uint64_t checksum;          // keeps the work observable
+};
+
+// Rolling windows kept by the streaming aggregator, in RMAggregateSnapshot::windows order.
+#define RM_AGG_WINDOW_1S	0
+#define RM_AGG_WINDOW_10S	1
+#define RM_AGG_WINDOW_60S	2
+#define RM_AGG_WINDOW_5MIN	3
+#define RM_AGG_WINDOW_COUNT	4
+
+// Statistics of one metric over one window. min/max are exact; the
+// percentiles come from a fixed-bucket histogram. ema uses the window length
+// as its time constant. count is the number of samples in the window; when it
+// is 0 every other field is 0.
+struct RMAggregate
+{
+    double min;
+    double max;
+    double mean;
+    double ema;
+    double p50;
+    double p90;
+    double p99;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct RMAggregateWindow
+{
+    uint32_t window_ms;
+    uint32_t core_count;
+    RMAggregate temperature_c;
+    RMAggregate power_w;
+    RMAggregate usage_percent;
+    RMAggregate core_freq_mhz[RM_MAX_CORES];
+};
+
+// Aggregates published with every snapshot. cursor matches the RMCpuSnapshot
+// (and ring sample) that was the latest input.
+struct RMAggregateSnapshot
+{
+    uint64_t cursor;
+    uint64_t timestamp_ms;
+    RMAggregateWindow windows[RM_AGG_WINDOW_COUNT];
+};
+
+// Cache domains tracked by RMTopology: a CCX is the set of cores sharing one
+// L3, a CCD is the die holding one or more CCXs.
+#define RM_MAX_DOMAINS	32
+#define RM_DOMAIN_NONE	0xFFFFFFFFu
+
+// Where RMTopology::source got the core-to-L3 mapping.
+#define RM_TOPOLOGY_SOURCE_OS		0	// Windows processor/cache relations
+#define RM_TOPOLOGY_SOURCE_CPUID	1	// CPUID 0x8000001D/0x8000001E sharing counts
+#define RM_TOPOLOGY_SOURCE_DEFAULT	2	// assumed 8 cores per CCX
+#define RM_TOPOLOGY_SOURCE_TABLE	3	// cores per CCX of the CPU generation (src\CpuSupport.cpp)
+
+// One CCX. Its cores are core_order[first] .. core_order[first + core_count - 1].
+struct RMCoreDomain
+{
+    uint32_t ccd;
+    uint32_t first;
+    uint32_t core_count;
+    uint32_t reserved;
+};
+
+// Maps SDK core indices (the order of the per-core arrays) to CCX and CCD.
+// core_order lists SDK indices CCX by CCX, and CCXs are sorted by CCD, so both
+// kinds of domain are contiguous ranges of it.
+struct RMTopology
+{
+    uint32_t core_count;
+    uint32_t ccx_count;
+    uint32_t ccd_count;
+    uint32_t threads_per_core;
+    uint32_t source;
+    uint32_t reserved;
+    double l3_kb_per_ccx;
+    RMCoreDomain ccx[RM_MAX_DOMAINS];
+    uint16_t core_order[RM_MAX_CORES];
+    uint8_t core_ccx[RM_MAX_CORES];
+};
+
+// Per-domain figures derived the same way as the package-wide ones in
+// RMCpuSnapshot; fields whose per-core array is missing stay 0.
+struct RMDomainStats
+{
+    uint32_t core_count;
+    uint32_t active_cores;
+    double usage_percent;
+    double freq_mean_mhz;
+    double freq_max_mhz;
+    double temp_max_c;
+};
+
+// Per-CCX and per-CCD statistics published with every snapshot. cursor matches
+// the RMCpuSnapshot they were computed from. hottest_* is the domain with the
+// highest core temperature, or RM_DOMAIN_NONE without per-core temperatures.
+struct RMTopologySnapshot
+{
+    uint64_t cursor;
+    uint64_t timestamp_ms;
+    uint32_t hottest_ccx;
+    uint32_t hottest_ccd;
+    RMTopology topology;
+    RMDomainStats ccx[RM_MAX_DOMAINS];
+    RMDomainStats ccd[RM_MAX_DOMAINS];
+};
+
+// SDK calls timed by the built-in instrumentation, in RMStats::calls order.
+#define RM_SDK_CALL_LOAD_PLATFORM	0	// loading Platform.dll
+#define RM_SDK_CALL_PLATFORM_INIT	1	// IPlatform::Init
+#define RM_SDK_CALL_GET_CPU_PARAMETERS	2	// ICPUEx::GetCPUParameters
+#define RM_SDK_CALL_QUERY_DRIVER	3	// QueryDrvService
+#define RM_SDK_CALL_INSTALL_DRIVER	4	// InstallDriver
+#define RM_SDK_CALL_COUNT	5
+
+// Latency histograms count microseconds in log-linear (HDR-style) buckets:
+// values below RM_LATENCY_SUB_BUCKETS get a bucket each, and every power of two
+// above that is split into RM_LATENCY_SUB_BUCKETS equal buckets, so a bucket is
+// at most 1/16 of its value wide. Values of 2^32 us or more land in the last
+// bucket.
+#define RM_LATENCY_SUB_BUCKETS	16
+#define RM_LATENCY_BUCKETS	464
+
+// Size of RMStats::status_counts; larger codes are counted in the last entry.
+#define RM_STATUS_CODE_COUNT	16
+
+struct RMLatencyHistogram
+{
+    uint64_t count;
+    uint64_t failures;
+    uint64_t total_us;
+    uint64_t max_us;
+    int32_t last_error;         // last non-zero return value of the call
+    uint32_t reserved;
+    uint32_t buckets[RM_LATENCY_BUCKETS];
+};
+
+// Instrumentation counters, returned by rm_stats_snapshot. When shared is 1
+// they live in the Global\RyzenTelemetryStats mapping and cover every process
+// on the machine since since_ms; otherwise they cover this process only.
+// Counters are read one at a time, so a copy taken while calls are being
+// recorded may be off by the calls in flight.
+struct RMStats
+{
+    uint64_t since_ms;
+    uint64_t timestamp_ms;
+    uint32_t shared;
+    uint32_t reserved;
+    RMLatencyHistogram calls[RM_SDK_CALL_COUNT];
+    uint64_t status_counts[RM_STATUS_CODE_COUNT]; // rm_monitor_* results by RM_STATUS_* code
+    uint64_t torn_read_retries;     // seqlock reads retried because a write was in progress
+    uint64_t torn_read_failures;    // seqlock reads that gave up after their retries
+    uint64_t stale_reads;           // IPC reads that returned IPC_STALE
+    uint64_t owner_acquisitions;
+    uint64_t owner_handoffs;        // acquisitions of a mutex another process had opened
+    uint64_t owner_abandoned;       // acquisitions after the previous owner died holding it
+    uint64_t owner_contended;       // attempts that found the mutex held
+    uint64_t owner_releases;
+};
+
+// RMPlatformInventory::flags bits.
+#define RM_INVENTORY_OS_SUPPORTED	0x1
+#define RM_INVENTORY_AUTHENTIC_AMD	0x2
+#define RM_INVENTORY_CPU_SUPPORTED	0x4
+#define RM_INVENTORY_DRIVER_RUNNING	0x8	// rm_monitor_init found the driver service running
+#define RM_INVENTORY_DEVICES		0x10	// CPU fields below came from the SDK
+#define RM_INVENTORY_BIOS			0x20	// BIOS and memory fields came from the SDK
+
+#define RM_INVENTORY_TEXT_LEN	64
+
+// Static facts about the machine, returned by rm_platform_inventory. The host
+// checks rm_monitor_init makes (OS, vendor, processor, driver service) are
+// probed once and kept in the Global\RyzenTelemetryInventory mapping, so later
+// inits and other processes read them instead of asking the OS and the SCM
+// again. The CPU, BIOS and memory fields are added by the first process that
+// initializes the SDK. sdk_stamp identifies the SDK and driver files the
+// inventory was taken with; when they change it is probed again. Memory
+// timings are in clocks and stay 0 when the BIOS does not report them.
+struct RMPlatformInventory
+{
+    uint64_t timestamp_ms;      // GetTickCount64 when probed
+    uint64_t sdk_stamp;
+    uint32_t flags;
+    uint32_t cpuid_signature;   // CPUID 0x80000001 EAX
+    uint32_t package_type;      // CPUID 0x80000001 EBX[31:28]
+    uint32_t socket_count;
+    uint32_t core_count;        // all sockets
+    uint32_t family;            // decoded from cpuid_signature
+    uint32_t model;
+    uint32_t stepping;
+    double l1d_kb;
+    double l1i_kb;
+    double l2_kb;
+    double l3_kb;
+    uint16_t mem_clock_mhz;
+    uint16_t mem_vddio_mv;
+    uint8_t mem_tcl;
+    uint8_t mem_trcdrd;
+    uint8_t mem_tras;
+    uint8_t mem_trp;
+    wchar_t codename[RM_INVENTORY_TEXT_LEN];    // empty for a family/model src\CpuSupport.cpp does not know
+    wchar_t cpu_name[RM_INVENTORY_TEXT_LEN];
+    wchar_t package[RM_INVENTORY_TEXT_LEN];
+    wchar_t chipset[RM_INVENTORY_TEXT_LEN];
+    wchar_t bios_vendor[RM_INVENTORY_TEXT_LEN];
+    wchar_t bios_version[RM_INVENTORY_TEXT_LEN];
+    wchar_t bios_date[RM_INVENTORY_TEXT_LEN];
+};
+
+// Parameters of rm_ipc_bench: one writer publishing at publish_rate_hz (0 means
+// back to back) against reader_threads threads reading the newest sample in a
+// loop, for duration_ms. waiter_threads more threads (up to the same limit)
+// follow the cursor through the rm_ipc_wait path with 0-3 ms timeouts and
+// keep waiting through an idle spell after the last publish.
+#define RM_IPC_BENCH_MAX_READERS	64
+
+struct RMIpcBenchConfig
+{
+    uint32_t reader_threads;
+    uint32_t publish_rate_hz;
+    uint32_t duration_ms;
+    uint32_t waiter_threads;
+};
+
+// Result of rm_ipc_bench. The histograms use the RMLatencyHistogram bucket
+// layout but count nanoseconds, at the resolution of QueryPerformanceCounter.
+struct RMIpcBenchStats
+{
+    uint64_t elapsed_us;
+    uint64_t publishes;
+    uint64_t reads;
+    uint64_t failed_reads;      // reads that found no complete sample
+    uint64_t torn_retries;
+    uint64_t torn_failures;
+    double publishes_per_s;
+    double reads_per_s;
+    RMLatencyHistogram publish_ns;
+    RMLatencyHistogram read_ns;
+    uint64_t waits;             // waits that returned a new cursor
+    uint64_t wait_timeouts;
+    uint64_t spurious_wakeups;  // woken with the cursor unmoved; must be 0
+    uint64_t leaked_waiters;    // waiter count off zero after the run; must be 0
+};
+
+// Parameters of rm_hid_output_start. The stage drives every attached display
+// (up to RM_HID_MAX_DISPLAYS) whose VID/PID is in the protocol table of
+// src\DisplayProtocol.cpp, or only the model vendor_id/product_id when
+// vendor_id is set. With `path` set it drives that one device instead, using
+// the vendor_id/product_id protocol (the first table entry when 0); a path
+// that is not a HID device (a plain file, a named pipe) receives every report
+// appended as raw bytes, which lets the output be checked without the cooler.
+// Zero intervals select the defaults in parentheses.
+#define RM_HID_REPORT_SIZE	64
+#define RM_HID_MAX_DISPLAYS	4
+
+struct RMHidOutputConfig
+{
+    uint16_t vendor_id;
+    uint16_t product_id;
+    uint32_t reserved;
+    const wchar_t* path;
+    uint32_t min_write_interval_ms;     // shortest gap between two reports (the model's)
+    uint32_t write_timeout_ms;          // a write still pending after this is cancelled (1000)
+    uint32_t refresh_ms;                // an unchanged report is resent after this (5000)
+    uint32_t backoff_min_ms;            // first reconnect delay, doubled per failure (500)
+    uint32_t backoff_max_ms;            // longest reconnect delay (30000)
+    uint32_t reserved2;
+};
+
+// Counters kept by the stage started with rm_hid_output_start, summed over
+// the displays. skipped counts samples whose report matched the newest one;
+// coalesced counts reports replaced by a newer one while waiting for the rate
+// limit or a pending write. connects counts displays initialized.
+struct RMHidOutputStats
+{
+    uint64_t samples_submitted;
+    uint64_t samples_dropped;
+    uint64_t reports_written;
+    uint64_t reports_skipped;
+    uint64_t reports_coalesced;
+    uint64_t write_errors;
+    uint64_t write_timeouts;
+    uint64_t connects;
+    uint64_t max_write_us;
+    uint32_t backoff_ms;                // delay before the next device scan
+    uint32_t last_error;                // GetLastError of the last failure
+    int32_t connected;                  // displays open and initialized
+    int32_t running;
+};
+
+// In-process snapshot hub. Every snapshot published by rm_ipc_publish_snapshot
+// (or relayed with rm_ipc_relay_snapshot) is written once into a ring of
+// RM_HUB_CAPACITY slots; each sink registered with rm_hub_register_sink reads
+// it on its own thread, at its own pace. A sink more than RM_HUB_CAPACITY
+// snapshots behind skips to the oldest one still held.
+#define RM_HUB_CAPACITY		32
+#define RM_HUB_MAX_SINKS	64
+
+// Called on the sink's thread for every snapshot it reads, oldest first.
+// dropped counts the snapshots it skipped since the previous call. The
+// snapshot is only valid during the call.
+typedef void (*RMHubSinkCallback)(const RMCpuSnapshot* snapshot, uint64_t dropped, void* user);
+
+struct RMHubSinkStats
+{
+    uint64_t delivered;
+    uint64_t dropped;
+    uint64_t lag;                       // snapshots published but not yet read
+    uint32_t id;                        // 0 for an unused entry
+    uint32_t reserved;
+};
+
+// Returned by rm_hub_stats. sinks[] is indexed by sink slot, not by id.
+struct RMHubStats
+{
+    uint64_t published;                 // snapshots written while a sink was registered
+    uint32_t sink_count;
+    uint32_t capacity;
+    RMHubSinkStats sinks[RM_HUB_MAX_SINKS];
+};
+
+// Parameters of rm_hub_bench: one writer publishing at publish_rate_hz (0
+// means back to back) into a private hub read by `sinks` sinks, the last
+// slow_sinks of which spend slow_sink_us in every callback, for duration_ms.
+struct RMHubBenchConfig
+{
+    uint32_t sinks;
+    uint32_t slow_sinks;
+    uint32_t slow_sink_us;
+    uint32_t publish_rate_hz;
+    uint32_t duration_ms;
+    uint32_t reserved;
+};
+
+// Result of rm_hub_bench. Delivery latency runs from the start of a publish
+// to the fast sink's callback. sequence_errors counts callbacks whose cursor
+// was not the previous one plus dropped plus one; it must be 0.
+struct RMHubBenchStats
+{
+    uint64_t elapsed_us;
+    uint64_t publishes;
+    uint64_t fast_delivered;
+    uint64_t fast_dropped;
+    uint64_t slow_delivered;
+    uint64_t slow_dropped;
+    uint64_t sequence_errors;
+    double publishes_per_s;
+    RMLatencyPercentiles publish;
+    RMLatencyPercentiles delivery;
+};
+
+// Counters of the metrics endpoint started with rm_metrics_start.
+// serializations counts snapshots rendered into the cached response; scrapes
+// counts responses served from it. errors covers unknown paths, requests
+// over the size limit, timed-out clients and failed sends. Connections beyond
+// the client slots wait in the listen backlog rather than being refused.
+struct RMMetricsStats
+{
+    uint64_t serializations;
+    uint64_t scrapes;
+    uint64_t errors;
+    uint64_t response_bytes;            // size of the cached response
+    uint64_t max_serialize_us;
+    uint32_t port;
+    int32_t running;
+};
@@ -0,0 +1,63 @@
+// Telemetry sources behind rm_monitor_init: the Ryzen Master SDK or a simulator.
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "ICPUEx.h"
+#include "IBIOSEx.h"
+#include "Telemetry.hpp"
+
+// A source owns the devices it hands out; they stay valid until it is destroyed.
+class TelemetrySource
+{
+public:
+    virtual ~TelemetrySource() {}
+
+    // First CPU device (socket 0).
+    virtual ICPUEx* GetCPU() = 0;
+
+    // Number of CPU devices, one per socket, at most RM_MAX_SOCKETS.
+    virtual uint32_t GetCPUCount() { return 1; }
+
+    // CPU device of socket `index`, or nullptr past GetCPUCount.
+    virtual ICPUEx* GetCPUAt(uint32_t index) { return index == 0 ? GetCPU() : nullptr; }
+
+    // BIOS device, or nullptr when the source has none.
+    virtual IBIOSEx* GetBIOS() = 0;
+};
+
+struct SimulatorOptions
+{
+    // Script to replay; nullptr or empty selects the built-in load cycle.
+    const wchar_t* script_path = nullptr;
+    // Simulated milliseconds per wall-clock millisecond when step_ms is 0.
+    double speed = 1.0;
+    // Fixed simulated time advanced by each GetCPUParameters call. Non-zero
+    // makes the replay independent of the caller's timing.
+    unsigned int step_ms = 0;
+    // Simulated sockets, each a CPU device with the script's cores; 0 keeps
+    // the script's `sockets` directive (1 without one).
+    unsigned int sockets = 0;
+};
+
+// Returns nullptr if the script cannot be loaded.
+std::unique_ptr<TelemetrySource> CreateSimulatedSource(const SimulatorOptions& options);
+
+struct ReplayOptions
+{
+    // Directory written by rm_recorder_start.
+    const wchar_t* directory = nullptr;
+    // Window to replay, in milliseconds since the Unix epoch.
+    uint64_t from_utc_ms = 0;
+    uint64_t to_utc_ms = UINT64_MAX;
+    // Recorded milliseconds per wall-clock millisecond. 0 returns the next
+    // recorded sample on every GetCPUParameters call.
+    double speed = 1.0;
+    // Start over at the end of the window instead of failing reads.
+    bool loop = true;
+};
+
+// Returns nullptr if the directory holds no samples in the window.
+std::unique_ptr<TelemetrySource> CreateReplaySource(const ReplayOptions& options);
+
+// Reads one CPUParameters sample from `cpu` into `snapshot` (telemetry.cpp).
+bool ReadCPUSnapshot(ICPUEx* cpu, RMCpuSnapshot& snapshot);
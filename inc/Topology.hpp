@@ -0,0 +1,17 @@
+// Core-to-CCX/CCD mapping and per-domain statistics (src/Topology.cpp).
+#pragma once
+#include <cstdint>
+#include "ICPUEx.h"
+#include "Telemetry.hpp"
+
+// Maps core_count SDK cores to CCXs and CCDs. With core_count 0 the count
+// comes from cpu->GetCoreCount(); cpu may be null, and also supplies the L3
+// size. The mapping uses the OS processor and cache relations when they list
+// exactly that many cores (the SDK reports cores in the same order), else the
+// CPUID L3 sharing count. Returns false only when there are no cores.
+bool BuildCoreTopology(ICPUEx* cpu, uint32_t core_count, RMTopology& out);
+
+// Reduces the snapshot's per-core arrays per CCX and per CCD. The cores are
+// first gathered into domain order, so each domain is one contiguous run for
+// ReduceCoreArrays. Writes everything in `out` except cursor and timestamp_ms.
+void ComputeDomainStats(const RMTopology& topology, const RMCpuSnapshot& snapshot, RMTopologySnapshot& out);
@@ -142,6 +142,118 @@ fn main() {
         "cargo:rerun-if-changed={}",
         repo_root.join("inc").join("Utility.hpp").display()
     );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Telemetry.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Simulator.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("TelemetrySource.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Recorder.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Recorder.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Clock.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Clock.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("SubmitQueue.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Replay.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Aggregator.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Aggregator.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("CoreReduce.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("CoreReduce.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Topology.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Topology.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Sockets.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Sockets.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("CpuSupport.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("CpuSupport.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("HidOutput.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("HidOutput.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("DisplayProtocol.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("DisplayProtocol.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Sparkline.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Sparkline.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Fanout.cpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("inc").join("Fanout.hpp").display()
+    );
+    println!(
+        "cargo:rerun-if-changed={}",
+        repo_root.join("src").join("Metrics.cpp").display()
+    );
     let local_sdk_include = repo_root.join("third_party").join("amd_ryzen_master_sdk").join("include");
     if !local_sdk_include.join("ICPUEx.h").exists() {
         panic!(
@@ -171,10 +283,28 @@ fn main() {
     build
         .file(repo_root.join("src").join("telemetry.cpp"))
         .file(repo_root.join("src").join("Utility.cpp"))
+        .file(repo_root.join("src").join("Simulator.cpp"))
+        .file(repo_root.join("src").join("Recorder.cpp"))
+        .file(repo_root.join("src").join("Clock.cpp"))
+        .file(repo_root.join("src").join("Replay.cpp"))
+        .file(repo_root.join("src").join("Aggregator.cpp"))
+        .file(repo_root.join("src").join("CoreReduce.cpp"))
+        .file(repo_root.join("src").join("Topology.cpp"))
+        .file(repo_root.join("src").join("Sockets.cpp"))
+        .file(repo_root.join("src").join("CpuSupport.cpp"))
+        .file(repo_root.join("src").join("HidOutput.cpp"))
+        .file(repo_root.join("src").join("DisplayProtocol.cpp"))
+        .file(repo_root.join("src").join("Sparkline.cpp"))
+        .file(repo_root.join("src").join("Fanout.cpp"))
+        .file(repo_root.join("src").join("Metrics.cpp"))
         .compile("ryzenmaster_wrapper");
 
     println!("cargo:rustc-link-lib=Netapi32");
     println!("cargo:rustc-link-lib=User32");
     println!("cargo:rustc-link-lib=Shell32");
     println!("cargo:rustc-link-lib=Advapi32");
+    println!("cargo:rustc-link-lib=hid");
+    println!("cargo:rustc-link-lib=SetupAPI");
+    println!("cargo:rustc-link-lib=Synchronization");
+    println!("cargo:rustc-link-lib=Ws2_32");
 }
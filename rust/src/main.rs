@@ -2,7 +2,7 @@
 mod windows_app {
     use std::ffi::OsStr;
     use std::io::{self, Write};
-    use std::os::raw::{c_double, c_int};
+    use std::os::raw::{c_double, c_int, c_void};
     use std::os::windows::ffi::OsStrExt;
     use std::path::Path;
     use std::ptr;
@@ -10,18 +10,7 @@ mod windows_app {
     use std::time::Duration;
 
     use windows::core::{PCWSTR, PWSTR};
-    use windows::Win32::Devices::DeviceAndDriverInstallation::{
-        SetupDiDestroyDeviceInfoList, SetupDiEnumDeviceInterfaces, SetupDiGetClassDevsW,
-        SetupDiGetDeviceInterfaceDetailW, DIGCF_DEVICEINTERFACE, DIGCF_PRESENT,
-        SP_DEVICE_INTERFACE_DATA, SP_DEVICE_INTERFACE_DETAIL_DATA_W,
-    };
-    use windows::Win32::Devices::HumanInterfaceDevice::{HidD_GetAttributes, HidD_GetHidGuid, HIDD_ATTRIBUTES};
-    use windows::Win32::Foundation::{
-        CloseHandle, GetLastError, HANDLE, WAIT_OBJECT_0, ERROR_SERVICE_DOES_NOT_EXIST, GENERIC_READ, GENERIC_WRITE,
-    };
-    use windows::Win32::Storage::FileSystem::{
-        CreateFileW, WriteFile, FILE_ATTRIBUTE_NORMAL, FILE_SHARE_READ, FILE_SHARE_WRITE, OPEN_EXISTING,
-    };
+    use windows::Win32::Foundation::{CloseHandle, GetLastError, HANDLE, WAIT_OBJECT_0, ERROR_SERVICE_DOES_NOT_EXIST};
     use windows::Win32::System::Services::{
         CloseServiceHandle, ControlService, CreateServiceW, DeleteService, OpenSCManagerW, OpenServiceW,
         QueryServiceStatus, RegisterServiceCtrlHandlerExW, SetServiceStatus, StartServiceCtrlDispatcherW,
@@ -34,10 +23,6 @@ mod windows_app {
     };
     use windows::Win32::System::Threading::{CreateEventW, SetEvent, WaitForSingleObject};
 
-    const K_FIXED_VID: u16 = 0x3633;
-    const K_FIXED_PID: u16 = 0x000A;
-    const HID_PACKET_SIZE: usize = 64;
-
     const PLATFORM_DLL_FILE: &str = "Platform.dll";
     const EMBEDDED_PLATFORM_DLL: &[u8] = include_bytes!(concat!(env!("CARGO_MANIFEST_DIR"), "/Platform.dll"));
     const DEVICE_DLL_FILE: &str = "Device.dll";
@@ -56,8 +41,20 @@ mod windows_app {
     const RM_STATUS_ALLOC_FAILED: i32 = 7;
     const RM_STATUS_SDK_INIT_FAILED: i32 = 8;
     const RM_STATUS_READ_FAILED: i32 = 9;
+    const RM_STATUS_IO_FAILED: i32 = 10;
     const TELEMETRY_INTERVAL: Duration = Duration::from_millis(1200);
+    // The sampler speeds up to SAMPLE_MIN_INTERVAL while temperature or power
+    // move and backs off to SAMPLE_MAX_INTERVAL while they are flat.
+    const SAMPLE_MIN_INTERVAL: Duration = Duration::from_millis(50);
+    const SAMPLE_MAX_INTERVAL: Duration = Duration::from_millis(3000);
     const IPC_OK: i32 = 0;
+    const IPC_TIMEOUT: i32 = 4;
+    const RECORD_DIR_ENV: &str = "RM_TELEMETRY_RECORD_DIR";
+    // Sends the display reports to this path (a HID interface path, or a
+    // plain file that collects them) instead of the first matching cooler.
+    const HID_OUTPUT_PATH_ENV: &str = "RM_HID_OUTPUT_PATH";
+    // Serves Prometheus text on http://127.0.0.1:<port>/metrics when set.
+    const METRICS_PORT_ENV: &str = "RM_METRICS_PORT";
 
     static mut SERVICE_HANDLE: SERVICE_STATUS_HANDLE = SERVICE_STATUS_HANDLE(ptr::null_mut());
     static mut SERVICE_STOP_EVENT: HANDLE = HANDLE(ptr::null_mut());
@@ -67,33 +64,199 @@ mod windows_app {
         _private: [u8; 0],
     }
 
+    // FFI structs below carry fields only the C side reads.
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMSamplerPolicy {
+        min_period_us: u32,
+        max_period_us: u32,
+        fast_temp_c_per_s: f64,
+        fast_power_w_per_s: f64,
+        flat_temp_c_per_s: f64,
+        flat_power_w_per_s: f64,
+        backoff_factor: f64,
+        max_sdk_duty: f64,
+    }
+
+    const RM_LATENCY_BUCKETS: usize = 464;
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMLatencyHistogram {
+        count: u64,
+        failures: u64,
+        total_us: u64,
+        max_us: u64,
+        last_error: i32,
+        reserved: u32,
+        buckets: [u32; RM_LATENCY_BUCKETS],
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMIpcBenchConfig {
+        reader_threads: u32,
+        publish_rate_hz: u32,
+        duration_ms: u32,
+        waiter_threads: u32,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMIpcBenchStats {
+        elapsed_us: u64,
+        publishes: u64,
+        reads: u64,
+        failed_reads: u64,
+        torn_retries: u64,
+        torn_failures: u64,
+        publishes_per_s: f64,
+        reads_per_s: f64,
+        publish_ns: RMLatencyHistogram,
+        read_ns: RMLatencyHistogram,
+        waits: u64,
+        wait_timeouts: u64,
+        spurious_wakeups: u64,
+        leaked_waiters: u64,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMHidOutputConfig {
+        vendor_id: u16,
+        product_id: u16,
+        reserved: u32,
+        path: *const u16,
+        min_write_interval_ms: u32,
+        write_timeout_ms: u32,
+        refresh_ms: u32,
+        backoff_min_ms: u32,
+        backoff_max_ms: u32,
+        reserved2: u32,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    #[derive(Default)]
+    struct RMHidOutputStats {
+        samples_submitted: u64,
+        samples_dropped: u64,
+        reports_written: u64,
+        reports_skipped: u64,
+        reports_coalesced: u64,
+        write_errors: u64,
+        write_timeouts: u64,
+        connects: u64,
+        max_write_us: u64,
+        backoff_ms: u32,
+        last_error: u32,
+        connected: i32,
+        running: i32,
+    }
+
+    // Leading scalars of RMCpuSnapshot. Hub sinks are handed a pointer to
+    // the full snapshot and read only this prefix of it.
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMCpuSnapshotHead {
+        cursor: u64,
+        timestamp_ms: u64,
+        status: i32,
+        oc_mode: u32,
+        core_count: u32,
+        core_fields: u32,
+        temperature_c: f64,
+        power_w: f64,
+        usage_percent: f64,
+    }
+
+    type RMHubSinkCallback = unsafe extern "C" fn(snapshot: *const RMCpuSnapshotHead, dropped: u64, user: *mut c_void);
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMLatencyPercentiles {
+        p50_ns: u64,
+        p90_ns: u64,
+        p99_ns: u64,
+        p999_ns: u64,
+        max_ns: u64,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMHubBenchConfig {
+        sinks: u32,
+        slow_sinks: u32,
+        slow_sink_us: u32,
+        publish_rate_hz: u32,
+        duration_ms: u32,
+        reserved: u32,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMHubBenchStats {
+        elapsed_us: u64,
+        publishes: u64,
+        fast_delivered: u64,
+        fast_dropped: u64,
+        slow_delivered: u64,
+        slow_dropped: u64,
+        sequence_errors: u64,
+        publishes_per_s: f64,
+        publish: RMLatencyPercentiles,
+        delivery: RMLatencyPercentiles,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMRecorderBenchConfig {
+        publish_rate_hz: u32,
+        duration_ms: u32,
+        core_count: u32,
+        reserved: u32,
+    }
+
+    #[allow(dead_code)]
+    #[repr(C)]
+    struct RMRecorderBenchStats {
+        elapsed_us: u64,
+        submitted: u64,
+        samples_written: u64,
+        samples_dropped: u64,
+        blocks_written: u64,
+        bytes_written: u64,
+        raw_bytes: u64,
+        writer_cpu_us: u64,
+        max_block_encode_us: u64,
+        writer_cpu_percent: f64,
+        compression_ratio: f64,
+    }
+
     extern "C" {
         fn rm_monitor_set_sdk_path(path: *const u16);
         fn rm_monitor_init(out_ctx: *mut *mut RMMonitorContext) -> c_int;
-        fn rm_monitor_read(
-            ctx: *mut RMMonitorContext,
-            temp_c: *mut c_double,
-            power_w: *mut c_double,
-            usage_percent: *mut c_double,
-        ) -> c_int;
         fn rm_monitor_shutdown(ctx: *mut RMMonitorContext);
-        fn rm_ipc_publish(
-            temp_c: c_double,
-            power_w: c_double,
-            usage_percent: c_double,
-            status: c_int,
-        ) -> c_int;
-        fn rm_ipc_read(
-            temp_c: *mut c_double,
-            power_w: *mut c_double,
-            usage_percent: *mut c_double,
-            status: *mut c_int,
-            max_age_ms: u32,
-        ) -> c_int;
+        fn rm_sampler_start_adaptive(ctx: *mut RMMonitorContext, policy: *const RMSamplerPolicy) -> c_int;
+        fn rm_recorder_start(directory: *const u16, max_segment_bytes: u64, max_segment_seconds: u32) -> c_int;
+        fn rm_recorder_stop();
+        fn rm_recorder_bench(config: *const RMRecorderBenchConfig, stats: *mut RMRecorderBenchStats) -> c_int;
+        fn rm_ipc_relay_snapshot(max_age_ms: u32) -> c_int;
+        fn rm_ipc_wait(seq: u64, timeout_ms: u32, current: *mut u64) -> c_int;
         fn rm_ipc_service_start() -> c_int;
         fn rm_ipc_service_stop();
         fn rm_ipc_owner_try_acquire() -> c_int;
         fn rm_ipc_owner_release();
+        fn rm_ipc_bench(config: *const RMIpcBenchConfig, stats: *mut RMIpcBenchStats) -> c_int;
+        fn rm_stats_percentile(histogram: *const RMLatencyHistogram, quantile: c_double) -> c_double;
+        fn rm_hid_output_start(config: *const RMHidOutputConfig) -> c_int;
+        fn rm_hid_output_stop();
+        fn rm_hid_output_stats(stats: *mut RMHidOutputStats) -> c_int;
+        fn rm_hub_register_sink(callback: RMHubSinkCallback, user: *mut c_void, id: *mut u32) -> c_int;
+        fn rm_hub_unregister_sink(id: u32) -> c_int;
+        fn rm_hub_bench(config: *const RMHubBenchConfig, stats: *mut RMHubBenchStats) -> c_int;
+        fn rm_metrics_start(port: u32) -> c_int;
+        fn rm_metrics_stop();
     }
 
     struct MonitorContext(*mut RMMonitorContext);
@@ -114,18 +277,66 @@ mod windows_app {
         }
     }
 
-    struct HidHandle(HANDLE);
+    struct HidOutputGuard;
 
-    impl Drop for HidHandle {
+    impl Drop for HidOutputGuard {
         fn drop(&mut self) {
             unsafe {
-                if !self.0.is_invalid() {
-                    let _ = CloseHandle(self.0);
-                }
+                rm_hid_output_stop();
+            }
+        }
+    }
+
+    struct MetricsGuard;
+
+    impl Drop for MetricsGuard {
+        fn drop(&mut self) {
+            unsafe {
+                rm_metrics_stop();
             }
         }
     }
 
+    type SnapshotFn = dyn FnMut(&RMCpuSnapshotHead, u64) + Send;
+
+    // A sink of the in-process hub: the closure runs on a thread of its own
+    // for every published snapshot, oldest first, with the number it missed
+    // since the previous call. Dropping the sink unregisters it and waits for
+    // a call in progress.
+    struct HubSink {
+        id: u32,
+        _callback: Box<Box<SnapshotFn>>,
+    }
+
+    impl HubSink {
+        fn register<F>(on_snapshot: F) -> Result<HubSink, i32>
+        where
+            F: FnMut(&RMCpuSnapshotHead, u64) + Send + 'static,
+        {
+            let mut callback: Box<Box<SnapshotFn>> = Box::new(Box::new(on_snapshot));
+            let user = &mut *callback as *mut Box<SnapshotFn> as *mut c_void;
+            let mut id = 0;
+            let status = unsafe { rm_hub_register_sink(hub_sink_trampoline, user, &mut id) };
+            if status != RM_STATUS_OK {
+                return Err(status);
+            }
+            Ok(HubSink { id, _callback: callback })
+        }
+    }
+
+    impl Drop for HubSink {
+        fn drop(&mut self) {
+            unsafe {
+                rm_hub_unregister_sink(self.id);
+            }
+        }
+    }
+
+    unsafe extern "C" fn hub_sink_trampoline(snapshot: *const RMCpuSnapshotHead, dropped: u64, user: *mut c_void) {
+        let callback = &mut *(user as *mut Box<SnapshotFn>);
+        callback(&*snapshot, dropped);
+    }
+
     struct IpcServiceGuard;
 
     impl Drop for IpcServiceGuard {
@@ -137,6 +348,16 @@ mod windows_app {
         }
     }
 
+    struct RecorderGuard;
+
+    impl Drop for RecorderGuard {
+        fn drop(&mut self) {
+            unsafe {
+                rm_recorder_stop();
+            }
+        }
+    }
+
     #[derive(Clone, Copy, Debug, PartialEq, Eq)]
     enum ServiceState {
         NotInstalled,
@@ -152,6 +373,15 @@ mod windows_app {
         if args.iter().any(|arg| arg == "--run") {
             return run_monitor_loop(None);
         }
+        if args.iter().any(|arg| arg == "--ipc-bench") {
+            return run_ipc_bench();
+        }
+        if args.iter().any(|arg| arg == "--hub-bench") {
+            return run_hub_bench();
+        }
+        if args.iter().any(|arg| arg == "--record-bench") {
+            return run_record_bench();
+        }
 
         run_cli()
     }
@@ -216,6 +446,161 @@ mod windows_app {
         0
     }
 
+    // Runs the IPC publish/read benchmark over a grid of reader counts and
+    // publish rates (0 = back to back) and prints one line per run. Latencies
+    // are in nanoseconds. Each run also has WAITERS threads in rm_ipc_wait;
+    // spurious wakeups and leaked waiter registrations must stay 0.
+    fn run_ipc_bench() -> i32 {
+        const READERS: [u32; 4] = [1, 4, 16, 64];
+        const RATES_HZ: [u32; 4] = [20, 1000, 100_000, 0];
+        const WAITERS: u32 = 4;
+        const DURATION_MS: u32 = 2000;
+
+        println!(
+            "{:>7} {:>8} {:>12} {:>12} {:>10} {:>8} {:>8} {:>8} {:>8} {:>10} {:>8} {:>9} {:>9} {:>8} {:>6}",
+            "readers", "rate_hz", "publish/s", "read/s", "torn/Mread", "read_p50", "read_p99", "p99.9", "read_max", "torn_fail", "pub_p99",
+            "waits", "timeouts", "spurious", "leaked"
+        );
+        for &readers in READERS.iter() {
+            for &rate in RATES_HZ.iter() {
+                let config = RMIpcBenchConfig {
+                    reader_threads: readers,
+                    publish_rate_hz: rate,
+                    duration_ms: DURATION_MS,
+                    waiter_threads: WAITERS,
+                };
+                // Zeroed plain-data struct that the C side overwrites.
+                let mut stats: Box<RMIpcBenchStats> = unsafe { Box::new(std::mem::zeroed()) };
+                let status = unsafe { rm_ipc_bench(&config, &mut *stats) };
+                if status != RM_STATUS_OK {
+                    eprintln!("ipc bench failed: {} ({})", status_message(status), status);
+                    return 1;
+                }
+                let percentile = |histogram: &RMLatencyHistogram, q: f64| unsafe { rm_stats_percentile(histogram, q) };
+                let torn_per_mread = if stats.reads > 0 {
+                    stats.torn_retries as f64 * 1_000_000.0 / stats.reads as f64
+                } else {
+                    0.0
+                };
+                println!(
+                    "{:>7} {:>8} {:>12.0} {:>12.0} {:>10.2} {:>8.0} {:>8.0} {:>8.0} {:>8} {:>10} {:>8.0} {:>9} {:>9} {:>8} {:>6}",
+                    readers,
+                    rate,
+                    stats.publishes_per_s,
+                    stats.reads_per_s,
+                    torn_per_mread,
+                    percentile(&stats.read_ns, 0.50),
+                    percentile(&stats.read_ns, 0.99),
+                    percentile(&stats.read_ns, 0.999),
+                    stats.read_ns.max_us,
+                    stats.torn_failures,
+                    percentile(&stats.publish_ns, 0.99),
+                    stats.waits,
+                    stats.wait_timeouts,
+                    stats.spurious_wakeups,
+                    stats.leaked_waiters
+                );
+            }
+        }
+        0
+    }
+
+    // Runs the hub benchmark over 1-64 sinks, a quarter of them (one of two)
+    // stalling SLOW_SINK_US in every callback, at the sampler's fastest rate,
+    // at 1 kHz and back to back. Fast sinks must drop nothing at the first two
+    // rates however far the slow ones fall behind. Latencies are in nanoseconds.
+    fn run_hub_bench() -> i32 {
+        const SINKS: [u32; 7] = [1, 2, 4, 8, 16, 32, 64];
+        const RATES_HZ: [u32; 3] = [20, 1000, 0];
+        const SLOW_SINK_US: u32 = 100_000;
+        const DURATION_MS: u32 = 2000;
+
+        println!(
+            "{:>5} {:>4} {:>7} {:>10} {:>9} {:>9} {:>6} {:>8} {:>8} {:>9} {:>8} {:>8}",
+            "sinks", "slow", "rate_hz", "publish/s", "fast_drop", "slow_drop", "seqerr", "pub_p50", "pub_p99", "pub_max", "dlv_p50", "dlv_p99"
+        );
+        for &rate in RATES_HZ.iter() {
+            for &sinks in SINKS.iter() {
+                let slow_sinks = if sinks >= 4 { sinks / 4 } else { sinks - 1 };
+                let config = RMHubBenchConfig {
+                    sinks,
+                    slow_sinks,
+                    slow_sink_us: SLOW_SINK_US,
+                    publish_rate_hz: rate,
+                    duration_ms: DURATION_MS,
+                    reserved: 0,
+                };
+                // Plain-data struct that the C side overwrites.
+                let mut stats: RMHubBenchStats = unsafe { std::mem::zeroed() };
+                let status = unsafe { rm_hub_bench(&config, &mut stats) };
+                if status != RM_STATUS_OK {
+                    eprintln!("hub bench failed: {} ({})", status_message(status), status);
+                    return 1;
+                }
+                println!(
+                    "{:>5} {:>4} {:>7} {:>10.0} {:>9} {:>9} {:>6} {:>8} {:>8} {:>9} {:>8} {:>8}",
+                    sinks,
+                    slow_sinks,
+                    rate,
+                    stats.publishes_per_s,
+                    stats.fast_dropped,
+                    stats.slow_dropped,
+                    stats.sequence_errors,
+                    stats.publish.p50_ns,
+                    stats.publish.p99_ns,
+                    stats.publish.max_ns,
+                    stats.delivery.p50_ns,
+                    stats.delivery.p99_ns
+                );
+            }
+        }
+        0
+    }
+
+    // Runs the recorder benchmark at the sampler's fastest rate, at 1 kHz and
+    // back to back for 16 and 64 cores. cpu% is the writer thread's CPU time
+    // over the run; ratio is plain snapshot bytes over bytes written.
+    fn run_record_bench() -> i32 {
+        const CORES: [u32; 2] = [16, 64];
+        const RATES_HZ: [u32; 3] = [20, 1000, 0];
+        const DURATION_MS: u32 = 2000;
+
+        println!(
+            "{:>5} {:>7} {:>9} {:>9} {:>7} {:>11} {:>7} {:>10} {:>6}",
+            "cores", "rate_hz", "submitted", "written", "dropped", "writer_cpu", "cpu%", "encode_max", "ratio"
+        );
+        for &rate in RATES_HZ.iter() {
+            for &cores in CORES.iter() {
+                let config = RMRecorderBenchConfig {
+                    publish_rate_hz: rate,
+                    duration_ms: DURATION_MS,
+                    core_count: cores,
+                    reserved: 0,
+                };
+                // Plain-data struct that the C side overwrites.
+                let mut stats: RMRecorderBenchStats = unsafe { std::mem::zeroed() };
+                let status = unsafe { rm_recorder_bench(&config, &mut stats) };
+                if status != RM_STATUS_OK {
+                    eprintln!("recorder bench failed: {} ({})", status_message(status), status);
+                    return 1;
+                }
+                println!(
+                    "{:>5} {:>7} {:>9} {:>9} {:>7} {:>9}us {:>7.2} {:>8}us {:>6.1}",
+                    cores,
+                    rate,
+                    stats.submitted,
+                    stats.samples_written,
+                    stats.samples_dropped,
+                    stats.writer_cpu_us,
+                    stats.writer_cpu_percent,
+                    stats.max_block_encode_us,
+                    stats.compression_ratio
+                );
+            }
+        }
+        0
+    }
+
     fn run_monitor_loop(stop_event: Option<HANDLE>) -> i32 {
         let platform_dir = match ensure_platform_dll_available() {
             Some(dir) => dir,
@@ -237,33 +622,25 @@ mod windows_app {
             }
         }
         let _ipc_guard = IpcServiceGuard;
+        let _recorder_guard = start_recorder();
 
-        let mut ctx: Option<MonitorContext> = None;
+        // Keeps the SDK context alive while the sampler thread reads from it.
+        let mut _ctx: Option<MonitorContext> = None;
         let mut owns_sdk = false;
+        let mut ipc_cursor: u64 = 0;
 
-        let mut hid = match open_hid_device(K_FIXED_VID, K_FIXED_PID) {
-            Some(handle) => {
-                if init_hid_device(handle.0) {
-                    println!("ryzenmaster-monitor: USB HID ready");
-                    Some(handle)
-                } else {
-                    eprintln!("ryzenmaster-monitor: USB HID init failed, running without USB output");
-                    None
-                }
-            }
-            None => {
-                let message = format!(
-                    "ryzenmaster-monitor: USB HID device not found (vid=0x{K_FIXED_VID:04x} pid=0x{K_FIXED_PID:04x})"
-                );
-                eprintln!("{message}");
-                None
-            }
-        };
+        let _hid_guard = start_hid_output();
+        let mut hid_connected = 0;
+        // Consumers of the samples are hub sinks; this loop only keeps the
+        // sampler (or the relay from another process's sampler) running.
+        let _status_sink = start_status_log();
+        let _metrics_guard = start_metrics();
 
         loop {
             if stop_requested(stop_event) {
                 break;
             }
+            report_hid_state(&mut hid_connected);
 
             if !owns_sdk {
                 let acquired = unsafe { rm_ipc_owner_try_acquire() != 0 };
@@ -271,9 +648,27 @@ mod windows_app {
                     let mut raw_ctx: *mut RMMonitorContext = ptr::null_mut();
                     let status = unsafe { rm_monitor_init(&mut raw_ctx) };
                     if status == RM_STATUS_OK {
-                        ctx = Some(MonitorContext(raw_ctx));
-                        owns_sdk = true;
-                        println!("ryzenmaster-monitor: telemetry ready");
+                        let monitor = MonitorContext(raw_ctx);
+                        let policy = sampler_policy();
+                        let sampler_status = unsafe { rm_sampler_start_adaptive(monitor.ptr(), &policy) };
+                        if sampler_status == RM_STATUS_OK {
+                            _ctx = Some(monitor);
+                            owns_sdk = true;
+                            println!("ryzenmaster-monitor: telemetry ready");
+                        } else {
+                            drop(monitor);
+                            unsafe { rm_ipc_owner_release() };
+                            let message = format!(
+                                "ryzenmaster-monitor: sampler start failed: {} ({})",
+                                status_message(sampler_status),
+                                sampler_status
+                            );
+                            eprintln!("{message}");
+                            if wait_or_stop(stop_event, Duration::from_secs(2)) {
+                                break;
+                            }
+                            continue;
+                        }
                     } else {
                         unsafe { rm_ipc_owner_release() };
                         let message = format!(
@@ -290,65 +685,22 @@ mod windows_app {
                 }
             }
 
-            let telemetry = if owns_sdk {
-                let ctx_ref = match ctx.as_ref() {
-                    Some(value) => value,
-                    None => {
-                        owns_sdk = false;
-                        continue;
-                    }
-                };
-                match read_telemetry_with_retries(ctx_ref.ptr(), 10, stop_event) {
-                    Ok(values) => {
-                        unsafe {
-                            rm_ipc_publish(values.0, values.1, values.2, RM_STATUS_OK);
-                        }
-                        values
+            // The sampler thread publishes at its adaptive rate when we own the SDK
+            // and feeds the hub itself.
+            match wait_ipc_publish(&mut ipc_cursor) {
+                IpcWait::Published => {}
+                IpcWait::TimedOut => continue,
+                IpcWait::Unavailable => {
+                    if wait_or_stop(stop_event, TELEMETRY_INTERVAL) {
+                        break;
                     }
-                    Err(status) => {
-                        if stop_requested(stop_event) {
-                            break;
-                        }
-                        let message = format!(
-                            "ryzenmaster-monitor: telemetry read failed: {} ({})",
-                            status_message(status),
-                            status
-                        );
-                        eprintln!("{message}");
-                        unsafe {
-                            rm_ipc_publish(0.0, 0.0, 0.0, status);
-                        }
-                        if wait_or_stop(stop_event, Duration::from_secs(60)) {
-                            break;
-                        }
-                        continue;
-                    }
-                }
-            } else {
-                match read_ipc_telemetry(ipc_max_age_ms()) {
-                    Some(values) => values,
-                    None => {
-                        if wait_or_stop(stop_event, TELEMETRY_INTERVAL) {
-                            break;
-                        }
-                        continue;
-                    }
-                }
-            };
-
-            let temp_rounded = telemetry.0.round() as i32;
-            let power_rounded = telemetry.1.round() as i32;
-            let usage_rounded = telemetry.2.round() as i32;
-
-            if let Some(handle) = hid.as_ref() {
-                if !send_status_packet(handle.0, temp_rounded, power_rounded, usage_rounded) {
-                    eprintln!("ryzenmaster-monitor: USB HID write failed, disabling USB output");
-                    hid = None;
+                    continue;
                 }
             }
-
-            if wait_or_stop(stop_event, TELEMETRY_INTERVAL) {
-                break;
+            // Samples published by another process reach this process's HID
+            // stage and hub sinks only through the relay.
+            if !owns_sdk {
+                unsafe { rm_ipc_relay_snapshot(ipc_max_age_ms()) };
             }
         }
 
@@ -722,219 +1074,180 @@ mod windows_app {
             RM_STATUS_ALLOC_FAILED => "allocation failure",
             RM_STATUS_SDK_INIT_FAILED => "SDK initialization failed",
             RM_STATUS_READ_FAILED => "telemetry read failed",
+            RM_STATUS_IO_FAILED => "file I/O failed",
             _ => "unknown error",
         }
     }
 
-    fn read_telemetry(ctx: *mut RMMonitorContext) -> Result<(f64, f64, f64), i32> {
-        let mut temperature = 0.0;
-        let mut power = 0.0;
-        let mut usage = 0.0;
-        let status = unsafe { rm_monitor_read(ctx, &mut temperature, &mut power, &mut usage) };
+    // Records every sample this process publishes when RM_TELEMETRY_RECORD_DIR is set.
+    fn start_recorder() -> Option<RecorderGuard> {
+        let dir = std::env::var_os(RECORD_DIR_ENV)?;
+        let dir = Path::new(&dir);
+        let wide_dir = path_to_wide(dir);
+        let status = unsafe { rm_recorder_start(wide_dir.as_ptr(), 0, 0) };
         if status != RM_STATUS_OK {
-            return Err(status);
+            let message = format!(
+                "ryzenmaster-monitor: recorder start failed: {} ({})",
+                status_message(status),
+                status
+            );
+            eprintln!("{message}");
+            return None;
         }
-        Ok((temperature, power, usage))
+        println!("ryzenmaster-monitor: recording telemetry to {}", dir.display());
+        Some(RecorderGuard)
     }
 
-    fn read_telemetry_with_retries(ctx: *mut RMMonitorContext, max_attempts: u32, stop_event: Option<HANDLE>) -> Result<(f64, f64, f64), i32> {
-        let mut last_status = RM_STATUS_READ_FAILED;
-        for attempt in 1..=max_attempts {
-            match read_telemetry(ctx) {
-                Ok(values) => return Ok(values),
-                Err(status) => {
-                    last_status = status;
-                }
-            }
-            if attempt < max_attempts {
-                if wait_or_stop(stop_event, TELEMETRY_INTERVAL) {
-                    return Err(last_status);
-                }
-            }
+    fn sampler_policy() -> RMSamplerPolicy {
+        RMSamplerPolicy {
+            min_period_us: SAMPLE_MIN_INTERVAL.as_micros().min(u32::MAX as u128) as u32,
+            max_period_us: SAMPLE_MAX_INTERVAL.as_micros().min(u32::MAX as u128) as u32,
+            fast_temp_c_per_s: 2.0,
+            fast_power_w_per_s: 15.0,
+            flat_temp_c_per_s: 0.5,
+            flat_power_w_per_s: 3.0,
+            backoff_factor: 1.25,
+            // The budget raises the period to avg_read / max_sdk_duty, so the
+            // 50 ms floor is reachable while an SDK read averages under 5 ms.
+            // Fast sampling only lasts while the readings move.
+            max_sdk_duty: 0.10,
         }
-        Err(last_status)
     }
 
+    // Allows for the slowest sampler period, not the consumer's poll interval.
     fn ipc_max_age_ms() -> u32 {
-        let base = TELEMETRY_INTERVAL.as_millis().min(u32::MAX as u128) as u32;
+        let base = SAMPLE_MAX_INTERVAL.as_millis().min(u32::MAX as u128) as u32;
         base.saturating_mul(3).saturating_add(200)
     }
 
-    fn read_ipc_telemetry(max_age_ms: u32) -> Option<(f64, f64, f64)> {
-        let mut temperature = 0.0;
-        let mut power = 0.0;
-        let mut usage = 0.0;
-        let mut status = RM_STATUS_OK;
-        let result = unsafe { rm_ipc_read(&mut temperature, &mut power, &mut usage, &mut status, max_age_ms) };
-        if result != IPC_OK || status != RM_STATUS_OK {
-            return None;
-        }
-        Some((temperature, power, usage))
+    enum IpcWait {
+        Published,
+        TimedOut,
+        Unavailable,
     }
 
-    fn open_hid_device(vid: u16, pid: u16) -> Option<HidHandle> {
-        unsafe {
-            let hid_guid = HidD_GetHidGuid();
-
-            let device_info = match SetupDiGetClassDevsW(
-                Some(&hid_guid as *const _),
-                PCWSTR::null(),
-                None,
-                DIGCF_PRESENT | DIGCF_DEVICEINTERFACE,
-            ) {
-                Ok(handle) => handle,
-                Err(_) => return None,
-            };
-            if device_info.is_invalid() {
-                return None;
+    // Blocks until the producer publishes past `cursor`. The wait is bounded by
+    // TELEMETRY_INTERVAL so the caller keeps polling the stop event and SDK ownership.
+    fn wait_ipc_publish(cursor: &mut u64) -> IpcWait {
+        let timeout_ms = TELEMETRY_INTERVAL.as_millis().min(u32::MAX as u128) as u32;
+        let mut current = *cursor;
+        let result = unsafe { rm_ipc_wait(*cursor, timeout_ms, &mut current) };
+        match result {
+            IPC_OK => {
+                *cursor = current;
+                IpcWait::Published
             }
-
-            let mut interface_data = SP_DEVICE_INTERFACE_DATA::default();
-            interface_data.cbSize = std::mem::size_of::<SP_DEVICE_INTERFACE_DATA>() as u32;
-
-            let mut index = 0;
-            loop {
-                let ok = SetupDiEnumDeviceInterfaces(
-                    device_info,
-                    None,
-                    &hid_guid,
-                    index,
-                    &mut interface_data,
-                )
-                .is_ok();
-                if !ok {
-                    break;
+            IPC_TIMEOUT => {
+                // A fresh producer restarts the cursor at zero; resynchronise.
+                if current < *cursor {
+                    *cursor = current;
                 }
+                IpcWait::TimedOut
+            }
+            _ => IpcWait::Unavailable,
+        }
+    }
 
-                let mut required_size = 0u32;
-                let _ = SetupDiGetDeviceInterfaceDetailW(
-                    device_info,
-                    &interface_data,
-                    None,
-                    0,
-                    Some(&mut required_size),
-                    None,
+    // Logs the sampler's read status when it changes to a failure.
+    fn start_status_log() -> Option<HubSink> {
+        let mut last_status = RM_STATUS_OK;
+        let sink = HubSink::register(move |snapshot, _dropped| {
+            if snapshot.status != last_status && snapshot.status != RM_STATUS_OK {
+                let message = format!(
+                    "ryzenmaster-monitor: telemetry read failed: {} ({})",
+                    status_message(snapshot.status),
+                    snapshot.status
                 );
-                if required_size == 0 {
-                    index += 1;
-                    continue;
-                }
-
-                let mut buffer = vec![0u8; required_size as usize];
-                let detail = buffer.as_mut_ptr() as *mut SP_DEVICE_INTERFACE_DETAIL_DATA_W;
-                (*detail).cbSize = std::mem::size_of::<SP_DEVICE_INTERFACE_DETAIL_DATA_W>() as u32;
-
-                let ok_detail = SetupDiGetDeviceInterfaceDetailW(
-                    device_info,
-                    &interface_data,
-                    Some(detail),
-                    required_size,
-                    None,
-                    None,
-                )
-                .is_ok();
-                if !ok_detail {
-                    index += 1;
-                    continue;
-                }
-
-                let path_ptr = (*detail).DevicePath.as_ptr();
-                let handle = match CreateFileW(
-                    PCWSTR::from_raw(path_ptr),
-                    GENERIC_READ.0 | GENERIC_WRITE.0,
-                    FILE_SHARE_READ | FILE_SHARE_WRITE,
-                    None,
-                    OPEN_EXISTING,
-                    FILE_ATTRIBUTE_NORMAL,
-                    HANDLE::default(),
-                ) {
-                    Ok(handle) => handle,
-                    Err(_) => {
-                        index += 1;
-                        continue;
-                    }
-                };
-
-                let mut attributes = HIDD_ATTRIBUTES::default();
-                attributes.Size = std::mem::size_of::<HIDD_ATTRIBUTES>() as u32;
-                let matched = HidD_GetAttributes(handle, &mut attributes).as_bool();
-                if matched && attributes.VendorID == vid && attributes.ProductID == pid {
-                    let _ = SetupDiDestroyDeviceInfoList(device_info);
-                    return Some(HidHandle(handle));
-                }
+                eprintln!("{message}");
+            }
+            last_status = snapshot.status;
+        });
+        match sink {
+            Ok(sink) => Some(sink),
+            Err(status) => {
+                eprintln!(
+                    "ryzenmaster-monitor: status log sink failed: {} ({})",
+                    status_message(status),
+                    status
+                );
+                None
+            }
+        }
+    }
 
-                let _ = CloseHandle(handle);
-                index += 1;
+    // The endpoint answers from a response rendered once per published
+    // sample, so scrapes never wait on the sampler.
+    fn start_metrics() -> Option<MetricsGuard> {
+        let value = std::env::var(METRICS_PORT_ENV).ok()?;
+        let port = match value.trim().parse::<u16>() {
+            Ok(port) if port != 0 => port,
+            _ => {
+                eprintln!("ryzenmaster-monitor: ignoring {METRICS_PORT_ENV}={value}: expected a port number");
+                return None;
             }
+        };
+        let status = unsafe { rm_metrics_start(u32::from(port)) };
+        if status != RM_STATUS_OK {
+            let message = format!(
+                "ryzenmaster-monitor: metrics endpoint on port {port} failed: {} ({})",
+                status_message(status),
+                status
+            );
+            eprintln!("{message}");
+            return None;
+        }
+        println!("ryzenmaster-monitor: serving metrics on http://127.0.0.1:{port}/metrics");
+        Some(MetricsGuard)
+    }
 
-            let _ = SetupDiDestroyDeviceInfoList(device_info);
-            None
+    // The stage drives every display model it knows (src/DisplayProtocol.cpp)
+    // and keeps rescanning, so a cooler plugged in later (or unplugged and
+    // back) is picked up without a restart.
+    fn start_hid_output() -> Option<HidOutputGuard> {
+        let path = std::env::var_os(HID_OUTPUT_PATH_ENV).map(|value| path_to_wide(Path::new(&value)));
+        let config = RMHidOutputConfig {
+            vendor_id: 0,
+            product_id: 0,
+            reserved: 0,
+            path: path.as_ref().map_or(ptr::null(), |value| value.as_ptr()),
+            min_write_interval_ms: 0,
+            write_timeout_ms: 0,
+            refresh_ms: 0,
+            backoff_min_ms: 0,
+            backoff_max_ms: 0,
+            reserved2: 0,
+        };
+        let status = unsafe { rm_hid_output_start(&config) };
+        if status != RM_STATUS_OK {
+            let message = format!(
+                "ryzenmaster-monitor: USB HID output start failed: {} ({})",
+                status_message(status),
+                status
+            );
+            eprintln!("{message}");
+            return None;
         }
+        Some(HidOutputGuard)
     }
 
-    fn write_hid_packet(handle: HANDLE, payload: &[u8; HID_PACKET_SIZE]) -> bool {
-        let mut bytes_written = 0u32;
-        unsafe {
-            let ok = WriteFile(handle, Some(payload), Some(&mut bytes_written), None).is_ok();
-            ok && bytes_written as usize == payload.len()
-        }
-    }
-
-    fn init_hid_device(handle: HANDLE) -> bool {
-        let mut packet = [0u8; HID_PACKET_SIZE];
-        packet[0] = 16;
-        packet[1] = 104;
-        packet[2] = 1;
-        packet[3] = 1;
-
-        let mut init_packet = packet;
-        init_packet[4] = 2;
-        init_packet[5] = 3;
-        init_packet[6] = 1;
-        init_packet[7] = 112;
-        init_packet[8] = 22;
-        if !write_hid_packet(handle, &init_packet) {
-            return false;
-        }
-
-        init_packet[5] = 2;
-        init_packet[7] = 111;
-        write_hid_packet(handle, &init_packet)
-    }
-
-    fn send_status_packet(handle: HANDLE, temperature_c: i32, power_w: i32, usage_percent: i32) -> bool {
-        let mut packet = [0u8; HID_PACKET_SIZE];
-        packet[0] = 16;
-        packet[1] = 104;
-        packet[2] = 1;
-        packet[3] = 1;
-        packet[4] = 11;
-        packet[5] = 1;
-        packet[6] = 2;
-        packet[7] = 5;
-
-        let power_int = power_w.clamp(0, 65535) as u16;
-        packet[8] = (power_int >> 8) as u8;
-        packet[9] = (power_int & 0xFF) as u8;
-
-        packet[10] = 0;
-        let temp_bits = (temperature_c as f32).to_bits();
-        packet[11] = ((temp_bits >> 24) & 0xFF) as u8;
-        packet[12] = ((temp_bits >> 16) & 0xFF) as u8;
-        packet[13] = ((temp_bits >> 8) & 0xFF) as u8;
-        packet[14] = (temp_bits & 0xFF) as u8;
-
-        let utilization = usage_percent.clamp(0, 100) as u8;
-        packet[15] = utilization;
-
-        let mut checksum: u16 = 0;
-        for value in &packet[1..=15] {
-            checksum += *value as u16;
-        }
-        packet[16] = (checksum % 256) as u8;
-        packet[17] = 22;
-
-        write_hid_packet(handle, &packet)
+    fn report_hid_state(connected: &mut i32) {
+        let mut stats = RMHidOutputStats::default();
+        if unsafe { rm_hid_output_stats(&mut stats) } != RM_STATUS_OK || stats.running == 0 {
+            return;
+        }
+        if stats.connected == *connected {
+            return;
+        }
+        if stats.connected > *connected {
+            println!("ryzenmaster-monitor: USB HID ready ({} display(s))", stats.connected);
+        } else {
+            let message = format!(
+                "ryzenmaster-monitor: USB HID display lost ({} left, error {}), rescanning in {} ms",
+                stats.connected, stats.last_error, stats.backoff_ms
+            );
+            eprintln!("{message}");
+        }
+        *connected = stats.connected;
     }
 }
 
@@ -0,0 +1,403 @@
+// Streaming aggregator: rolling min/max/mean/EMA/percentiles per metric.
+//
+// Each window is split into kSlots time slots. A sample updates the open slot
+// (min, max, sum, count, histogram) and the window totals. When time moves to a
+// new slot, the closed slot's min and max enter monotonic deques and slots that
+// fell out of the window are subtracted from the totals. Min/max are therefore
+// exact over the slot-aligned window, and both memory and per-sample work stay
+// bounded regardless of the sampling rate.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "Aggregator.hpp"
+
+namespace {
+
+constexpr uint32_t kWindowMs[RM_AGG_WINDOW_COUNT] = { 1000, 10000, 60000, 300000 };
+constexpr uint32_t kSlots = 100;
+constexpr uint32_t kBuckets = 64;
+
+// Histogram range per metric kind; values outside it land in the end buckets.
+struct MetricRange
+{
+    double lo;
+    double hi;
+};
+
+constexpr MetricRange kTemperatureRange = { 0.0, 128.0 };
+constexpr MetricRange kPowerRange = { 0.0, 512.0 };
+constexpr MetricRange kUsageRange = { 0.0, 100.0 };
+constexpr MetricRange kFrequencyRange = { 0.0, 8192.0 };
+
+struct Slot
+{
+    double min;
+    double max;
+    double sum;
+    uint32_t count;
+    // 16-bit counts keep a slot small; a bucket that saturates stops counting
+    // (affects percentiles only).
+    uint16_t hist[kBuckets];
+};
+
+// Fixed-capacity monotonic deque of (value, slot) pairs. Keep(a, b) decides
+// whether an older entry `a` still matters once `b` has been pushed.
+template <typename Keep>
+class MonotonicDeque
+{
+public:
+    void Push(double value, uint64_t slot)
+    {
+        while (size_ && !Keep()(At(size_ - 1).value, value))
+        {
+            --size_;
+        }
+        At(size_++) = { value, slot };
+    }
+
+    void ExpireBefore(uint64_t first_live_slot)
+    {
+        while (size_ && At(0).slot < first_live_slot)
+        {
+            head_ = (head_ + 1) % kSlots;
+            --size_;
+        }
+    }
+
+    bool Front(double& value) const
+    {
+        if (!size_)
+        {
+            return false;
+        }
+        value = entries_[head_].value;
+        return true;
+    }
+
+    void Clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+private:
+    struct Entry
+    {
+        double value;
+        uint64_t slot;
+    };
+
+    Entry& At(uint32_t index)
+    {
+        return entries_[(head_ + index) % kSlots];
+    }
+
+    Entry entries_[kSlots];
+    uint32_t head_ = 0;
+    uint32_t size_ = 0;
+};
+
+struct KeepSmaller
+{
+    bool operator()(double older, double newer) const { return older < newer; }
+};
+
+struct KeepLarger
+{
+    bool operator()(double older, double newer) const { return older > newer; }
+};
+
+struct RollingWindow
+{
+    Slot slots[kSlots];
+    MonotonicDeque<KeepSmaller> min_queue;
+    MonotonicDeque<KeepLarger> max_queue;
+    uint32_t hist[kBuckets];
+    double sum;
+    uint64_t count;
+    uint64_t open_slot;
+    uint64_t oldest_slot;
+    bool has_open;
+    double ema;
+    bool has_ema;
+};
+
+struct Metric
+{
+    MetricRange range;
+    RollingWindow windows[RM_AGG_WINDOW_COUNT];
+};
+
+uint32_t BucketOf(double value, const MetricRange& range)
+{
+    const double scaled = (value - range.lo) * kBuckets / (range.hi - range.lo);
+    if (!(scaled > 0.0))
+    {
+        return 0;
+    }
+    return std::min(static_cast<uint32_t>(scaled), kBuckets - 1);
+}
+
+void ExpireSlot(RollingWindow& window, Slot& slot)
+{
+    if (slot.count)
+    {
+        for (uint32_t b = 0; b < kBuckets; ++b)
+        {
+            window.hist[b] -= slot.hist[b];
+        }
+        window.sum -= slot.sum;
+        window.count -= slot.count;
+    }
+    memset(&slot, 0, sizeof(slot));
+}
+
+// Closes the open slot and drops everything older than the window ending at `slot_id`.
+void AdvanceTo(RollingWindow& window, uint64_t slot_id)
+{
+    if (!window.has_open)
+    {
+        window.open_slot = slot_id;
+        window.oldest_slot = slot_id;
+        window.has_open = true;
+        return;
+    }
+    if (slot_id == window.open_slot)
+    {
+        return;
+    }
+
+    const Slot& closed = window.slots[window.open_slot % kSlots];
+    if (closed.count)
+    {
+        window.min_queue.Push(closed.min, window.open_slot);
+        window.max_queue.Push(closed.max, window.open_slot);
+    }
+
+    const uint64_t first_live = slot_id >= kSlots ? slot_id - kSlots + 1 : 0;
+    for (uint64_t s = window.oldest_slot; s < first_live && s <= window.open_slot; ++s)
+    {
+        ExpireSlot(window, window.slots[s % kSlots]);
+    }
+    window.oldest_slot = std::max(window.oldest_slot, first_live);
+    window.min_queue.ExpireBefore(first_live);
+    window.max_queue.ExpireBefore(first_live);
+    window.open_slot = slot_id;
+}
+
+void AddValue(RollingWindow& window, const MetricRange& range, double value, double alpha)
+{
+    Slot& slot = window.slots[window.open_slot % kSlots];
+    if (!slot.count)
+    {
+        slot.min = value;
+        slot.max = value;
+    }
+    else
+    {
+        slot.min = std::min(slot.min, value);
+        slot.max = std::max(slot.max, value);
+    }
+    slot.sum += value;
+    slot.count++;
+    window.sum += value;
+    window.count++;
+
+    const uint32_t bucket = BucketOf(value, range);
+    if (slot.hist[bucket] != UINT16_MAX)
+    {
+        slot.hist[bucket]++;
+        window.hist[bucket]++;
+    }
+
+    window.ema = window.has_ema ? window.ema + alpha * (value - window.ema) : value;
+    window.has_ema = true;
+}
+
+double Percentile(const RollingWindow& window, const MetricRange& range, double quantile)
+{
+    const double width = (range.hi - range.lo) / kBuckets;
+    double total = 0.0;
+    for (uint32_t b = 0; b < kBuckets; ++b)
+    {
+        total += window.hist[b];
+    }
+    const double target = quantile * total;
+    double cumulative = 0.0;
+    for (uint32_t b = 0; b < kBuckets; ++b)
+    {
+        const double in_bucket = window.hist[b];
+        if (in_bucket > 0.0 && cumulative + in_bucket >= target)
+        {
+            const double fraction = (target - cumulative) / in_bucket;
+            return range.lo + (b + fraction) * width;
+        }
+        cumulative += in_bucket;
+    }
+    return range.hi;
+}
+
+void FillAggregate(const RollingWindow& window, const MetricRange& range, RMAggregate& out)
+{
+    out = {};
+    if (!window.count)
+    {
+        return;
+    }
+
+    const Slot& open = window.slots[window.open_slot % kSlots];
+    double min = 0.0;
+    double max = 0.0;
+    const bool has_closed_min = window.min_queue.Front(min);
+    const bool has_closed_max = window.max_queue.Front(max);
+    if (open.count)
+    {
+        min = has_closed_min ? std::min(min, open.min) : open.min;
+        max = has_closed_max ? std::max(max, open.max) : open.max;
+    }
+
+    out.min = min;
+    out.max = max;
+    out.mean = window.sum / static_cast<double>(window.count);
+    out.ema = window.ema;
+    // Bucket interpolation can overshoot the observed extremes.
+    out.p50 = std::clamp(Percentile(window, range, 0.50), min, max);
+    out.p90 = std::clamp(Percentile(window, range, 0.90), min, max);
+    out.p99 = std::clamp(Percentile(window, range, 0.99), min, max);
+    out.count = static_cast<uint32_t>(std::min<uint64_t>(window.count, UINT32_MAX));
+}
+
+enum MetricIndex : uint32_t
+{
+    kMetricTemperature,
+    kMetricPower,
+    kMetricUsage,
+    kMetricFirstCore
+};
+
+} // namespace
+
+struct StreamingAggregator::State
+{
+    std::vector<Metric> metrics;
+    uint32_t core_count = 0;
+    uint64_t last_timestamp_ms = 0;
+    bool has_sample = false;
+};
+
+StreamingAggregator::StreamingAggregator() = default;
+
+StreamingAggregator::~StreamingAggregator() = default;
+
+void StreamingAggregator::Reset()
+{
+    state_.reset();
+}
+
+bool StreamingAggregator::Add(const RMCpuSnapshot& snapshot, uint64_t timestamp_ms)
+{
+    if (snapshot.status != RM_STATUS_OK)
+    {
+        return false;
+    }
+
+    const double* core_freq = nullptr;
+    if (snapshot.core_fields & RM_CORE_FIELD_FREQ)
+    {
+        core_freq = snapshot.core_freq_mhz;
+    }
+    else if (snapshot.core_fields & RM_CORE_FIELD_CURRENT_FREQ)
+    {
+        core_freq = snapshot.core_current_freq_mhz;
+    }
+    const uint32_t core_count = core_freq ? std::min<uint32_t>(snapshot.core_count, RM_MAX_CORES) : 0;
+
+    if (state_ && (state_->core_count != core_count || (state_->has_sample && timestamp_ms < state_->last_timestamp_ms)))
+    {
+        state_.reset();
+    }
+    if (!state_)
+    {
+        // Sized once per core count; all-zero windows are the empty state.
+        try
+        {
+            std::unique_ptr<State> state(new State());
+            state->metrics.resize(kMetricFirstCore + core_count);
+            state->core_count = core_count;
+            state->metrics[kMetricTemperature].range = kTemperatureRange;
+            state->metrics[kMetricPower].range = kPowerRange;
+            state->metrics[kMetricUsage].range = kUsageRange;
+            for (uint32_t core = 0; core < core_count; ++core)
+            {
+                state->metrics[kMetricFirstCore + core].range = kFrequencyRange;
+            }
+            state_ = std::move(state);
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    State& state = *state_;
+    const double elapsed_ms = state.has_sample ? static_cast<double>(timestamp_ms - state.last_timestamp_ms) : 0.0;
+    state.last_timestamp_ms = timestamp_ms;
+    state.has_sample = true;
+
+    for (uint32_t w = 0; w < RM_AGG_WINDOW_COUNT; ++w)
+    {
+        const uint64_t slot_id = timestamp_ms / (kWindowMs[w] / kSlots);
+        const double alpha = 1.0 - std::exp(-elapsed_ms / kWindowMs[w]);
+        const auto add = [&](Metric& metric, double value)
+        {
+            if (!std::isfinite(value))
+            {
+                return;
+            }
+            RollingWindow& window = metric.windows[w];
+            AdvanceTo(window, slot_id);
+            AddValue(window, metric.range, value, alpha);
+        };
+
+        add(state.metrics[kMetricTemperature], snapshot.temperature_c);
+        add(state.metrics[kMetricPower], snapshot.power_w);
+        add(state.metrics[kMetricUsage], snapshot.usage_percent);
+        for (uint32_t core = 0; core < core_count; ++core)
+        {
+            add(state.metrics[kMetricFirstCore + core], core_freq[core]);
+        }
+    }
+    return true;
+}
+
+void StreamingAggregator::Fill(RMAggregateSnapshot& out) const
+{
+    out.timestamp_ms = state_ ? state_->last_timestamp_ms : 0;
+    for (uint32_t w = 0; w < RM_AGG_WINDOW_COUNT; ++w)
+    {
+        RMAggregateWindow& window = out.windows[w];
+        window.window_ms = kWindowMs[w];
+        window.core_count = state_ ? state_->core_count : 0;
+        if (!state_)
+        {
+            window.temperature_c = {};
+            window.power_w = {};
+            window.usage_percent = {};
+            continue;
+        }
+
+        const std::vector<Metric>& metrics = state_->metrics;
+        FillAggregate(metrics[kMetricTemperature].windows[w], metrics[kMetricTemperature].range, window.temperature_c);
+        FillAggregate(metrics[kMetricPower].windows[w], metrics[kMetricPower].range, window.power_w);
+        FillAggregate(metrics[kMetricUsage].windows[w], metrics[kMetricUsage].range, window.usage_percent);
+        for (uint32_t core = 0; core < state_->core_count; ++core)
+        {
+            const Metric& metric = metrics[kMetricFirstCore + core];
+            FillAggregate(metric.windows[w], metric.range, window.core_freq_mhz[core]);
+        }
+    }
+}
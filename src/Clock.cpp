@@ -0,0 +1,80 @@
+// QPC clock helpers and latency summaries (inc/Clock.hpp).
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+
+#include "Clock.hpp"
+
+namespace {
+
+// value * to / from, split so the product stays within 64 bits: the remainder
+// is below `from`, and QPC frequencies are far below 2^64 / 10^9.
+uint64_t Rescale(uint64_t value, uint64_t from, uint64_t to)
+{
+    return value / from * to + value % from * to / from;
+}
+
+} // namespace
+
+LONGLONG QpcFrequency()
+{
+    static const LONGLONG s_frequency = []()
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return frequency.QuadPart;
+    }();
+    return s_frequency;
+}
+
+LONGLONG QpcNow()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+uint64_t QpcToMicroseconds(LONGLONG ticks)
+{
+    return ticks > 0 ? Rescale(static_cast<uint64_t>(ticks), static_cast<uint64_t>(QpcFrequency()), 1000000) : 0;
+}
+
+uint64_t QpcToNanoseconds(LONGLONG ticks)
+{
+    return ticks > 0 ? Rescale(static_cast<uint64_t>(ticks), static_cast<uint64_t>(QpcFrequency()), 1000000000) : 0;
+}
+
+uint64_t QpcTo100ns(LONGLONG ticks)
+{
+    return ticks > 0 ? Rescale(static_cast<uint64_t>(ticks), static_cast<uint64_t>(QpcFrequency()), 10000000) : 0;
+}
+
+LONGLONG MicrosecondsToQpc(uint64_t us)
+{
+    return static_cast<LONGLONG>(Rescale(us, 1000000, static_cast<uint64_t>(QpcFrequency())));
+}
+
+RMLatencyPercentiles SummarizeLatencies(std::vector<uint64_t>& samples)
+{
+    RMLatencyPercentiles result{};
+    if (samples.empty())
+    {
+        return result;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&samples](double quantile)
+    {
+        size_t index = static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    result.p50_ns = at(0.50);
+    result.p90_ns = at(0.90);
+    result.p99_ns = at(0.99);
+    result.p999_ns = at(0.999);
+    result.max_ns = samples.back();
+    return result;
+}
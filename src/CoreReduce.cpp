@@ -0,0 +1,471 @@
+// Fused per-core reductions with SSE2, AVX2 and AVX-512 kernels chosen at run
+// time, plus a scalar fallback.
+//
+// Every kernel makes the same single pass: the frequency array yields the
+// active-core mask, and residency, frequency and temperature statistics are
+// accumulated in vector lanes under that mask. Lanes are folded once at the
+// end, except the per-group sums, which are folded at the end of each group.
+// Cores left over after a group's last full vector go through the scalar loop. The intrinsics need no /arch switch, so
+// the wider kernels are only called after CPUID and XGETBV confirm the CPU and
+// OS support them.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "Clock.hpp"
+#include "CoreReduce.hpp"
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Running totals over a range of cores.
+struct Partial
+{
+    uint32_t active;
+    double residency_sum;
+    double residency_max;
+    double freq_min;
+    double freq_max;
+    double freq_sum;
+    double freq_residency_sum;
+    double temp_max;
+};
+
+void InitPartial(Partial& p)
+{
+    p = { 0, 0.0, 0.0, kInf, -kInf, 0.0, 0.0, 0.0 };
+}
+
+void MergePartial(Partial& into, const Partial& p)
+{
+    into.active += p.active;
+    into.residency_sum += p.residency_sum;
+    into.residency_max = std::max(into.residency_max, p.residency_max);
+    into.freq_min = std::min(into.freq_min, p.freq_min);
+    into.freq_max = std::max(into.freq_max, p.freq_max);
+    into.freq_sum += p.freq_sum;
+    into.freq_residency_sum += p.freq_residency_sum;
+    into.temp_max = std::max(into.temp_max, p.temp_max);
+}
+
+// Reference semantics for every kernel. NaN readings never become a max or
+// min, as with the original scalar loops.
+void ScalarRange(const CoreArrays& in, uint32_t begin, uint32_t end, Partial& p)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        if (in.temp && in.temp[i] > p.temp_max)
+        {
+            p.temp_max = in.temp[i];
+        }
+        if (in.freq && in.freq[i] == 0.0)
+        {
+            continue;
+        }
+
+        p.active++;
+        const double r = in.residency ? in.residency[i] : 0.0;
+        if (in.residency)
+        {
+            p.residency_sum += r;
+            p.residency_max = std::max(p.residency_max, r);
+        }
+        if (in.freq)
+        {
+            const double f = in.freq[i];
+            p.freq_min = std::min(p.freq_min, f);
+            p.freq_max = std::max(p.freq_max, f);
+            p.freq_sum += f;
+            p.freq_residency_sum += f * r;
+        }
+    }
+}
+
+// Lane operations for VectorReduce. Min/Max take the new value first: the
+// instructions return their second operand when either is NaN, which keeps
+// the accumulator.
+struct Sse2
+{
+    using Reg = __m128d;
+    using Mask = __m128d;
+    static constexpr uint32_t kLanes = 2;
+
+    static Reg Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, Reg v) { _mm_storeu_pd(p, v); }
+    static Reg Set(double v) { return _mm_set1_pd(v); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_pd(a, b); }
+    static Reg Min(Reg value, Reg acc) { return _mm_min_pd(value, acc); }
+    static Reg Max(Reg value, Reg acc) { return _mm_max_pd(value, acc); }
+    static Mask AllActive() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+    static Mask NonZero(Reg v) { return _mm_cmpneq_pd(v, _mm_setzero_pd()); }
+    static uint32_t Count(Mask m) { return std::popcount(static_cast<unsigned>(_mm_movemask_pd(m))); }
+    static Reg Keep(Mask m, Reg v) { return _mm_and_pd(m, v); }
+    static Reg Select(Mask m, Reg v, Reg other) { return _mm_or_pd(_mm_and_pd(m, v), _mm_andnot_pd(m, other)); }
+    static void Leave() {}
+};
+
+struct Avx2
+{
+    using Reg = __m256d;
+    using Mask = __m256d;
+    static constexpr uint32_t kLanes = 4;
+
+    static Reg Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+    static Reg Set(double v) { return _mm256_set1_pd(v); }
+    static Reg Add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+    static Reg Min(Reg value, Reg acc) { return _mm256_min_pd(value, acc); }
+    static Reg Max(Reg value, Reg acc) { return _mm256_max_pd(value, acc); }
+    static Mask AllActive() { return _mm256_castsi256_pd(_mm256_set1_epi32(-1)); }
+    static Mask NonZero(Reg v) { return _mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_NEQ_UQ); }
+    static uint32_t Count(Mask m) { return std::popcount(static_cast<unsigned>(_mm256_movemask_pd(m))); }
+    static Reg Keep(Mask m, Reg v) { return _mm256_and_pd(m, v); }
+    static Reg Select(Mask m, Reg v, Reg other) { return _mm256_blendv_pd(other, v, m); }
+    static void Leave() { _mm256_zeroupper(); }
+};
+
+struct Avx512
+{
+    using Reg = __m512d;
+    using Mask = __mmask8;
+    static constexpr uint32_t kLanes = 8;
+
+    static Reg Load(const double* p) { return _mm512_loadu_pd(p); }
+    static void Store(double* p, Reg v) { _mm512_storeu_pd(p, v); }
+    static Reg Set(double v) { return _mm512_set1_pd(v); }
+    static Reg Add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+    static Reg Min(Reg value, Reg acc) { return _mm512_min_pd(value, acc); }
+    static Reg Max(Reg value, Reg acc) { return _mm512_max_pd(value, acc); }
+    static Mask AllActive() { return static_cast<Mask>(0xFF); }
+    static Mask NonZero(Reg v) { return _mm512_cmp_pd_mask(v, _mm512_setzero_pd(), _CMP_NEQ_UQ); }
+    static uint32_t Count(Mask m) { return std::popcount(static_cast<unsigned>(m)); }
+    static Reg Keep(Mask m, Reg v) { return _mm512_maskz_mov_pd(m, v); }
+    static Reg Select(Mask m, Reg v, Reg other) { return _mm512_mask_blend_pd(m, other, v); }
+    static void Leave() { _mm256_zeroupper(); }
+};
+
+template <typename V, typename Fold>
+double FoldLanes(typename V::Reg v, double acc, Fold fold)
+{
+    alignas(64) double lanes[V::kLanes];
+    V::Store(lanes, v);
+    for (uint32_t i = 0; i < V::kLanes; ++i)
+    {
+        acc = fold(acc, lanes[i]);
+    }
+    return acc;
+}
+
+double Sum(double a, double b) { return a + b; }
+double Min(double a, double b) { return std::min(a, b); }
+double Max(double a, double b) { return std::max(a, b); }
+
+// Groups are `group` consecutive cores; group sums are written only when an
+// output array is given. A group that is not a multiple of the vector width
+// leaves a few cores to the scalar loop.
+void ScalarReduce(const CoreArrays& in, uint32_t group, double* group_residency, double* group_freq, Partial& total)
+{
+    for (uint32_t begin = 0, g = 0; begin < in.count; ++g)
+    {
+        const uint32_t end = begin + std::min(group, in.count - begin);
+        Partial part;
+        InitPartial(part);
+        ScalarRange(in, begin, end, part);
+        if (group_residency)
+        {
+            group_residency[g] = part.residency_sum;
+        }
+        if (group_freq)
+        {
+            group_freq[g] = part.freq_sum;
+        }
+        MergePartial(total, part);
+        begin = end;
+    }
+}
+
+template <typename V>
+void VectorReduce(const CoreArrays& in, uint32_t group, double* group_residency, double* group_freq, Partial& total)
+{
+    using Reg = typename V::Reg;
+    using Mask = typename V::Mask;
+
+    const Reg zero = V::Set(0.0);
+    const Reg pos_inf = V::Set(kInf);
+    const Reg neg_inf = V::Set(-kInf);
+    Reg residency_sum = zero;
+    Reg residency_max = zero;
+    Reg freq_min = pos_inf;
+    Reg freq_max = neg_inf;
+    Reg freq_sum = zero;
+    Reg freq_residency_sum = zero;
+    Reg temp_max = zero;
+    uint32_t active = 0;
+
+    for (uint32_t begin = 0, g = 0; begin < in.count; ++g)
+    {
+        const uint32_t end = begin + std::min(group, in.count - begin);
+        Reg group_residency_sum = zero;
+        Reg group_freq_sum = zero;
+
+        uint32_t i = begin;
+        for (; end - i >= V::kLanes; i += V::kLanes)
+        {
+            if (in.temp)
+            {
+                temp_max = V::Max(V::Load(in.temp + i), temp_max);
+            }
+
+            Mask mask = V::AllActive();
+            Reg freq = zero;
+            if (in.freq)
+            {
+                freq = V::Load(in.freq + i);
+                mask = V::NonZero(freq);
+            }
+            active += V::Count(mask);
+
+            Reg residency = zero;
+            if (in.residency)
+            {
+                residency = V::Keep(mask, V::Load(in.residency + i));
+                residency_sum = V::Add(residency_sum, residency);
+                residency_max = V::Max(residency, residency_max);
+                group_residency_sum = V::Add(group_residency_sum, residency);
+            }
+            if (in.freq)
+            {
+                freq_min = V::Min(V::Select(mask, freq, pos_inf), freq_min);
+                freq_max = V::Max(V::Select(mask, freq, neg_inf), freq_max);
+                const Reg active_freq = V::Keep(mask, freq);
+                freq_sum = V::Add(freq_sum, active_freq);
+                freq_residency_sum = V::Add(freq_residency_sum, V::Mul(active_freq, residency));
+                group_freq_sum = V::Add(group_freq_sum, active_freq);
+            }
+        }
+
+        Partial tail;
+        InitPartial(tail);
+        ScalarRange(in, i, end, tail);
+        if (group_residency)
+        {
+            group_residency[g] = FoldLanes<V>(group_residency_sum, tail.residency_sum, Sum);
+        }
+        if (group_freq)
+        {
+            group_freq[g] = FoldLanes<V>(group_freq_sum, tail.freq_sum, Sum);
+        }
+        MergePartial(total, tail);
+        begin = end;
+    }
+
+    total.active += active;
+    total.residency_sum = FoldLanes<V>(residency_sum, total.residency_sum, Sum);
+    total.residency_max = FoldLanes<V>(residency_max, total.residency_max, Max);
+    total.freq_min = FoldLanes<V>(freq_min, total.freq_min, Min);
+    total.freq_max = FoldLanes<V>(freq_max, total.freq_max, Max);
+    total.freq_sum = FoldLanes<V>(freq_sum, total.freq_sum, Sum);
+    total.freq_residency_sum = FoldLanes<V>(freq_residency_sum, total.freq_residency_sum, Sum);
+    total.temp_max = FoldLanes<V>(temp_max, total.temp_max, Max);
+    V::Leave();
+}
+
+using ReduceFn = void (*)(const CoreArrays&, uint32_t, double*, double*, Partial&);
+
+constexpr ReduceFn kReduceFns[] = {
+    ScalarReduce,
+    VectorReduce<Sse2>,
+    VectorReduce<Avx2>,
+    VectorReduce<Avx512>,
+};
+
+ReduceIsa DetectReduceIsa()
+{
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!sse2)
+    {
+        return kReduceScalar;
+    }
+    if (!osxsave || !avx || max_leaf < 7)
+    {
+        return kReduceSse2;
+    }
+
+    // The OS must save YMM (XCR0 bits 1-2) and, for AVX-512, opmask and ZMM
+    // state (bits 5-7) on context switches.
+    const unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return kReduceSse2;
+    }
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (avx512f && (xcr0 & 0xE6) == 0xE6)
+    {
+        return kReduceAvx512;
+    }
+    return avx2 ? kReduceAvx2 : kReduceSse2;
+}
+
+// Keeps the benchmark loop from being optimized away.
+volatile double g_bench_sink = 0.0;
+
+} // namespace
+
+ReduceIsa GetReduceIsa()
+{
+    static const ReduceIsa s_isa = DetectReduceIsa();
+    return s_isa;
+}
+
+void ReduceCoreArraysWith(ReduceIsa isa, const CoreArrays& in, CoreReduction& out,
+    uint32_t group_size, double* group_residency, double* group_freq)
+{
+    const bool grouped = group_size && (group_residency || group_freq);
+    Partial total;
+    InitPartial(total);
+    kReduceFns[isa](in, grouped ? group_size : in.count, group_residency, group_freq, total);
+
+    const bool has_freq = in.freq && total.active;
+    out.active_count = total.active;
+    out.residency_sum = total.residency_sum;
+    out.residency_max = total.residency_max;
+    out.freq_min = has_freq ? total.freq_min : 0.0;
+    out.freq_max = has_freq ? total.freq_max : 0.0;
+    out.freq_sum = total.freq_sum;
+    out.freq_residency_sum = total.freq_residency_sum;
+    out.temp_max = total.temp_max;
+}
+
+void ReduceCoreArrays(const CoreArrays& in, CoreReduction& out,
+    uint32_t group_size, double* group_residency, double* group_freq)
+{
+    ReduceCoreArraysWith(GetReduceIsa(), in, out, group_size, group_residency, group_freq);
+}
+
+void ApplyCoreSummary(const CoreReduction& cores, bool has_freq, RMCpuSnapshot& snapshot)
+{
+    snapshot.active_core_count = cores.active_count;
+    snapshot.core_freq_min_mhz = cores.freq_min;
+    snapshot.core_freq_max_mhz = cores.freq_max;
+    snapshot.core_freq_mean_mhz = has_freq && cores.active_count ? cores.freq_sum / cores.active_count : 0.0;
+    snapshot.core_freq_weighted_mhz = cores.residency_sum > 0.0 ? cores.freq_residency_sum / cores.residency_sum : 0.0;
+    snapshot.core_temp_max_c = cores.temp_max;
+}
+
+void SummarizeSnapshotCores(RMCpuSnapshot& snapshot)
+{
+    CoreArrays arrays = {};
+    arrays.count = std::min<uint32_t>(snapshot.core_count, RM_MAX_CORES);
+    if (snapshot.core_fields & RM_CORE_FIELD_CURRENT_FREQ)
+    {
+        arrays.freq = snapshot.core_current_freq_mhz;
+    }
+    else if (snapshot.core_fields & RM_CORE_FIELD_FREQ)
+    {
+        arrays.freq = snapshot.core_freq_mhz;
+    }
+    if (snapshot.core_fields & RM_CORE_FIELD_RESIDENCY)
+    {
+        arrays.residency = snapshot.core_residency;
+    }
+    if (snapshot.core_fields & RM_CORE_FIELD_TEMP)
+    {
+        arrays.temp = snapshot.core_temp_c;
+    }
+
+    CoreReduction cores;
+    ReduceCoreArrays(arrays, cores);
+    ApplyCoreSummary(cores, arrays.freq != nullptr, snapshot);
+}
+
+// Times ReduceCoreArraysWith over synthetic arrays (a mix of idle and loaded
+// cores, grouped 8 per CCD) so the kernels can be compared on a given machine.
+extern "C" int rm_reduce_bench(unsigned int core_count, unsigned int iterations, int isa, RMReduceBenchStats* stats)
+{
+    if (!stats || core_count == 0 || core_count > RM_MAX_CORES || iterations == 0)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    const ReduceIsa best = GetReduceIsa();
+    if (isa == RM_REDUCE_ISA_AUTO)
+    {
+        isa = best;
+    }
+    if (isa < RM_REDUCE_ISA_SCALAR || isa > best)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    constexpr uint32_t kGroupSize = 8;
+    std::vector<double> freq;
+    std::vector<double> residency;
+    std::vector<double> temp;
+    std::vector<double> group_residency;
+    std::vector<double> group_freq;
+    try
+    {
+        freq.resize(core_count);
+        residency.resize(core_count);
+        temp.resize(core_count);
+        group_residency.resize((core_count + kGroupSize - 1) / kGroupSize);
+        group_freq.resize(group_residency.size());
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    for (unsigned int i = 0; i < core_count; ++i)
+    {
+        const bool idle = (i * 7 % 5) == 0;
+        freq[i] = idle ? 0.0 : 3000.0 + (i * 37 % 2200);
+        residency[i] = idle ? 0.0 : 5.0 + (i * 13 % 95);
+        temp[i] = 45.0 + (i * 11 % 40);
+    }
+
+    const CoreArrays arrays = { freq.data(), residency.data(), temp.data(), core_count };
+    CoreReduction result = {};
+    double checksum = 0.0;
+
+    const LONGLONG start = QpcNow();
+    for (unsigned int n = 0; n < iterations; ++n)
+    {
+        ReduceCoreArraysWith(static_cast<ReduceIsa>(isa), arrays, result, kGroupSize,
+            group_residency.data(), group_freq.data());
+        checksum += result.freq_sum + group_residency[0];
+    }
+    const double elapsed_ns = static_cast<double>(QpcToNanoseconds(QpcNow() - start));
+
+    g_bench_sink = checksum;
+
+    stats->isa = isa;
+    stats->core_count = core_count;
+    stats->iterations = iterations;
+    stats->ns_per_call = elapsed_ns / iterations;
+    stats->cores_per_us = stats->ns_per_call > 0.0 ? core_count * 1000.0 / stats->ns_per_call : 0.0;
+    return RM_STATUS_OK;
+}
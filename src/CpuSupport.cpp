@@ -0,0 +1,240 @@
+// Supported-processor table. Each package lists the raw CPUID 0x80000001 EAX
+// values the Monitoring SDK accepts in it; the lists are merged at compile
+// time into one sorted array of (package, signature) keys, so a lookup is a
+// binary search. Generations are a second sorted table keyed by family and
+// model range.
+//
+// Package types share values across sockets: FP5 and AM5 are both 0, FP7,
+// FL1 and FP8 are 1, AM4 and FP7r2 are 2, SP3 and FP7 B0 are 4. The lists
+// below are per value, named after the first package.
+//
+// The static_asserts at the end double as the table's tests: they run the
+// lookup on made-up CPUID values at compile time.
+
+#include <intrin.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include "CpuSupport.hpp"
+
+namespace {
+
+constexpr uint32_t kPackageFP5 = 0;         // also AM5
+constexpr uint32_t kPackageFP7 = 1;         // also FL1, FP8
+constexpr uint32_t kPackageAM4 = 2;         // also FP7r2
+constexpr uint32_t kPackageSP3 = 4;         // also FP7 B0
+constexpr uint32_t kPackageFP7R2_B0 = 5;
+constexpr uint32_t kPackageSP3r2 = 7;
+constexpr uint32_t kPackageSP6 = 8;
+
+constexpr uint32_t kFP5Signatures[] = {
+    0x00810F80, 0x00810F81, 0x00860F00, 0x00860F01, 0x00860F81,
+    0x00A50F00, 0x00A50F01,
+    0x00A60F00, 0x00A60F01, 0x00A60F10, 0x00A60F11, 0x00A60F12, 0x00A60F13,
+    0x00A70F52, 0x00A70F80,
+    0x00B40F40, 0x00B40F41,
+};
+
+// AM4 and FP7R2 B0 share this list; it includes the FP7r2 parts.
+constexpr uint32_t kAM4Signatures[] = {
+    0x00800F00, 0x00800F10, 0x00800F11, 0x00800F12,
+    0x00800F82, 0x00800F83,
+    0x00810F10, 0x00810F11, 0x00810F80, 0x00810F81,
+    0x00860F00, 0x00860F01,
+    0x00870F00, 0x00870F10,
+    0x00A20F00, 0x00A20F10, 0x00A20F12,
+    0x00A40F00, 0x00A40F40, 0x00A40F41,
+    0x00A50F00, 0x00A50F01,
+    0x00A70F00, 0x00A70F40, 0x00A70F41, 0x00A70F42, 0x00A70F52, 0x00A70F80, 0x00A70FC0,
+};
+
+constexpr uint32_t kSP3r2Signatures[] = {
+    0x00800F10, 0x00800F11, 0x00800F12,
+    0x00800F82, 0x00800F83,
+    0x00830F00, 0x00830F10,
+    0x00B00F11, 0x00B00F80, 0x00B00F81,
+};
+
+// FP7 and SP3 share this list.
+constexpr uint32_t kFP7Signatures[] = {
+    0x00A00F80, 0x00A00F82,
+    0x00A40F00, 0x00A40F40, 0x00A40F41,
+    0x00A60F11, 0x00A60F12,
+    0x00A70F00, 0x00A70F40, 0x00A70F41, 0x00A70F42, 0x00A70F52, 0x00A70F80, 0x00A70FC0,
+    0x00B20F40,
+    0x00B40F40,
+    0x00B60F00,     // Krackan Point
+    0x00B60F80,     // Krackan Point 2
+    0x00B70F00,     // Strix Halo (FP11)
+};
+
+constexpr uint32_t kSP6Signatures[] = {
+    0x00A10F80, 0x00A10F81,
+};
+
+constexpr uint64_t Key(uint32_t package_type, uint32_t signature)
+{
+    return (static_cast<uint64_t>(package_type) << 32) | signature;
+}
+
+template <size_t N>
+constexpr size_t Append(uint64_t* keys, size_t count, uint32_t package_type, const uint32_t (&signatures)[N])
+{
+    for (uint32_t signature : signatures)
+    {
+        keys[count++] = Key(package_type, signature);
+    }
+    return count;
+}
+
+constexpr size_t kSupportedCount = std::size(kFP5Signatures) + 2 * std::size(kAM4Signatures) +
+    std::size(kSP3r2Signatures) + 2 * std::size(kFP7Signatures) + std::size(kSP6Signatures);
+
+constexpr std::array<uint64_t, kSupportedCount> kSupported = []()
+{
+    std::array<uint64_t, kSupportedCount> keys = {};
+    size_t count = 0;
+    count = Append(keys.data(), count, kPackageFP5, kFP5Signatures);
+    count = Append(keys.data(), count, kPackageAM4, kAM4Signatures);
+    count = Append(keys.data(), count, kPackageFP7R2_B0, kAM4Signatures);
+    count = Append(keys.data(), count, kPackageSP3r2, kSP3r2Signatures);
+    count = Append(keys.data(), count, kPackageFP7, kFP7Signatures);
+    count = Append(keys.data(), count, kPackageSP3, kFP7Signatures);
+    count = Append(keys.data(), count, kPackageSP6, kSP6Signatures);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}();
+
+static_assert(std::adjacent_find(kSupported.begin(), kSupported.end()) == kSupported.end(),
+    "a signature is listed twice for one package");
+
+// Sorted by family, then model.
+constexpr CpuGeneration kGenerations[] = {
+    { "Summit Ridge", "Zen", 0x17, 0x00, 0x07, 4, 2 },
+    { "Pinnacle Ridge", "Zen+", 0x17, 0x08, 0x0F, 4, 2 },
+    { "Raven Ridge", "Zen", 0x17, 0x10, 0x17, 4, 1 },
+    { "Picasso", "Zen+", 0x17, 0x18, 0x1F, 4, 1 },
+    { "Castle Peak", "Zen 2", 0x17, 0x30, 0x3F, 4, 2 },
+    { "Renoir", "Zen 2", 0x17, 0x60, 0x67, 4, 2 },
+    { "Lucienne", "Zen 2", 0x17, 0x68, 0x6F, 4, 2 },
+    { "Matisse", "Zen 2", 0x17, 0x70, 0x7F, 4, 2 },
+    { "Chagall", "Zen 3", 0x19, 0x08, 0x0F, 8, 1 },
+    { "Storm Peak", "Zen 4", 0x19, 0x18, 0x1F, 8, 1 },
+    { "Vermeer", "Zen 3", 0x19, 0x20, 0x2F, 8, 1 },
+    { "Rembrandt", "Zen 3+", 0x19, 0x40, 0x4F, 8, 1 },
+    { "Cezanne", "Zen 3", 0x19, 0x50, 0x5F, 8, 1 },
+    { "Raphael", "Zen 4", 0x19, 0x60, 0x6F, 8, 1 },
+    { "Phoenix", "Zen 4", 0x19, 0x70, 0x77, 8, 1 },
+    { "Phoenix 2", "Zen 4", 0x19, 0x78, 0x7B, 0, 1 },
+    { "Hawk Point 2", "Zen 4", 0x19, 0x7C, 0x7F, 8, 1 },
+    { "Shimada Peak", "Zen 5", 0x1A, 0x00, 0x0F, 8, 1 },
+    { "Strix Point", "Zen 5", 0x1A, 0x20, 0x2F, 0, 1 },
+    { "Granite Ridge", "Zen 5", 0x1A, 0x40, 0x4F, 8, 1 },
+    { "Krackan Point", "Zen 5", 0x1A, 0x60, 0x67, 0, 1 },
+    { "Krackan Point 2", "Zen 5", 0x1A, 0x68, 0x6F, 0, 1 },
+    { "Strix Halo", "Zen 5", 0x1A, 0x70, 0x7F, 8, 1 },
+};
+
+constexpr bool GenerationsSorted()
+{
+    for (size_t i = 1; i < std::size(kGenerations); ++i)
+    {
+        const CpuGeneration& a = kGenerations[i - 1];
+        const CpuGeneration& b = kGenerations[i];
+        if (a.model_first > a.model_last || (a.family == b.family ? a.model_last >= b.model_first : a.family > b.family))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(GenerationsSorted(), "generations must be sorted and must not overlap");
+
+constexpr const CpuGeneration* FindGeneration(uint32_t family, uint32_t model)
+{
+    const CpuGeneration* next = std::upper_bound(std::begin(kGenerations), std::end(kGenerations), family << 8 | model,
+        [](uint32_t value, const CpuGeneration& generation) { return value < (generation.family << 8 | generation.model_first); });
+    if (next == std::begin(kGenerations))
+    {
+        return nullptr;
+    }
+    const CpuGeneration* generation = next - 1;
+    return generation->family == family && model <= generation->model_last ? generation : nullptr;
+}
+
+constexpr CpuIdentity Identify(uint32_t eax, uint32_t ebx)
+{
+    CpuIdentity identity = {};
+    identity.signature = eax;
+    identity.package_type = (ebx >> 28) & 0x0F;
+    const uint32_t base_family = (eax >> 8) & 0xF;
+    identity.family = base_family == 0xF ? base_family + ((eax >> 20) & 0xFF) : base_family;
+    identity.model = base_family == 0xF ? ((eax >> 12) & 0xF0) | ((eax >> 4) & 0xF) : (eax >> 4) & 0xF;
+    identity.stepping = eax & 0xF;
+    identity.supported = std::binary_search(kSupported.begin(), kSupported.end(), Key(identity.package_type, eax));
+    identity.generation = FindGeneration(identity.family, identity.model);
+    return identity;
+}
+
+constexpr bool AllSupportedHaveGeneration()
+{
+    for (uint64_t key : kSupported)
+    {
+        if (!Identify(static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32) << 28).generation)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(AllSupportedHaveGeneration(), "every supported signature needs a generation");
+
+constexpr uint32_t Package(uint32_t package_type)
+{
+    return package_type << 28;
+}
+
+// Vermeer (Ryzen 5000) on AM4, but not in an FP5 laptop package.
+static_assert(Identify(0x00A20F10, Package(kPackageAM4)).supported);
+static_assert(!Identify(0x00A20F10, Package(kPackageFP5)).supported);
+static_assert(Identify(0x00A20F10, Package(kPackageAM4)).family == 0x19);
+static_assert(Identify(0x00A20F10, Package(kPackageAM4)).model == 0x21);
+static_assert(Identify(0x00A20F12, Package(kPackageAM4)).stepping == 2);
+static_assert(std::string_view(Identify(0x00A20F10, Package(kPackageAM4)).generation->codename) == "Vermeer");
+// Raphael on AM5 (package 0) and Storm Peak on SP6.
+static_assert(Identify(0x00A60F12, Package(kPackageFP5)).supported);
+static_assert(std::string_view(Identify(0x00A10F81, Package(kPackageSP6)).generation->codename) == "Storm Peak");
+static_assert(Identify(0x00A10F81, Package(kPackageSP6)).supported);
+// Lists shared by two package values apply to both.
+static_assert(Identify(0x00A70FC0, Package(kPackageFP7R2_B0)).supported);
+static_assert(Identify(0x00B70F00, Package(kPackageSP3)).supported);
+// Known generation, signature the SDK does not list.
+static_assert(!Identify(0x00A20F11, Package(kPackageAM4)).supported);
+static_assert(std::string_view(Identify(0x00A20F11, Package(kPackageAM4)).generation->codename) == "Vermeer");
+// Not an AMD signature at all.
+static_assert(!Identify(0x000906EA, 0).supported);
+static_assert(Identify(0x000906EA, 0).generation == nullptr);
+// Zen 2 desktop parts pair two CCXs per CCD.
+static_assert(Identify(0x00870F10, Package(kPackageAM4)).generation->ccx_per_ccd == 2);
+
+} // namespace
+
+CpuIdentity IdentifyCpu(uint32_t eax, uint32_t ebx)
+{
+    return Identify(eax, ebx);
+}
+
+const CpuIdentity& IdentifyThisCpu()
+{
+    static const CpuIdentity s_identity = []()
+    {
+        int info[4] = {};
+        __cpuid(info, 0x80000001);
+        return Identify(static_cast<uint32_t>(info[0]), static_cast<uint32_t>(info[1]));
+    }();
+    return s_identity;
+}
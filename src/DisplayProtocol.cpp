@@ -0,0 +1,213 @@
+// Cooler display protocols as data. Each model is one kProtocols entry: its
+// init reports and its status report, described by a template, the positions
+// and encodings of the values and a checksum. Supporting another model means
+// adding an entry, not code.
+//
+// Rendering is constexpr, so the golden reports at the end are checked by the
+// compiler on every build, on any platform: this file needs only the standard
+// library and can be compiled on its own with -fsyntax-only.
+
+#include <bit>
+#include <cstddef>
+#include <limits>
+
+#include "DisplayProtocol.hpp"
+
+namespace {
+
+// Deepcool displays on VID 0x3633 that take the 64-byte "104 1 1" reports:
+// id 16, the header, the command, the Sum8 of everything after the id, then 22.
+constexpr ReportLayout DeepcoolInit(uint8_t page)
+{
+    return { 64, 9, { 16, 104, 1, 1, 2, page, 1, 0, 22 }, 0, {}, ChecksumType::Sum8, 1, 7, 7 };
+}
+
+constexpr DisplayProtocol kProtocols[] = {
+    {
+        "Deepcool 3633:000A", 0x3633, 0x000A, 100,
+        2, { DeepcoolInit(3), DeepcoolInit(2) },
+        {
+            64, 18, { 16, 104, 1, 1, 11, 1, 2, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 22 },
+            3,
+            {
+                { FieldSource::PowerW, FieldEncoding::U16BE, 8, 0, 65535 },
+                { FieldSource::TemperatureC, FieldEncoding::F32BE, 11, -999, 999 },
+                { FieldSource::UsagePercent, FieldEncoding::U8, 15, 0, 100 },
+            },
+            ChecksumType::Sum8, 1, 16, 16,
+        },
+    },
+};
+
+constexpr bool LayoutFits(const ReportLayout& layout)
+{
+    if (layout.size > RM_HID_REPORT_SIZE || layout.template_size > layout.size ||
+        layout.field_count > RM_REPORT_MAX_FIELDS)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < layout.field_count; ++i)
+    {
+        const ReportField& field = layout.fields[i];
+        const uint32_t width = field.encoding == FieldEncoding::U8 ? 1 :
+            field.encoding == FieldEncoding::U16BE || field.encoding == FieldEncoding::U16LE ? 2 : 4;
+        if (field.offset + width > layout.size || field.min > field.max)
+        {
+            return false;
+        }
+    }
+    return layout.checksum == ChecksumType::None ||
+        (layout.checksum_first <= layout.checksum_end && layout.checksum_end <= layout.size && layout.checksum_offset < layout.size);
+}
+
+constexpr bool ProtocolsValid()
+{
+    for (const DisplayProtocol& protocol : kProtocols)
+    {
+        if (protocol.init_count > RM_DISPLAY_MAX_INIT || !LayoutFits(protocol.status))
+        {
+            return false;
+        }
+        for (uint8_t i = 0; i < protocol.init_count; ++i)
+        {
+            if (!LayoutFits(protocol.init[i]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(ProtocolsValid(), "a report layout does not fit its report");
+
+constexpr int32_t RoundClamped(double value, int32_t low, int32_t high)
+{
+    value = value == value ? value : 0.0;
+    if (value <= low)
+    {
+        return low;
+    }
+    if (value >= high)
+    {
+        return high;
+    }
+    return value >= 0 ? static_cast<int32_t>(value + 0.5) : -static_cast<int32_t>(-value + 0.5);
+}
+
+constexpr double SourceValue(const DisplayValues& values, FieldSource source)
+{
+    switch (source)
+    {
+    case FieldSource::TemperatureC:
+        return values.temperature_c;
+    case FieldSource::PowerW:
+        return values.power_w;
+    case FieldSource::UsagePercent:
+        return values.usage_percent;
+    }
+    return 0.0;
+}
+
+constexpr void PutBytes(DisplayReport& report, size_t offset, uint32_t value, uint32_t width, bool big_endian)
+{
+    for (uint32_t i = 0; i < width; ++i)
+    {
+        const uint32_t shift = 8 * (big_endian ? width - 1 - i : i);
+        report[offset + i] = static_cast<uint8_t>(value >> shift);
+    }
+}
+
+constexpr void Render(const ReportLayout& layout, const DisplayValues* values, DisplayReport& report)
+{
+    report = {};
+    for (uint8_t i = 0; i < layout.template_size; ++i)
+    {
+        report[i] = layout.template_bytes[i];
+    }
+
+    for (uint8_t i = 0; values && i < layout.field_count; ++i)
+    {
+        const ReportField& field = layout.fields[i];
+        const int32_t value = RoundClamped(SourceValue(*values, field.source), field.min, field.max);
+        switch (field.encoding)
+        {
+        case FieldEncoding::U8:
+            report[field.offset] = static_cast<uint8_t>(value);
+            break;
+        case FieldEncoding::U16BE:
+        case FieldEncoding::U16LE:
+            PutBytes(report, field.offset, static_cast<uint32_t>(value), 2, field.encoding == FieldEncoding::U16BE);
+            break;
+        case FieldEncoding::F32BE:
+        case FieldEncoding::F32LE:
+            PutBytes(report, field.offset, std::bit_cast<uint32_t>(static_cast<float>(value)), 4, field.encoding == FieldEncoding::F32BE);
+            break;
+        }
+    }
+
+    if (layout.checksum == ChecksumType::Sum8)
+    {
+        uint32_t sum = 0;
+        for (uint8_t i = layout.checksum_first; i < layout.checksum_end; ++i)
+        {
+            sum += report[i];
+        }
+        report[layout.checksum_offset] = static_cast<uint8_t>(sum);
+    }
+}
+
+constexpr DisplayReport Status(const DisplayProtocol& protocol, double temperature_c, double power_w, double usage_percent)
+{
+    DisplayReport report = {};
+    const DisplayValues values = { temperature_c, power_w, usage_percent };
+    Render(protocol.status, &values, report);
+    return report;
+}
+
+constexpr DisplayReport Init(const DisplayProtocol& protocol, uint32_t index)
+{
+    DisplayReport report = {};
+    Render(protocol.init[index], nullptr, report);
+    return report;
+}
+
+// Golden reports, byte for byte what the display was first driven with.
+constexpr const DisplayProtocol& kDeepcool = kProtocols[0];
+static_assert(Init(kDeepcool, 0) == DisplayReport{ 16, 104, 1, 1, 2, 3, 1, 112, 22 });
+static_assert(Init(kDeepcool, 1) == DisplayReport{ 16, 104, 1, 1, 2, 2, 1, 111, 22 });
+static_assert(Status(kDeepcool, 55.4, 80.2, 30.1) ==
+    DisplayReport{ 16, 104, 1, 1, 11, 1, 2, 5, 0, 80, 0, 66, 92, 0, 0, 30, 137, 22 });
+static_assert(Status(kDeepcool, 70.0, 90.0, 40.0) ==
+    DisplayReport{ 16, 104, 1, 1, 11, 1, 2, 5, 0, 90, 0, 66, 140, 0, 0, 40, 205, 22 });
+// 65.5 rounds away from zero; power above 255 W spills into the high byte and
+// the checksum wraps.
+static_assert(Status(kDeepcool, 65.5, 300.0, 99.6) ==
+    DisplayReport{ 16, 104, 1, 1, 11, 1, 2, 5, 1, 44, 0, 66, 132, 0, 0, 100, 212, 22 });
+// Out-of-range and NaN inputs clamp instead of wrapping.
+static_assert(Status(kDeepcool, std::numeric_limits<double>::quiet_NaN(), -5.0, 250.0) ==
+    DisplayReport{ 16, 104, 1, 1, 11, 1, 2, 5, 0, 0, 0, 0, 0, 0, 0, 100, 225, 22 });
+
+} // namespace
+
+const DisplayProtocol* FindDisplayProtocol(uint16_t vendor_id, uint16_t product_id)
+{
+    for (const DisplayProtocol& protocol : kProtocols)
+    {
+        if (!vendor_id || (protocol.vendor_id == vendor_id && protocol.product_id == product_id))
+        {
+            return &protocol;
+        }
+    }
+    return nullptr;
+}
+
+void RenderDisplayInit(const DisplayProtocol& protocol, uint32_t index, DisplayReport& report)
+{
+    Render(protocol.init[index], nullptr, report);
+}
+
+void RenderDisplayStatus(const DisplayProtocol& protocol, const DisplayValues& values, DisplayReport& report)
+{
+    Render(protocol.status, &values, report);
+}
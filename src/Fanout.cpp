@@ -0,0 +1,489 @@
+// In-process snapshot hub: publish once, read by any number of sinks.
+//
+// The publisher copies each snapshot into one slot of a broadcast ring and
+// advances write_cursor. Each sink has a thread and a cursor of its own and
+// reads the slots behind write_cursor at its own pace, so a slow sink delays
+// neither the publisher nor the other sinks. Slots carry a sequence number
+// (2 * cursor + 1 while written, 2 * cursor + 2 once complete), which tells a
+// reader both that its copy was torn and that the slot was reused by a later
+// lap. A sink the publisher lapped skips to the oldest snapshot still held and
+// reports how many it lost. Idle sinks sleep in WaitOnAddress; the publisher
+// wakes them with one WakeByAddressAll, and only when one is waiting, so
+// publishing costs no system call while the sinks keep up.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "Clock.hpp"
+#include "Fanout.hpp"
+
+namespace {
+
+constexpr uint32_t kHubCapacity = RM_HUB_CAPACITY;
+// Latency samples kept by rm_hub_bench per series; later ones are not recorded.
+constexpr size_t kBenchMaxSamples = 1 << 20;
+
+struct HubSlot
+{
+    std::atomic<uint64_t> seq{ 0 };
+    RMCpuSnapshot snapshot;
+};
+
+enum class SinkState
+{
+    Free,
+    Active,
+    Stopping        // unregistered, its thread not yet joined
+};
+
+struct FanoutHub;
+
+struct HubSink
+{
+    // Changed under the hub lock.
+    SinkState state = SinkState::Free;
+    uint32_t id = 0;
+
+    // Set before the thread starts; the thread owns them from then on.
+    FanoutHub* hub = nullptr;
+    RMHubSinkCallback callback = nullptr;
+    void* user = nullptr;
+    HANDLE thread = nullptr;
+    std::unique_ptr<RMCpuSnapshot> buffer;
+    uint64_t cursor = 0;
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> read_cursor{ 0 };     // cursor as last published by the thread, for stats
+    std::atomic<uint64_t> delivered{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+};
+
+struct FanoutHub
+{
+    // Serializes publishers with each other and with sink registration.
+    // Sinks never take it.
+    SRWLOCK lock = SRWLOCK_INIT;
+    std::atomic<uint64_t> write_cursor{ 0 };
+    // Sinks sleep on `wake`, which changes after every publish that found one
+    // of them waiting and whenever a sink is told to stop.
+    std::atomic<uint32_t> wake{ 0 };
+    std::atomic<uint32_t> waiters{ 0 };
+    uint64_t published = 0;
+    uint32_t sink_count = 0;
+    uint32_t next_id = 0;
+    HubSlot slots[kHubCapacity];
+    HubSink sinks[RM_HUB_MAX_SINKS];
+};
+
+FanoutHub g_hub;
+
+void Publish(FanoutHub& hub, const RMCpuSnapshot& snapshot)
+{
+    AcquireSRWLockExclusive(&hub.lock);
+    if (hub.sink_count == 0)
+    {
+        ReleaseSRWLockExclusive(&hub.lock);
+        return;
+    }
+
+    const uint64_t cursor = hub.write_cursor.load(std::memory_order_relaxed);
+    HubSlot& slot = hub.slots[cursor % kHubCapacity];
+    slot.seq.store(2 * cursor + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.snapshot, &snapshot, sizeof(RMCpuSnapshot));
+    slot.seq.store(2 * cursor + 2, std::memory_order_release);
+    // Pairs with the waiters increment and write_cursor load in
+    // SinkThreadProc: either the sink sees the new cursor or this sees it
+    // waiting.
+    hub.write_cursor.store(cursor + 1, std::memory_order_seq_cst);
+    hub.published++;
+    if (hub.waiters.load(std::memory_order_seq_cst) != 0)
+    {
+        hub.wake.fetch_add(1, std::memory_order_seq_cst);
+        WakeByAddressAll(&hub.wake);
+    }
+    ReleaseSRWLockExclusive(&hub.lock);
+}
+
+// Copies the snapshot at the sink's cursor into its buffer. Returns false
+// once the sink has read everything published. A sink the publisher lapped
+// moves to the oldest snapshot still held and adds the ones it skipped to
+// `lost`.
+bool ReadNext(FanoutHub& hub, HubSink& sink, uint64_t& lost)
+{
+    for (;;)
+    {
+        const uint64_t head = hub.write_cursor.load(std::memory_order_acquire);
+        if (sink.cursor == head)
+        {
+            return false;
+        }
+        if (head - sink.cursor > kHubCapacity)
+        {
+            lost += head - kHubCapacity - sink.cursor;
+            sink.cursor = head - kHubCapacity;
+        }
+
+        const HubSlot& slot = hub.slots[sink.cursor % kHubCapacity];
+        const uint64_t expected = 2 * sink.cursor + 2;
+        if (slot.seq.load(std::memory_order_acquire) == expected)
+        {
+            std::memcpy(sink.buffer.get(), &slot.snapshot, sizeof(RMCpuSnapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == expected)
+            {
+                sink.cursor++;
+                return true;
+            }
+        }
+        // The publisher is rewriting this slot for a later lap; once it
+        // finishes, write_cursor says how far to skip.
+        YieldProcessor();
+    }
+}
+
+DWORD WINAPI SinkThreadProc(LPVOID param)
+{
+    HubSink& sink = *static_cast<HubSink*>(param);
+    FanoutHub& hub = *sink.hub;
+    uint64_t lost = 0;
+    while (!sink.stop.load(std::memory_order_acquire))
+    {
+        if (ReadNext(hub, sink, lost))
+        {
+            sink.callback(sink.buffer.get(), lost, sink.user);
+            sink.read_cursor.store(sink.cursor, std::memory_order_relaxed);
+            sink.delivered.fetch_add(1, std::memory_order_relaxed);
+            sink.dropped.fetch_add(lost, std::memory_order_relaxed);
+            lost = 0;
+            continue;
+        }
+
+        // Count ourselves waiting, then look again: a publish between the
+        // read above and the count would otherwise not wake us. WaitOnAddress
+        // returns at once if `wake` moved since it was sampled.
+        uint32_t wake = hub.wake.load(std::memory_order_seq_cst);
+        hub.waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (hub.write_cursor.load(std::memory_order_seq_cst) == sink.cursor &&
+            !sink.stop.load(std::memory_order_seq_cst))
+        {
+            WaitOnAddress(&hub.wake, &wake, sizeof(wake), INFINITE);
+        }
+        hub.waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+HubSink* FindSink(FanoutHub& hub, uint32_t id)
+{
+    for (HubSink& sink : hub.sinks)
+    {
+        if (sink.state == SinkState::Active && sink.id == id)
+        {
+            return &sink;
+        }
+    }
+    return nullptr;
+}
+
+int RegisterSink(FanoutHub& hub, RMHubSinkCallback callback, void* user, uint32_t& id)
+{
+    std::unique_ptr<RMCpuSnapshot> buffer(new (std::nothrow) RMCpuSnapshot);
+    if (!buffer)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    AcquireSRWLockExclusive(&hub.lock);
+    HubSink* sink = nullptr;
+    for (HubSink& candidate : hub.sinks)
+    {
+        if (candidate.state == SinkState::Free)
+        {
+            sink = &candidate;
+            break;
+        }
+    }
+    if (!sink)
+    {
+        ReleaseSRWLockExclusive(&hub.lock);
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    // Ids are never 0 and not reused soon, so a stale id fails to unregister
+    // rather than removing another sink.
+    hub.next_id = hub.next_id + 1 ? hub.next_id + 1 : 1;
+    sink->id = hub.next_id;
+    sink->hub = &hub;
+    sink->callback = callback;
+    sink->user = user;
+    sink->buffer = std::move(buffer);
+    sink->cursor = hub.write_cursor.load(std::memory_order_relaxed);
+    sink->stop.store(false, std::memory_order_relaxed);
+    sink->read_cursor.store(sink->cursor, std::memory_order_relaxed);
+    sink->delivered.store(0, std::memory_order_relaxed);
+    sink->dropped.store(0, std::memory_order_relaxed);
+    // Active before the thread exists: snapshots published meanwhile wait in
+    // the ring like for any other sink.
+    sink->state = SinkState::Active;
+    hub.sink_count++;
+    ReleaseSRWLockExclusive(&hub.lock);
+
+    sink->thread = CreateThread(nullptr, 0, SinkThreadProc, sink, 0, nullptr);
+    if (!sink->thread)
+    {
+        AcquireSRWLockExclusive(&hub.lock);
+        sink->state = SinkState::Free;
+        sink->buffer.reset();
+        hub.sink_count--;
+        ReleaseSRWLockExclusive(&hub.lock);
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    id = sink->id;
+    return RM_STATUS_OK;
+}
+
+int UnregisterSink(FanoutHub& hub, uint32_t id)
+{
+    AcquireSRWLockExclusive(&hub.lock);
+    HubSink* sink = FindSink(hub, id);
+    if (!sink)
+    {
+        ReleaseSRWLockExclusive(&hub.lock);
+        return RM_STATUS_INVALID_ARG;
+    }
+    sink->state = SinkState::Stopping;
+    hub.sink_count--;
+    ReleaseSRWLockExclusive(&hub.lock);
+
+    // Joined outside the lock: a sink busy in its callback must not hold up
+    // publishers.
+    sink->stop.store(true, std::memory_order_seq_cst);
+    hub.wake.fetch_add(1, std::memory_order_seq_cst);
+    WakeByAddressAll(&hub.wake);
+    WaitForSingleObject(sink->thread, INFINITE);
+    CloseHandle(sink->thread);
+
+    AcquireSRWLockExclusive(&hub.lock);
+    sink->thread = nullptr;
+    sink->buffer.reset();
+    sink->id = 0;
+    sink->state = SinkState::Free;
+    ReleaseSRWLockExclusive(&hub.lock);
+    return RM_STATUS_OK;
+}
+
+// One sink of rm_hub_bench. The writer stores the publish index in cursor and
+// the QPC time of the publish in timestamp_ms.
+struct BenchSink
+{
+    LONGLONG delay = 0;
+    bool record = false;
+    uint64_t next = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t sequence_errors = 0;
+    std::vector<uint64_t> delivery_ns;
+};
+
+void BenchSinkCallback(const RMCpuSnapshot* snapshot, uint64_t dropped, void* user)
+{
+    BenchSink& sink = *static_cast<BenchSink*>(user);
+    const LONGLONG now = QpcNow();
+    if (snapshot->cursor != sink.next + dropped)
+    {
+        sink.sequence_errors++;
+    }
+    sink.next = snapshot->cursor + 1;
+    sink.delivered++;
+    sink.dropped += dropped;
+    if (sink.record && sink.delivery_ns.size() < sink.delivery_ns.capacity())
+    {
+        sink.delivery_ns.push_back(QpcToNanoseconds(now - static_cast<LONGLONG>(snapshot->timestamp_ms)));
+    }
+    if (sink.delay)
+    {
+        const LONGLONG until = now + sink.delay;
+        while (QpcNow() < until)
+        {
+            SwitchToThread();
+        }
+    }
+}
+
+} // namespace
+
+void FanoutPublish(const RMCpuSnapshot& snapshot)
+{
+    Publish(g_hub, snapshot);
+}
+
+// Starts a sink: a thread that calls `callback` for every snapshot published
+// from now on. *id identifies it to rm_hub_unregister_sink. Fails with
+// RM_STATUS_ALLOC_FAILED once RM_HUB_MAX_SINKS sinks are registered.
+extern "C" int rm_hub_register_sink(RMHubSinkCallback callback, void* user, unsigned int* id)
+{
+    if (!callback || !id)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+    uint32_t registered = 0;
+    const int status = RegisterSink(g_hub, callback, user, registered);
+    *id = status == RM_STATUS_OK ? registered : 0;
+    return status;
+}
+
+// Stops a sink and waits for its thread, including a callback in progress.
+// Must not be called from the sink's own callback.
+extern "C" int rm_hub_unregister_sink(unsigned int id)
+{
+    return UnregisterSink(g_hub, id);
+}
+
+extern "C" int rm_hub_stats(RMHubStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    *stats = {};
+    stats->capacity = kHubCapacity;
+    AcquireSRWLockShared(&g_hub.lock);
+    stats->published = g_hub.published;
+    stats->sink_count = g_hub.sink_count;
+    const uint64_t head = g_hub.write_cursor.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < RM_HUB_MAX_SINKS; ++i)
+    {
+        const HubSink& sink = g_hub.sinks[i];
+        if (sink.state != SinkState::Active)
+        {
+            continue;
+        }
+        RMHubSinkStats& out = stats->sinks[i];
+        out.id = sink.id;
+        out.delivered = sink.delivered.load(std::memory_order_relaxed);
+        out.dropped = sink.dropped.load(std::memory_order_relaxed);
+        out.lag = head - std::min(sink.read_cursor.load(std::memory_order_relaxed), head);
+    }
+    ReleaseSRWLockShared(&g_hub.lock);
+    return RM_STATUS_OK;
+}
+
+// Measures the hub with a private instance: the calling thread publishes
+// synthetic snapshots while config->sinks sinks read them, the slow ones
+// stalling in every callback. Nothing reaches the sinks of the real hub.
+extern "C" int rm_hub_bench(const RMHubBenchConfig* config, RMHubBenchStats* stats)
+{
+    if (!config || !stats || config->sinks == 0 || config->sinks > RM_HUB_MAX_SINKS ||
+        config->slow_sinks > config->sinks || config->duration_ms == 0)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    std::unique_ptr<FanoutHub> hub(new (std::nothrow) FanoutHub());
+    std::unique_ptr<RMCpuSnapshot> snapshot(new (std::nothrow) RMCpuSnapshot());
+    std::unique_ptr<BenchSink[]> sinks(new (std::nothrow) BenchSink[config->sinks]);
+    std::vector<uint64_t> publish_ns;
+    if (!hub || !snapshot || !sinks)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    const uint32_t fast_count = config->sinks - config->slow_sinks;
+    try
+    {
+        publish_ns.reserve(kBenchMaxSamples);
+        if (fast_count)
+        {
+            sinks[0].record = true;
+            sinks[0].delivery_ns.reserve(kBenchMaxSamples);
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    std::vector<uint32_t> ids(config->sinks, 0);
+    int status = RM_STATUS_OK;
+    for (uint32_t i = 0; i < config->sinks && status == RM_STATUS_OK; ++i)
+    {
+        sinks[i].delay = i >= fast_count ? MicrosecondsToQpc(config->slow_sink_us) : 0;
+        status = RegisterSink(*hub, BenchSinkCallback, &sinks[i], ids[i]);
+    }
+
+    *stats = {};
+    if (status == RM_STATUS_OK)
+    {
+        snapshot->core_count = 16;
+        const LONGLONG interval = config->publish_rate_hz ? std::max<LONGLONG>(QpcFrequency() / config->publish_rate_hz, 1) : 0;
+        const LONGLONG begin = QpcNow();
+        const LONGLONG end = begin + MicrosecondsToQpc(static_cast<uint64_t>(config->duration_ms) * 1000);
+        LONGLONG next = begin;
+        for (;;)
+        {
+            LONGLONG now = QpcNow();
+            if (now >= end)
+            {
+                break;
+            }
+            if (interval)
+            {
+                if (now < next)
+                {
+                    SwitchToThread();
+                    continue;
+                }
+                next = std::max(next + interval, now);
+            }
+
+            const LONGLONG start = QpcNow();
+            snapshot->cursor = stats->publishes;
+            snapshot->timestamp_ms = static_cast<uint64_t>(start);
+            Publish(*hub, *snapshot);
+            if (publish_ns.size() < kBenchMaxSamples)
+            {
+                publish_ns.push_back(QpcToNanoseconds(QpcNow() - start));
+            }
+            stats->publishes++;
+        }
+        stats->elapsed_us = QpcToMicroseconds(QpcNow() - begin);
+    }
+
+    for (uint32_t i = 0; i < config->sinks; ++i)
+    {
+        if (ids[i])
+        {
+            UnregisterSink(*hub, ids[i]);
+        }
+    }
+    if (status != RM_STATUS_OK)
+    {
+        return status;
+    }
+
+    for (uint32_t i = 0; i < config->sinks; ++i)
+    {
+        const BenchSink& sink = sinks[i];
+        (i < fast_count ? stats->fast_delivered : stats->slow_delivered) += sink.delivered;
+        (i < fast_count ? stats->fast_dropped : stats->slow_dropped) += sink.dropped;
+        stats->sequence_errors += sink.sequence_errors;
+    }
+    const double seconds = std::max<double>(static_cast<double>(stats->elapsed_us), 1.0) / 1000000.0;
+    stats->publishes_per_s = static_cast<double>(stats->publishes) / seconds;
+    stats->publish = SummarizeLatencies(publish_ns);
+    if (fast_count)
+    {
+        stats->delivery = SummarizeLatencies(sinks[0].delivery_ns);
+    }
+    return RM_STATUS_OK;
+}
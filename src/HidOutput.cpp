@@ -0,0 +1,713 @@
+// USB HID output stage: turns published samples into cooler display reports
+// and writes them from a thread of its own, to every attached display at once.
+//
+// Producers (the sampler through rm_ipc_publish_snapshot, or a consumer of
+// another process's samples through rm_hid_output_submit) copy three values
+// into a SubmitQueue (inc/SubmitQueue.hpp), as RecorderSubmit does, so a
+// slow or unplugged cooler never holds up sampling. Each display renders its
+// own report with its model's layout (src/DisplayProtocol.cpp) and keeps only
+// the newest one: a report equal to it is skipped, and one arriving while a
+// write is pending or within the display's write interval replaces the report
+// still waiting. Writes are overlapped, one in flight per display, and
+// cancelled after write_timeout_ms. A failure closes that display only; the
+// thread rescans for devices after a delay that doubles from backoff_min_ms
+// up to backoff_max_ms, and every backoff_max_ms while all is well so that a
+// display plugged in later is picked up.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <setupapi.h>
+#include <hidsdi.h>
+#include <algorithm>
+#include <atomic>
+#include <cwchar>
+#include <new>
+#include <string>
+
+#include "Clock.hpp"
+#include "DisplayProtocol.hpp"
+#include "HidOutput.hpp"
+#include "SubmitQueue.hpp"
+
+namespace {
+
+constexpr uint32_t kQueueCapacity = 16;
+constexpr uint32_t kDefaultWriteTimeoutMs = 1000;
+constexpr uint32_t kDefaultRefreshMs = 5000;
+constexpr uint32_t kDefaultBackoffMinMs = 500;
+constexpr uint32_t kDefaultBackoffMaxMs = 30000;
+constexpr size_t kMaxDevicePathBytes = 2048;
+
+struct HidSample
+{
+    int32_t status;
+    double temperature_c;
+    double power_w;
+    double usage_percent;
+};
+
+DWORD Remaining(uint64_t due_ms, uint64_t now_ms)
+{
+    return due_ms > now_ms ? static_cast<DWORD>(std::min<uint64_t>(due_ms - now_ms, INFINITE - 1)) : 0;
+}
+
+// One attached display. `desired` is its newest report; `dirty` means the
+// device has not been sent it yet. The init reports go out first, one per
+// write, before the display counts as connected.
+struct Display
+{
+    const DisplayProtocol* protocol = nullptr;
+    HANDLE device = INVALID_HANDLE_VALUE;
+    HANDLE write_event = nullptr;
+    bool is_hid = false;
+    wchar_t path[kMaxDevicePathBytes / sizeof(wchar_t)] = {};
+    uint32_t write_interval_ms = 0;
+    uint32_t init_sent = 0;
+    OVERLAPPED overlapped = {};
+    bool writing = false;
+    uint64_t write_started_ms = 0;
+    LONGLONG write_started_qpc = 0;
+    DisplayReport in_flight = {};
+    DisplayReport desired = {};
+    bool has_desired = false;
+    bool dirty = false;
+    uint64_t last_write_ms = 0;
+};
+
+struct HidOutputState
+{
+    HANDLE thread = nullptr;
+    HANDLE stop_event = nullptr;
+    HANDLE data_event = nullptr;
+    RMHidOutputConfig config = {};
+    std::wstring path;
+
+    HidSample queue_slots[kQueueCapacity] = {};
+    SubmitQueue<HidSample, kQueueCapacity> queue;
+    std::atomic<uint64_t> queue_submitted{ 0 };
+
+    // Output thread only.
+    Display displays[RM_HID_MAX_DISPLAYS];
+    DisplayValues latest = {};
+    bool has_latest = false;
+    uint64_t next_scan_ms = 0;
+    uint32_t backoff_ms = 0;
+
+    SRWLOCK stats_lock = SRWLOCK_INIT;
+    RMHidOutputStats stats = {};
+};
+
+static HidOutputState g_hid;
+
+template <typename Fn>
+void UpdateStats(Fn&& update)
+{
+    AcquireSRWLockExclusive(&g_hid.stats_lock);
+    update(g_hid.stats);
+    ReleaseSRWLockExclusive(&g_hid.stats_lock);
+}
+
+bool IsOpen(const Display& display)
+{
+    return display.device != INVALID_HANDLE_VALUE;
+}
+
+bool IsConnected(const Display& display)
+{
+    return IsOpen(display) && display.init_sent == display.protocol->init_count;
+}
+
+int32_t ConnectedCount()
+{
+    int32_t count = 0;
+    for (const Display& display : g_hid.displays)
+    {
+        count += IsConnected(display);
+    }
+    return count;
+}
+
+// Renders the newest sample for `display`. Returns the number of reports it
+// replaced before they were written (0 or 1), or -1 when it was unchanged.
+int Offer(Display& display)
+{
+    DisplayReport report;
+    RenderDisplayStatus(*display.protocol, g_hid.latest, report);
+    if (display.has_desired && report == display.desired)
+    {
+        return -1;
+    }
+    const int coalesced = display.dirty;
+    display.desired = report;
+    display.has_desired = true;
+    display.dirty = true;
+    return coalesced;
+}
+
+// Takes over an opened device. Its writes start with the init reports.
+void Attach(Display& display, HANDLE device, const DisplayProtocol& protocol, bool is_hid, const wchar_t* path)
+{
+    const RMHidOutputConfig& config = g_hid.config;
+    display.protocol = &protocol;
+    display.device = device;
+    display.is_hid = is_hid;
+    wcscpy_s(display.path, path);
+    display.write_interval_ms = config.min_write_interval_ms ? config.min_write_interval_ms : protocol.min_write_interval_ms;
+    display.init_sent = 0;
+    display.writing = false;
+    display.has_desired = false;
+    display.dirty = false;
+    display.last_write_ms = 0;
+    if (g_hid.has_latest)
+    {
+        Offer(display);
+    }
+}
+
+void Close(Display& display)
+{
+    if (display.writing)
+    {
+        DWORD written = 0;
+        CancelIoEx(display.device, &display.overlapped);
+        GetOverlappedResult(display.device, &display.overlapped, &written, TRUE);
+        display.writing = false;
+    }
+    if (IsOpen(display))
+    {
+        CloseHandle(display.device);
+        display.device = INVALID_HANDLE_VALUE;
+    }
+    display.path[0] = L'\0';
+}
+
+uint32_t NextBackoff()
+{
+    const RMHidOutputConfig& config = g_hid.config;
+    return g_hid.backoff_ms ? std::min(g_hid.backoff_ms * 2, config.backoff_max_ms) : config.backoff_min_ms;
+}
+
+// Drops a failed display and brings the next scan forward.
+void Fail(Display& display, DWORD error)
+{
+    Close(display);
+    g_hid.backoff_ms = NextBackoff();
+    g_hid.next_scan_ms = std::min<uint64_t>(g_hid.next_scan_ms, GetTickCount64() + g_hid.backoff_ms);
+    const int32_t connected = ConnectedCount();
+    UpdateStats([error, connected](RMHidOutputStats& stats)
+    {
+        stats.connected = connected;
+        stats.last_error = error;
+        stats.backoff_ms = g_hid.backoff_ms;
+    });
+}
+
+Display* FreeDisplay()
+{
+    for (Display& display : g_hid.displays)
+    {
+        if (!IsOpen(display))
+        {
+            return &display;
+        }
+    }
+    return nullptr;
+}
+
+bool IsAttached(const wchar_t* path)
+{
+    for (const Display& display : g_hid.displays)
+    {
+        if (IsOpen(display) && std::wcscmp(display.path, path) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The protocol for an opened HID interface, or nullptr when it is not a
+// display we drive. A cooler can expose several interfaces under one VID/PID;
+// only the one whose output report has the protocol's size takes the reports.
+const DisplayProtocol* MatchProtocol(HANDLE device)
+{
+    const RMHidOutputConfig& config = g_hid.config;
+    HIDD_ATTRIBUTES attributes{};
+    attributes.Size = sizeof(attributes);
+    if (!HidD_GetAttributes(device, &attributes) ||
+        (config.vendor_id && (attributes.VendorID != config.vendor_id || attributes.ProductID != config.product_id)))
+    {
+        return nullptr;
+    }
+    const DisplayProtocol* protocol = FindDisplayProtocol(attributes.VendorID, attributes.ProductID);
+    PHIDP_PREPARSED_DATA preparsed = nullptr;
+    if (!protocol || !HidD_GetPreparsedData(device, &preparsed))
+    {
+        return nullptr;
+    }
+    HIDP_CAPS caps{};
+    const bool fits = HidP_GetCaps(preparsed, &caps) == HIDP_STATUS_SUCCESS && caps.OutputReportByteLength == protocol->status.size;
+    HidD_FreePreparsedData(preparsed);
+    return fits ? protocol : nullptr;
+}
+
+// Opens every matching HID interface not attached yet, while display slots
+// are free. Returns the number attached.
+uint32_t ScanHid()
+{
+    GUID hid_guid{};
+    HidD_GetHidGuid(&hid_guid);
+    HDEVINFO info = SetupDiGetClassDevsW(&hid_guid, nullptr, nullptr, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+    if (info == INVALID_HANDLE_VALUE)
+    {
+        return 0;
+    }
+
+    alignas(SP_DEVICE_INTERFACE_DETAIL_DATA_W) uint8_t buffer[kMaxDevicePathBytes];
+    SP_DEVICE_INTERFACE_DATA interface_data{};
+    interface_data.cbSize = sizeof(interface_data);
+    uint32_t attached = 0;
+    Display* free_display = FreeDisplay();
+    for (DWORD index = 0; free_display && SetupDiEnumDeviceInterfaces(info, nullptr, &hid_guid, index, &interface_data); ++index)
+    {
+        DWORD required = 0;
+        SetupDiGetDeviceInterfaceDetailW(info, &interface_data, nullptr, 0, &required, nullptr);
+        if (!required || required > sizeof(buffer))
+        {
+            continue;
+        }
+        auto* detail = reinterpret_cast<SP_DEVICE_INTERFACE_DETAIL_DATA_W*>(buffer);
+        detail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+        if (!SetupDiGetDeviceInterfaceDetailW(info, &interface_data, detail, required, nullptr, nullptr) ||
+            IsAttached(detail->DevicePath))
+        {
+            continue;
+        }
+
+        HANDLE device = CreateFileW(detail->DevicePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (device == INVALID_HANDLE_VALUE)
+        {
+            continue;
+        }
+        const DisplayProtocol* protocol = MatchProtocol(device);
+        if (!protocol)
+        {
+            CloseHandle(device);
+            continue;
+        }
+        Attach(*free_display, device, *protocol, true, detail->DevicePath);
+        ++attached;
+        free_display = FreeDisplay();
+    }
+
+    SetupDiDestroyDeviceInfoList(info);
+    return attached;
+}
+
+// A configured path: a HID interface path, or anything else CreateFileW can
+// write to. A missing plain file is created.
+uint32_t OpenPath()
+{
+    Display& display = g_hid.displays[0];
+    const DisplayProtocol* protocol = FindDisplayProtocol(g_hid.config.vendor_id, g_hid.config.product_id);
+    if (IsOpen(display) || !protocol)
+    {
+        return 0;
+    }
+
+    const wchar_t* path = g_hid.path.c_str();
+    HANDLE device = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_OVERLAPPED, nullptr);
+    if (device == INVALID_HANDLE_VALUE && GetLastError() == ERROR_FILE_NOT_FOUND)
+    {
+        device = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    }
+    if (device == INVALID_HANDLE_VALUE)
+    {
+        const DWORD error = GetLastError();
+        UpdateStats([error](RMHidOutputStats& stats) { stats.last_error = error; });
+        return 0;
+    }
+
+    HIDD_ATTRIBUTES attributes{};
+    attributes.Size = sizeof(attributes);
+    Attach(display, device, *protocol, HidD_GetAttributes(device, &attributes) != FALSE, L"");
+    return 1;
+}
+
+// Scans after a failure with a doubling delay, and otherwise every
+// backoff_max_ms to find displays plugged in since.
+void Scan(uint64_t now)
+{
+    const uint32_t attached = g_hid.path.empty() ? ScanHid() : OpenPath();
+    bool any_open = false;
+    for (const Display& display : g_hid.displays)
+    {
+        any_open |= IsOpen(display);
+    }
+    g_hid.backoff_ms = attached || any_open ? 0 : NextBackoff();
+    g_hid.next_scan_ms = now + (g_hid.backoff_ms ? g_hid.backoff_ms : g_hid.config.backoff_max_ms);
+    UpdateStats([](RMHidOutputStats& stats) { stats.backoff_ms = g_hid.backoff_ms; });
+}
+
+void StartWrite(Display& display, uint64_t now)
+{
+    const DisplayProtocol& protocol = *display.protocol;
+    const bool init = display.init_sent < protocol.init_count;
+    if (init)
+    {
+        RenderDisplayInit(protocol, display.init_sent, display.in_flight);
+    }
+    else
+    {
+        display.in_flight = display.desired;
+        display.dirty = false;
+    }
+    const DWORD size = init ? protocol.init[display.init_sent].size : protocol.status.size;
+
+    display.overlapped = {};
+    display.overlapped.hEvent = display.write_event;
+    if (!display.is_hid)
+    {
+        // Both offsets all ones: append to the end of a file sink.
+        display.overlapped.Offset = 0xFFFFFFFF;
+        display.overlapped.OffsetHigh = 0xFFFFFFFF;
+    }
+    ResetEvent(display.write_event);
+    display.write_started_ms = now;
+    display.write_started_qpc = QpcNow();
+    // A write that completes at once still signals write_event, so both
+    // outcomes finish in FinishWrite.
+    if (!WriteFile(display.device, display.in_flight.data(), size, nullptr, &display.overlapped) && GetLastError() != ERROR_IO_PENDING)
+    {
+        const DWORD error = GetLastError();
+        display.dirty = display.has_desired;
+        UpdateStats([](RMHidOutputStats& stats) { stats.write_errors++; });
+        Fail(display, error);
+        return;
+    }
+    display.writing = true;
+}
+
+// Completes the pending write. With `cancel` it is aborted first, unless it
+// finished in the meantime.
+void FinishWrite(Display& display, bool cancel)
+{
+    if (cancel)
+    {
+        CancelIoEx(display.device, &display.overlapped);
+    }
+    DWORD written = 0;
+    DWORD error = ERROR_SUCCESS;
+    if (!GetOverlappedResult(display.device, &display.overlapped, &written, TRUE))
+    {
+        error = GetLastError();
+    }
+    else if (written == 0)
+    {
+        error = ERROR_WRITE_FAULT;
+    }
+    display.writing = false;
+
+    if (error != ERROR_SUCCESS)
+    {
+        const bool timed_out = cancel && error == ERROR_OPERATION_ABORTED;
+        UpdateStats([timed_out](RMHidOutputStats& stats)
+        {
+            if (timed_out)
+            {
+                stats.write_timeouts++;
+            }
+            else
+            {
+                stats.write_errors++;
+            }
+        });
+        Fail(display, timed_out ? ERROR_TIMEOUT : error);
+        return;
+    }
+
+    const uint64_t write_us = QpcToMicroseconds(QpcNow() - display.write_started_qpc);
+    display.last_write_ms = GetTickCount64();
+    const bool init = display.init_sent < display.protocol->init_count;
+    const bool connected = init && ++display.init_sent == display.protocol->init_count;
+    const int32_t connected_count = ConnectedCount();
+    UpdateStats([=](RMHidOutputStats& stats)
+    {
+        stats.reports_written += !init;
+        stats.connects += connected;
+        stats.connected = connected_count;
+        stats.max_write_us = std::max(stats.max_write_us, write_us);
+    });
+}
+
+void DrainQueue()
+{
+    uint64_t skipped = 0;
+    uint64_t coalesced = 0;
+    g_hid.queue.Drain([&skipped, &coalesced](const HidSample& sample)
+    {
+        if (sample.status != RM_STATUS_OK)
+        {
+            return;
+        }
+
+        g_hid.latest = { sample.temperature_c, sample.power_w, sample.usage_percent };
+        g_hid.has_latest = true;
+        for (Display& display : g_hid.displays)
+        {
+            if (IsOpen(display))
+            {
+                const int replaced = Offer(display);
+                skipped += replaced < 0;
+                coalesced += replaced > 0;
+            }
+        }
+    });
+
+    if (skipped || coalesced)
+    {
+        UpdateStats([skipped, coalesced](RMHidOutputStats& stats)
+        {
+            stats.reports_skipped += skipped;
+            stats.reports_coalesced += coalesced;
+        });
+    }
+}
+
+DWORD WINAPI HidOutputThreadProc(LPVOID)
+{
+    const RMHidOutputConfig& config = g_hid.config;
+    for (;;)
+    {
+        uint64_t now = GetTickCount64();
+        if (now >= g_hid.next_scan_ms)
+        {
+            Scan(now);
+            now = GetTickCount64();
+        }
+
+        // Each display's newest report goes out once its rate limit allows; an
+        // unchanged one is repeated every refresh_ms so the display does not
+        // time out. Init reports go out back to back.
+        DWORD timeout = Remaining(g_hid.next_scan_ms, now);
+        HANDLE handles[2 + RM_HID_MAX_DISPLAYS] = { g_hid.stop_event, g_hid.data_event };
+        Display* writers[RM_HID_MAX_DISPLAYS] = {};
+        DWORD count = 2;
+        for (Display& display : g_hid.displays)
+        {
+            if (IsOpen(display) && !display.writing)
+            {
+                const bool init = display.init_sent < display.protocol->init_count;
+                if (init || display.has_desired)
+                {
+                    const uint64_t due = init ? 0 : display.last_write_ms + (display.dirty ? display.write_interval_ms : config.refresh_ms);
+                    if (now >= due)
+                    {
+                        StartWrite(display, now);
+                    }
+                    else
+                    {
+                        timeout = std::min(timeout, Remaining(due, now));
+                    }
+                }
+            }
+            if (display.writing)
+            {
+                timeout = std::min(timeout, Remaining(display.write_started_ms + config.write_timeout_ms, now));
+                writers[count - 2] = &display;
+                handles[count++] = display.write_event;
+            }
+        }
+        if (g_hid.next_scan_ms <= now)
+        {
+            // A write failed at once and brought the scan forward.
+            timeout = 0;
+        }
+
+        const DWORD wait = WaitForMultipleObjects(count, handles, FALSE, timeout);
+        if (wait == WAIT_OBJECT_0 + 1)
+        {
+            DrainQueue();
+        }
+        else if (wait >= WAIT_OBJECT_0 + 2 && wait < WAIT_OBJECT_0 + count)
+        {
+            FinishWrite(*writers[wait - WAIT_OBJECT_0 - 2], false);
+        }
+        else if (wait == WAIT_TIMEOUT)
+        {
+            now = GetTickCount64();
+            for (DWORD i = 0; i + 2 < count; ++i)
+            {
+                if (now - writers[i]->write_started_ms >= config.write_timeout_ms)
+                {
+                    FinishWrite(*writers[i], true);
+                }
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    for (Display& display : g_hid.displays)
+    {
+        Close(display);
+    }
+    return 0;
+}
+
+void CloseHidEvents()
+{
+    for (HANDLE* event : { &g_hid.stop_event, &g_hid.data_event })
+    {
+        if (*event)
+        {
+            CloseHandle(*event);
+            *event = nullptr;
+        }
+    }
+    for (Display& display : g_hid.displays)
+    {
+        if (display.write_event)
+        {
+            CloseHandle(display.write_event);
+            display.write_event = nullptr;
+        }
+    }
+}
+
+} // namespace
+
+void HidOutputSubmit(const RMCpuSnapshot& snapshot)
+{
+    if (!g_hid.queue.Accepting())
+    {
+        return;
+    }
+    g_hid.queue_submitted.fetch_add(1, std::memory_order_relaxed);
+    HidSample sample{};
+    sample.status = snapshot.status;
+    sample.temperature_c = snapshot.temperature_c;
+    sample.power_w = snapshot.power_w;
+    sample.usage_percent = snapshot.usage_percent;
+
+    g_hid.queue.TryPush([&sample](HidSample& slot) { slot = sample; });
+}
+
+// For a process that reads another process's samples over IPC instead of
+// sampling itself; the in-process sampler feeds the stage on its own.
+extern "C" void rm_hid_output_submit(double temperatureC, double powerW, double usagePercent, int status)
+{
+    RMCpuSnapshot snapshot{};
+    snapshot.status = status;
+    snapshot.temperature_c = temperatureC;
+    snapshot.power_w = powerW;
+    snapshot.usage_percent = usagePercent;
+    HidOutputSubmit(snapshot);
+}
+
+// Starts writing every sample passed to rm_ipc_publish_snapshot or
+// rm_hid_output_submit to the attached cooler displays. Returns RM_STATUS_OK
+// even when none is attached; the stage keeps scanning for them.
+extern "C" int rm_hid_output_start(const RMHidOutputConfig* config)
+{
+    if (!config || g_hid.thread || (config->path && !FindDisplayProtocol(config->vendor_id, config->product_id)))
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    try
+    {
+        g_hid.path = config->path ? config->path : L"";
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    g_hid.config = *config;
+    g_hid.config.path = nullptr;
+    RMHidOutputConfig& settings = g_hid.config;
+    settings.write_timeout_ms = settings.write_timeout_ms ? settings.write_timeout_ms : kDefaultWriteTimeoutMs;
+    settings.refresh_ms = settings.refresh_ms ? settings.refresh_ms : kDefaultRefreshMs;
+    settings.backoff_min_ms = settings.backoff_min_ms ? settings.backoff_min_ms : kDefaultBackoffMinMs;
+    settings.backoff_max_ms = std::max(settings.backoff_max_ms ? settings.backoff_max_ms : kDefaultBackoffMaxMs, settings.backoff_min_ms);
+
+    g_hid.stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    g_hid.data_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    bool created = g_hid.stop_event && g_hid.data_event;
+    for (Display& display : g_hid.displays)
+    {
+        display.write_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        created = created && display.write_event;
+    }
+    if (!created)
+    {
+        CloseHidEvents();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    g_hid.queue.Attach(g_hid.queue_slots, g_hid.data_event);
+    g_hid.queue_submitted.store(0, std::memory_order_relaxed);
+    g_hid.has_latest = false;
+    g_hid.backoff_ms = 0;
+    g_hid.next_scan_ms = 0;
+    AcquireSRWLockExclusive(&g_hid.stats_lock);
+    g_hid.stats = {};
+    ReleaseSRWLockExclusive(&g_hid.stats_lock);
+
+    g_hid.thread = CreateThread(nullptr, 0, HidOutputThreadProc, nullptr, 0, nullptr);
+    if (!g_hid.thread)
+    {
+        CloseHidEvents();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    g_hid.queue.Open();
+    return RM_STATUS_OK;
+}
+
+// Stops accepting samples, abandons any pending writes and closes the devices.
+extern "C" void rm_hid_output_stop()
+{
+    if (!g_hid.thread)
+    {
+        return;
+    }
+
+    // Queued samples are abandoned with the pending writes: a display shows
+    // only the newest values, and the stage is going away. Close still has to
+    // come first so no producer sets data_event after CloseHidEvents.
+    g_hid.queue.Close();
+    SetEvent(g_hid.stop_event);
+    WaitForSingleObject(g_hid.thread, INFINITE);
+    CloseHandle(g_hid.thread);
+    g_hid.thread = nullptr;
+    CloseHidEvents();
+
+    AcquireSRWLockExclusive(&g_hid.stats_lock);
+    g_hid.stats.connected = 0;
+    ReleaseSRWLockExclusive(&g_hid.stats_lock);
+}
+
+extern "C" int rm_hid_output_stats(RMHidOutputStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    AcquireSRWLockShared(&g_hid.stats_lock);
+    *stats = g_hid.stats;
+    ReleaseSRWLockShared(&g_hid.stats_lock);
+
+    stats->samples_submitted = g_hid.queue_submitted.load(std::memory_order_relaxed);
+    stats->samples_dropped = g_hid.queue.Dropped();
+    stats->running = g_hid.thread != nullptr;
+    return RM_STATUS_OK;
+}
@@ -0,0 +1,807 @@
+// Localhost metrics endpoint: serves the newest snapshot, the rolling-window
+// aggregates and the SDK latency histograms in the Prometheus text format.
+//
+// The text is rendered once per sample by a hub sink (src/Fanout.cpp) into a
+// staging buffer that is then swapped with the published one, HTTP header
+// included. A scrape copies the published buffer and sends the copy, so any
+// number of scrapes between two samples format nothing. One thread serves
+// every client with non-blocking sockets and WSAPoll; a client that has not
+// finished within kClientTimeoutMs is dropped. The listener is bound to
+// 127.0.0.1 only.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Clock.hpp"
+#include "Telemetry.hpp"
+
+extern "C" int rm_hub_register_sink(RMHubSinkCallback callback, void* user, unsigned int* id);
+extern "C" int rm_hub_unregister_sink(unsigned int id);
+extern "C" int rm_ipc_read_aggregates(RMAggregateSnapshot* aggregates, unsigned int max_age_ms);
+extern "C" int rm_stats_snapshot(RMStats* stats);
+
+namespace {
+
+constexpr int kIpcOk = 0;
+constexpr uint32_t kMaxClients = 8;
+constexpr size_t kMaxRequestBytes = 4096;
+constexpr uint64_t kClientTimeoutMs = 2000;
+constexpr int kPollIntervalMs = 200;
+// Reserved up front so steady-state rendering does not reallocate.
+constexpr size_t kInitialResponseBytes = 64 * 1024;
+
+constexpr char kContentType[] = "text/plain; version=0.0.4; charset=utf-8";
+constexpr char kNotFound[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\nConnection: close\r\n\r\nnot found\n";
+constexpr char kNoSample[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\nContent-Length: 10\r\nConnection: close\r\n\r\nno sample\n";
+
+using SnapshotValueFn = double (*)(const RMCpuSnapshot&);
+
+// One sample line per row. Rows of a family are adjacent and only the first
+// carries its help text.
+struct ScalarMetric
+{
+    const char* name;
+    const char* labels;
+    const char* help;
+    SnapshotValueFn value;
+};
+
+constexpr ScalarMetric kScalarMetrics[] = {
+    { "ryzen_sample_status", "", "RM_STATUS code of the read (0 is success).",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.status); } },
+    { "ryzen_sample_cursor", "", "Publish index of the sample.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.cursor); } },
+    { "ryzen_cpu_temperature_celsius", "", "CPU temperature.",
+        [](const RMCpuSnapshot& s) { return s.temperature_c; } },
+    { "ryzen_cpu_package_temperature_celsius", "", "Package temperature.",
+        [](const RMCpuSnapshot& s) { return s.package_temperature_c; } },
+    { "ryzen_cpu_power_watts", "", "CPU power.",
+        [](const RMCpuSnapshot& s) { return s.power_w; } },
+    { "ryzen_cpu_usage_percent", "", "Average C0 residency of the cores.",
+        [](const RMCpuSnapshot& s) { return s.usage_percent; } },
+    { "ryzen_cpu_peak_speed_hertz", "", "Peak core speed.",
+        [](const RMCpuSnapshot& s) { return s.peak_speed_mhz * 1e6; } },
+    { "ryzen_core_voltage_volts", "{stat=\"peak\"}", "Core voltage.",
+        [](const RMCpuSnapshot& s) { return s.peak_core_voltage; } },
+    { "ryzen_core_voltage_volts", "{stat=\"peak_1\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.peak_core_voltage_1; } },
+    { "ryzen_core_voltage_volts", "{stat=\"avg\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.avg_core_voltage; } },
+    { "ryzen_core_voltage_volts", "{stat=\"avg_1\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.avg_core_voltage_1; } },
+    { "ryzen_soc_voltage_volts", "", "SoC voltage.",
+        [](const RMCpuSnapshot& s) { return s.soc_voltage; } },
+    { "ryzen_ppt_limit_watts", "", "Package power tracking limit.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.ppt_limit_w); } },
+    { "ryzen_ppt_watts", "", "Package power tracking value.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.ppt_value_w); } },
+    { "ryzen_tdc_limit_amperes", "{rail=\"vdd\"}", "Thermal design current limit.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_limit_vdd_a); } },
+    { "ryzen_tdc_limit_amperes", "{rail=\"soc\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_limit_soc_a); } },
+    { "ryzen_tdc_limit_amperes", "{rail=\"ccd\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_limit_ccd_a); } },
+    { "ryzen_tdc_amperes", "{rail=\"vdd\"}", "Thermal design current.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_value_vdd_a); } },
+    { "ryzen_tdc_amperes", "{rail=\"vdd_1\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_value_vdd_1_a); } },
+    { "ryzen_tdc_amperes", "{rail=\"soc\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_value_soc_a); } },
+    { "ryzen_tdc_amperes", "{rail=\"ccd\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.tdc_value_ccd_a); } },
+    { "ryzen_edc_limit_amperes", "{rail=\"vdd\"}", "Electrical design current limit.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_limit_vdd_a); } },
+    { "ryzen_edc_limit_amperes", "{rail=\"soc\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_limit_soc_a); } },
+    { "ryzen_edc_limit_amperes", "{rail=\"ccd\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_limit_ccd_a); } },
+    { "ryzen_edc_amperes", "{rail=\"vdd\"}", "Electrical design current.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_value_vdd_a); } },
+    { "ryzen_edc_amperes", "{rail=\"vdd_1\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_value_vdd_1_a); } },
+    { "ryzen_edc_amperes", "{rail=\"soc\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_value_soc_a); } },
+    { "ryzen_edc_amperes", "{rail=\"ccd\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.edc_value_ccd_a); } },
+    { "ryzen_rail_power_watts", "{rail=\"vddcr_vdd\"}", "Voltage rail power.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.vddcr_vdd_power_w); } },
+    { "ryzen_rail_power_watts", "{rail=\"vddcr_soc\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.vddcr_soc_power_w); } },
+    { "ryzen_chtc_limit_celsius", "", "Thermal control limit.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.chtc_limit_c); } },
+    { "ryzen_fclk_hertz", "", "Fabric clock.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.fclk_p0_freq_mhz) * 1e6; } },
+    { "ryzen_cclk_fmax_hertz", "", "Highest core clock allowed.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.cclk_fmax_mhz) * 1e6; } },
+    { "ryzen_active_cores", "", "Cores with a non-zero frequency.",
+        [](const RMCpuSnapshot& s) { return static_cast<double>(s.active_core_count); } },
+    { "ryzen_core_frequency_summary_hertz", "{stat=\"min\"}", "Frequency over the active cores.",
+        [](const RMCpuSnapshot& s) { return s.core_freq_min_mhz * 1e6; } },
+    { "ryzen_core_frequency_summary_hertz", "{stat=\"max\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.core_freq_max_mhz * 1e6; } },
+    { "ryzen_core_frequency_summary_hertz", "{stat=\"mean\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.core_freq_mean_mhz * 1e6; } },
+    { "ryzen_core_frequency_summary_hertz", "{stat=\"weighted\"}", nullptr,
+        [](const RMCpuSnapshot& s) { return s.core_freq_weighted_mhz * 1e6; } },
+    { "ryzen_core_temperature_max_celsius", "", "Hottest core.",
+        [](const RMCpuSnapshot& s) { return s.core_temp_max_c; } },
+};
+
+// Per-core families, emitted only when the snapshot has the array.
+struct CoreMetric
+{
+    const char* name;
+    const char* help;
+    uint32_t field;                                 // RM_CORE_FIELD_*
+    const double* (*values)(const RMCpuSnapshot&);
+    double scale;
+};
+
+constexpr CoreMetric kCoreMetrics[] = {
+    { "ryzen_core_frequency_hertz", "Core clock.", RM_CORE_FIELD_CURRENT_FREQ,
+        [](const RMCpuSnapshot& s) { return static_cast<const double*>(s.core_current_freq_mhz); }, 1e6 },
+    { "ryzen_core_effective_frequency_hertz", "Effective core clock.", RM_CORE_FIELD_FREQ,
+        [](const RMCpuSnapshot& s) { return static_cast<const double*>(s.core_freq_mhz); }, 1e6 },
+    { "ryzen_core_c0_residency_percent", "Core C0 residency.", RM_CORE_FIELD_RESIDENCY,
+        [](const RMCpuSnapshot& s) { return static_cast<const double*>(s.core_residency); }, 1.0 },
+    { "ryzen_core_temperature_celsius", "Core temperature.", RM_CORE_FIELD_TEMP,
+        [](const RMCpuSnapshot& s) { return static_cast<const double*>(s.core_temp_c); }, 1.0 },
+};
+
+constexpr const char* kWindowNames[RM_AGG_WINDOW_COUNT] = { "1s", "10s", "60s", "5m" };
+
+struct AggregateStat
+{
+    const char* name;
+    double RMAggregate::*value;
+};
+
+constexpr AggregateStat kAggregateStats[] = {
+    { "min", &RMAggregate::min },
+    { "max", &RMAggregate::max },
+    { "mean", &RMAggregate::mean },
+    { "ema", &RMAggregate::ema },
+    { "p50", &RMAggregate::p50 },
+    { "p90", &RMAggregate::p90 },
+    { "p99", &RMAggregate::p99 },
+};
+
+constexpr const char* kSdkCallNames[RM_SDK_CALL_COUNT] = {
+    "load_platform", "platform_init", "get_cpu_parameters", "query_driver", "install_driver"
+};
+
+// Histogram bounds are every other power of two in microseconds, from 2^4
+// (16 us) to 2^24 (16.8 s). Values below 2^m fill exactly the buckets before
+// RM_LATENCY_SUB_BUCKETS * (m - 3) (see RMLatencyHistogram).
+constexpr uint32_t kHistogramMinPower = 4;
+constexpr uint32_t kHistogramMaxPower = 24;
+constexpr uint32_t kHistogramPowerStep = 2;
+
+static_assert(RM_LATENCY_SUB_BUCKETS * (kHistogramMaxPower - 3) <= RM_LATENCY_BUCKETS,
+    "histogram bounds past the last latency bucket");
+
+struct Client
+{
+    SOCKET socket = INVALID_SOCKET;
+    char request[kMaxRequestBytes] = {};
+    size_t received = 0;
+    bool sending = false;
+    std::vector<char> response;
+    size_t sent = 0;
+    uint64_t deadline_ms = 0;
+};
+
+struct MetricsState
+{
+    HANDLE thread = nullptr;
+    SOCKET listener = INVALID_SOCKET;
+    std::atomic<bool> stop{ false };
+    unsigned int sink_id = 0;
+    bool wsa_started = false;
+
+    // Hub sink thread only.
+    std::unique_ptr<RMAggregateSnapshot> aggregates;
+    std::unique_ptr<RMStats> sdk_stats;
+    std::string body;
+    std::vector<char> staging;
+
+    // Swapped with staging under the lock; scrapes copy it under the lock.
+    SRWLOCK response_lock = SRWLOCK_INIT;
+    std::vector<char> published;
+
+    // Server thread only.
+    Client clients[kMaxClients];
+
+    SRWLOCK stats_lock = SRWLOCK_INIT;
+    RMMetricsStats stats = {};
+};
+
+static MetricsState g_metrics;
+
+template <typename Fn>
+void UpdateStats(Fn&& update)
+{
+    AcquireSRWLockExclusive(&g_metrics.stats_lock);
+    update(g_metrics.stats);
+    ReleaseSRWLockExclusive(&g_metrics.stats_lock);
+}
+
+void Printf(std::string& out, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0)
+    {
+        out.append(line, std::min<size_t>(static_cast<size_t>(length), sizeof(line) - 1));
+    }
+}
+
+// Ends a sample line. The CRT prints NaN in forms Prometheus does not parse.
+void Value(std::string& out, double value)
+{
+    if (value != value)
+    {
+        out += "NaN\n";
+        return;
+    }
+    Printf(out, "%.10g\n", value);
+}
+
+void Family(std::string& out, const char* name, const char* type, const char* help)
+{
+    Printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void RenderSnapshot(std::string& out, const RMCpuSnapshot& snapshot)
+{
+    for (const ScalarMetric& metric : kScalarMetrics)
+    {
+        if (metric.help)
+        {
+            Family(out, metric.name, "gauge", metric.help);
+        }
+        Printf(out, "%s%s ", metric.name, metric.labels);
+        Value(out, metric.value(snapshot));
+    }
+
+    const uint32_t cores = std::min<uint32_t>(snapshot.core_count, RM_MAX_CORES);
+    for (const CoreMetric& metric : kCoreMetrics)
+    {
+        if (!(snapshot.core_fields & metric.field))
+        {
+            continue;
+        }
+        Family(out, metric.name, "gauge", metric.help);
+        const double* values = metric.values(snapshot);
+        for (uint32_t core = 0; core < cores; ++core)
+        {
+            Printf(out, "%s{core=\"%u\"} ", metric.name, core);
+            Value(out, values[core] * metric.scale);
+        }
+    }
+}
+
+void RenderAggregate(std::string& out, const RMAggregateSnapshot& aggregates, const char* name, const char* help,
+    RMAggregate RMAggregateWindow::*metric)
+{
+    Family(out, name, "gauge", help);
+    for (uint32_t window = 0; window < RM_AGG_WINDOW_COUNT; ++window)
+    {
+        const RMAggregate& aggregate = aggregates.windows[window].*metric;
+        if (aggregate.count == 0)
+        {
+            continue;
+        }
+        for (const AggregateStat& stat : kAggregateStats)
+        {
+            Printf(out, "%s{window=\"%s\",stat=\"%s\"} ", name, kWindowNames[window], stat.name);
+            Value(out, aggregate.*stat.value);
+        }
+    }
+}
+
+void RenderAggregates(std::string& out, const RMAggregateSnapshot& aggregates)
+{
+    Family(out, "ryzen_window_samples", "gauge", "Samples in the rolling window.");
+    for (uint32_t window = 0; window < RM_AGG_WINDOW_COUNT; ++window)
+    {
+        Printf(out, "ryzen_window_samples{window=\"%s\"} %u\n", kWindowNames[window],
+            aggregates.windows[window].temperature_c.count);
+    }
+    RenderAggregate(out, aggregates, "ryzen_window_temperature_celsius", "CPU temperature over the window.",
+        &RMAggregateWindow::temperature_c);
+    RenderAggregate(out, aggregates, "ryzen_window_power_watts", "CPU power over the window.",
+        &RMAggregateWindow::power_w);
+    RenderAggregate(out, aggregates, "ryzen_window_usage_percent", "CPU usage over the window.",
+        &RMAggregateWindow::usage_percent);
+
+    // Per core only the mean and the maximum, which keeps a many-core
+    // response within a few hundred lines per window.
+    Family(out, "ryzen_window_core_frequency_hertz", "gauge", "Core clock over the window.");
+    for (uint32_t window = 0; window < RM_AGG_WINDOW_COUNT; ++window)
+    {
+        const RMAggregateWindow& data = aggregates.windows[window];
+        const uint32_t cores = std::min<uint32_t>(data.core_count, RM_MAX_CORES);
+        for (uint32_t core = 0; core < cores; ++core)
+        {
+            const RMAggregate& aggregate = data.core_freq_mhz[core];
+            if (aggregate.count == 0)
+            {
+                continue;
+            }
+            Printf(out, "ryzen_window_core_frequency_hertz{window=\"%s\",core=\"%u\",stat=\"mean\"} ",
+                kWindowNames[window], core);
+            Value(out, aggregate.mean * 1e6);
+            Printf(out, "ryzen_window_core_frequency_hertz{window=\"%s\",core=\"%u\",stat=\"max\"} ",
+                kWindowNames[window], core);
+            Value(out, aggregate.max * 1e6);
+        }
+    }
+}
+
+void RenderSdkStats(std::string& out, const RMStats& stats)
+{
+    Family(out, "ryzen_sdk_call_duration_seconds", "histogram", "Duration of timed SDK calls.");
+    for (uint32_t call = 0; call < RM_SDK_CALL_COUNT; ++call)
+    {
+        const RMLatencyHistogram& histogram = stats.calls[call];
+        uint64_t cumulative = 0;
+        uint32_t bucket = 0;
+        for (uint32_t power = kHistogramMinPower; power <= kHistogramMaxPower; power += kHistogramPowerStep)
+        {
+            const uint32_t end = RM_LATENCY_SUB_BUCKETS * (power - 3);
+            for (; bucket < end; ++bucket)
+            {
+                cumulative += histogram.buckets[bucket];
+            }
+            Printf(out, "ryzen_sdk_call_duration_seconds_bucket{call=\"%s\",le=\"%.10g\"} %llu\n", kSdkCallNames[call],
+                static_cast<double>(1ull << power) / 1e6, static_cast<unsigned long long>(cumulative));
+        }
+        for (; bucket < RM_LATENCY_BUCKETS; ++bucket)
+        {
+            cumulative += histogram.buckets[bucket];
+        }
+        // +Inf and _count both come from the buckets so they agree even when
+        // the copy raced a call being recorded.
+        Printf(out, "ryzen_sdk_call_duration_seconds_bucket{call=\"%s\",le=\"+Inf\"} %llu\n", kSdkCallNames[call],
+            static_cast<unsigned long long>(cumulative));
+        Printf(out, "ryzen_sdk_call_duration_seconds_sum{call=\"%s\"} %.10g\n", kSdkCallNames[call],
+            static_cast<double>(histogram.total_us) / 1e6);
+        Printf(out, "ryzen_sdk_call_duration_seconds_count{call=\"%s\"} %llu\n", kSdkCallNames[call],
+            static_cast<unsigned long long>(cumulative));
+    }
+
+    Family(out, "ryzen_sdk_call_failures_total", "counter", "Timed SDK calls that failed.");
+    for (uint32_t call = 0; call < RM_SDK_CALL_COUNT; ++call)
+    {
+        Printf(out, "ryzen_sdk_call_failures_total{call=\"%s\"} %llu\n", kSdkCallNames[call],
+            static_cast<unsigned long long>(stats.calls[call].failures));
+    }
+
+    Family(out, "ryzen_monitor_results_total", "counter", "rm_monitor_* results by RM_STATUS code.");
+    for (uint32_t code = 0; code < RM_STATUS_CODE_COUNT; ++code)
+    {
+        if (stats.status_counts[code])
+        {
+            Printf(out, "ryzen_monitor_results_total{status=\"%u\"} %llu\n", code,
+                static_cast<unsigned long long>(stats.status_counts[code]));
+        }
+    }
+
+    Family(out, "ryzen_ipc_torn_read_retries_total", "counter", "Shared-memory reads retried during a write.");
+    Printf(out, "ryzen_ipc_torn_read_retries_total %llu\n", static_cast<unsigned long long>(stats.torn_read_retries));
+    Family(out, "ryzen_ipc_stale_reads_total", "counter", "Shared-memory reads of a sample past its age limit.");
+    Printf(out, "ryzen_ipc_stale_reads_total %llu\n", static_cast<unsigned long long>(stats.stale_reads));
+}
+
+// Renders the response for `snapshot` into the staging buffer and publishes
+// it. Runs on the hub sink thread, once per sample.
+void OnSnapshot(const RMCpuSnapshot* snapshot, uint64_t, void*)
+{
+    const LONGLONG start = QpcNow();
+    MetricsState& state = g_metrics;
+    try
+    {
+        std::string& body = state.body;
+        body.clear();
+        RenderSnapshot(body, *snapshot);
+        if (rm_ipc_read_aggregates(state.aggregates.get(), 0) == kIpcOk)
+        {
+            RenderAggregates(body, *state.aggregates);
+        }
+        if (rm_stats_snapshot(state.sdk_stats.get()) == RM_STATUS_OK)
+        {
+            RenderSdkStats(body, *state.sdk_stats);
+        }
+
+        char header[160];
+        const int header_length = snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+            kContentType, body.size());
+        state.staging.clear();
+        state.staging.insert(state.staging.end(), header, header + header_length);
+        state.staging.insert(state.staging.end(), body.begin(), body.end());
+    }
+    catch (const std::bad_alloc&)
+    {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&state.response_lock);
+    state.published.swap(state.staging);
+    const size_t size = state.published.size();
+    ReleaseSRWLockExclusive(&state.response_lock);
+
+    const uint64_t elapsed_us = QpcToMicroseconds(QpcNow() - start);
+    UpdateStats([&](RMMetricsStats& stats)
+    {
+        stats.serializations++;
+        stats.response_bytes = size;
+        stats.max_serialize_us = std::max(stats.max_serialize_us, elapsed_us);
+    });
+}
+
+void CloseClient(Client& client)
+{
+    if (client.socket != INVALID_SOCKET)
+    {
+        closesocket(client.socket);
+    }
+    client.socket = INVALID_SOCKET;
+    client.received = 0;
+    client.sending = false;
+    client.sent = 0;
+}
+
+void FailClient(Client& client)
+{
+    CloseClient(client);
+    UpdateStats([](RMMetricsStats& stats) { stats.errors++; });
+}
+
+void Send(Client& client)
+{
+    while (client.sent < client.response.size())
+    {
+        const int chunk = static_cast<int>(std::min<size_t>(client.response.size() - client.sent, INT_MAX));
+        const int sent = send(client.socket, client.response.data() + client.sent, chunk, 0);
+        if (sent == SOCKET_ERROR)
+        {
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+            {
+                FailClient(client);
+            }
+            return;
+        }
+        client.sent += static_cast<size_t>(sent);
+    }
+    shutdown(client.socket, SD_SEND);
+    CloseClient(client);
+}
+
+bool IsMetricsRequest(std::string_view request)
+{
+    constexpr std::string_view kPrefix = "GET /metrics";
+    return request.size() > kPrefix.size() && request.substr(0, kPrefix.size()) == kPrefix &&
+        (request[kPrefix.size()] == ' ' || request[kPrefix.size()] == '?');
+}
+
+// Copies the published response (or an error) for a complete request.
+void Respond(Client& client)
+{
+    const bool wanted = IsMetricsRequest(std::string_view(client.request, client.received));
+    bool served = false;
+    bool failed = false;
+    if (wanted)
+    {
+        AcquireSRWLockShared(&g_metrics.response_lock);
+        try
+        {
+            if (!g_metrics.published.empty())
+            {
+                client.response.assign(g_metrics.published.begin(), g_metrics.published.end());
+                served = true;
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            failed = true;
+        }
+        ReleaseSRWLockShared(&g_metrics.response_lock);
+    }
+    if (!served && !failed)
+    {
+        const char* text = wanted ? kNoSample : kNotFound;
+        const size_t length = wanted ? sizeof(kNoSample) - 1 : sizeof(kNotFound) - 1;
+        try
+        {
+            client.response.assign(text, text + length);
+        }
+        catch (const std::bad_alloc&)
+        {
+            failed = true;
+        }
+    }
+    if (failed)
+    {
+        FailClient(client);
+        return;
+    }
+
+    UpdateStats([served](RMMetricsStats& stats)
+    {
+        if (served)
+        {
+            stats.scrapes++;
+        }
+        else
+        {
+            stats.errors++;
+        }
+    });
+    client.sending = true;
+    client.sent = 0;
+    Send(client);
+}
+
+void Receive(Client& client)
+{
+    const int received = recv(client.socket, client.request + client.received,
+        static_cast<int>(kMaxRequestBytes - client.received), 0);
+    if (received == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK)
+    {
+        return;
+    }
+    if (received <= 0)
+    {
+        FailClient(client);
+        return;
+    }
+
+    client.received += static_cast<size_t>(received);
+    if (std::string_view(client.request, client.received).find("\r\n\r\n") != std::string_view::npos)
+    {
+        Respond(client);
+    }
+    else if (client.received == kMaxRequestBytes)
+    {
+        FailClient(client);
+    }
+}
+
+void Accept(uint64_t now_ms)
+{
+    for (Client& client : g_metrics.clients)
+    {
+        if (client.socket != INVALID_SOCKET)
+        {
+            continue;
+        }
+        const SOCKET socket = accept(g_metrics.listener, nullptr, nullptr);
+        if (socket == INVALID_SOCKET)
+        {
+            return;
+        }
+
+        u_long nonblocking = 1;
+        if (ioctlsocket(socket, FIONBIO, &nonblocking) != 0)
+        {
+            closesocket(socket);
+            UpdateStats([](RMMetricsStats& stats) { stats.errors++; });
+            continue;
+        }
+        client.socket = socket;
+        client.deadline_ms = now_ms + kClientTimeoutMs;
+    }
+}
+
+DWORD WINAPI MetricsThreadProc(LPVOID)
+{
+    WSAPOLLFD fds[1 + kMaxClients];
+    Client* polled[1 + kMaxClients];
+    while (!g_metrics.stop.load(std::memory_order_acquire))
+    {
+        ULONG count = 1;
+        for (Client& client : g_metrics.clients)
+        {
+            if (client.socket != INVALID_SOCKET)
+            {
+                fds[count] = { client.socket, static_cast<SHORT>(client.sending ? POLLWRNORM : POLLRDNORM), 0 };
+                polled[count++] = &client;
+            }
+        }
+        // With every slot busy, further connections wait in the listen
+        // backlog instead of being refused.
+        fds[0] = { g_metrics.listener, static_cast<SHORT>(count <= kMaxClients ? POLLRDNORM : 0), 0 };
+
+        const int ready = WSAPoll(fds, count, kPollIntervalMs);
+        const uint64_t now_ms = GetTickCount64();
+        for (ULONG i = 1; ready > 0 && i < count; ++i)
+        {
+            Client& client = *polled[i];
+            if (fds[i].revents & (POLLERR | POLLNVAL))
+            {
+                FailClient(client);
+            }
+            else if (fds[i].revents)
+            {
+                client.sending ? Send(client) : Receive(client);
+            }
+        }
+        if (ready > 0 && (fds[0].revents & POLLRDNORM))
+        {
+            Accept(now_ms);
+        }
+
+        for (Client& client : g_metrics.clients)
+        {
+            if (client.socket != INVALID_SOCKET && now_ms >= client.deadline_ms)
+            {
+                FailClient(client);
+            }
+        }
+    }
+    return 0;
+}
+
+// Binds the listener to 127.0.0.1:port; port 0 picks a free one.
+SOCKET OpenListener(uint16_t port)
+{
+    const SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET)
+    {
+        return INVALID_SOCKET;
+    }
+
+    BOOL exclusive = TRUE;
+    setsockopt(listener, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, reinterpret_cast<const char*>(&exclusive), sizeof(exclusive));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    u_long nonblocking = 1;
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0 || ioctlsocket(listener, FIONBIO, &nonblocking) != 0)
+    {
+        closesocket(listener);
+        return INVALID_SOCKET;
+    }
+    return listener;
+}
+
+void CloseMetrics()
+{
+    for (Client& client : g_metrics.clients)
+    {
+        CloseClient(client);
+    }
+    if (g_metrics.listener != INVALID_SOCKET)
+    {
+        closesocket(g_metrics.listener);
+        g_metrics.listener = INVALID_SOCKET;
+    }
+    if (g_metrics.wsa_started)
+    {
+        WSACleanup();
+        g_metrics.wsa_started = false;
+    }
+}
+
+} // namespace
+
+// Serves http://127.0.0.1:port/metrics until rm_metrics_stop. The endpoint
+// answers 503 until the first snapshot is published after the start.
+// Returns RM_STATUS_IO_FAILED if the port cannot be bound.
+extern "C" int rm_metrics_start(unsigned int port)
+{
+    if (g_metrics.thread || port > 0xFFFF)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    try
+    {
+        g_metrics.aggregates.reset(new RMAggregateSnapshot());
+        g_metrics.sdk_stats.reset(new RMStats());
+        g_metrics.body.reserve(kInitialResponseBytes);
+        g_metrics.staging.reserve(kInitialResponseBytes);
+        g_metrics.published.reserve(kInitialResponseBytes);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    g_metrics.published.clear();
+
+    WSADATA wsa{};
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+    {
+        return RM_STATUS_IO_FAILED;
+    }
+    g_metrics.wsa_started = true;
+    g_metrics.listener = OpenListener(static_cast<uint16_t>(port));
+    if (g_metrics.listener == INVALID_SOCKET)
+    {
+        CloseMetrics();
+        return RM_STATUS_IO_FAILED;
+    }
+    sockaddr_in bound{};
+    int bound_size = sizeof(bound);
+    getsockname(g_metrics.listener, reinterpret_cast<sockaddr*>(&bound), &bound_size);
+
+    AcquireSRWLockExclusive(&g_metrics.stats_lock);
+    g_metrics.stats = {};
+    g_metrics.stats.port = ntohs(bound.sin_port);
+    ReleaseSRWLockExclusive(&g_metrics.stats_lock);
+
+    g_metrics.stop.store(false, std::memory_order_relaxed);
+    g_metrics.thread = CreateThread(nullptr, 0, MetricsThreadProc, nullptr, 0, nullptr);
+    if (!g_metrics.thread)
+    {
+        CloseMetrics();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    const int status = rm_hub_register_sink(OnSnapshot, nullptr, &g_metrics.sink_id);
+    if (status != RM_STATUS_OK)
+    {
+        g_metrics.stop.store(true, std::memory_order_release);
+        WaitForSingleObject(g_metrics.thread, INFINITE);
+        CloseHandle(g_metrics.thread);
+        g_metrics.thread = nullptr;
+        CloseMetrics();
+        return status;
+    }
+    return RM_STATUS_OK;
+}
+
+// Stops rendering, closes the listener and drops any client mid-request.
+extern "C" void rm_metrics_stop()
+{
+    if (!g_metrics.thread)
+    {
+        return;
+    }
+
+    rm_hub_unregister_sink(g_metrics.sink_id);
+    g_metrics.sink_id = 0;
+    g_metrics.stop.store(true, std::memory_order_release);
+    WaitForSingleObject(g_metrics.thread, INFINITE);
+    CloseHandle(g_metrics.thread);
+    g_metrics.thread = nullptr;
+    CloseMetrics();
+}
+
+extern "C" int rm_metrics_stats(RMMetricsStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    AcquireSRWLockShared(&g_metrics.stats_lock);
+    *stats = g_metrics.stats;
+    ReleaseSRWLockShared(&g_metrics.stats_lock);
+    stats->running = g_metrics.thread != nullptr;
+    return RM_STATUS_OK;
+}
@@ -0,0 +1,1090 @@
+// Binary telemetry recorder: appends every published RMCpuSnapshot to
+// memory-mapped, append-only segment files and scans them back by time window.
+//
+// Segment file (<dir>\rm-YYYYMMDD-HHMMSS-NNNN.rmlog, UTC):
+//   SegmentHeader, then (BlockHeader, payload padded to 8 bytes) up to
+//   committed_bytes.
+// A block holds up to kBlockSamples consecutive samples stored column by
+// column: each column lists one field for every sample of the block as LEB128
+// varints of the change from the previous sample. Counters and timestamps use
+// a zigzag delta; measurements use the XOR of the raw bits, byte-reversed so
+// that quantized readings (which differ only in their high mantissa bytes)
+// encode short and unchanged values take a single byte. The first sample of a
+// block is encoded against zero, so every block decodes on its own and a range
+// scan can skip blocks by header alone.
+//
+// Segments are preallocated to max_segment_bytes and truncated on close. After
+// a crash the file keeps its full size, but committed_bytes still marks the end
+// of the last complete block.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Clock.hpp"
+#include "CoreReduce.hpp"
+#include "Recorder.hpp"
+#include "SubmitQueue.hpp"
+
+namespace {
+
+constexpr uint32_t kSegmentMagic = 0x4C544D52; // "RMTL"
+constexpr uint32_t kSegmentVersion = 1;
+constexpr uint32_t kBlockMagic = 0x4B424D52; // "RMBK"
+constexpr uint32_t kQueueCapacity = 64;
+constexpr uint32_t kBlockSamples = 64;
+constexpr uint64_t kBlockMaxSpanMs = 5000;
+constexpr uint64_t kDefaultSegmentBytes = 64ull << 20;
+constexpr uint64_t kMinSegmentBytes = 4ull << 20;
+constexpr uint32_t kDefaultSegmentSeconds = 3600;
+constexpr uint32_t kSegmentNameAttempts = 16;
+constexpr wchar_t kSegmentPattern[] = L"rm-*.rmlog";
+
+struct SegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t snapshot_size;
+    uint64_t created_utc_ms;
+    uint64_t created_tick_ms;
+    // Offset just past the last complete block. Written after the block and
+    // the fields below, so a reader that loads it first sees them up to date.
+    volatile LONG64 committed_bytes;
+    uint64_t first_timestamp_ms;
+    uint64_t last_timestamp_ms;
+    uint64_t block_count;
+};
+
+struct BlockHeader
+{
+    uint32_t magic;
+    uint32_t payload_bytes;
+    uint32_t sample_count;
+    uint32_t core_count;
+    uint64_t first_timestamp_ms;
+    uint64_t last_timestamp_ms;
+};
+
+enum ColumnEncoding : uint8_t
+{
+    kColumnDelta,
+    kColumnXor
+};
+
+struct Column
+{
+    uint16_t offset;
+    uint8_t size;
+    ColumnEncoding encoding;
+};
+
+#define RM_COLUMN(field, encoding) \
+    { static_cast<uint16_t>(offsetof(RMCpuSnapshot, field)), static_cast<uint8_t>(sizeof(RMCpuSnapshot::field)), encoding }
+
+// Scalar fields in file order. Appending is compatible; reordering is not.
+constexpr Column kScalarColumns[] = {
+    RM_COLUMN(cursor, kColumnDelta),
+    RM_COLUMN(timestamp_ms, kColumnDelta),
+    RM_COLUMN(status, kColumnXor),
+    RM_COLUMN(oc_mode, kColumnXor),
+    RM_COLUMN(core_count, kColumnXor),
+    RM_COLUMN(core_fields, kColumnXor),
+    RM_COLUMN(temperature_c, kColumnXor),
+    RM_COLUMN(power_w, kColumnXor),
+    RM_COLUMN(usage_percent, kColumnXor),
+    RM_COLUMN(package_temperature_c, kColumnXor),
+    RM_COLUMN(peak_core_voltage, kColumnXor),
+    RM_COLUMN(peak_core_voltage_1, kColumnXor),
+    RM_COLUMN(soc_voltage, kColumnXor),
+    RM_COLUMN(avg_core_voltage, kColumnXor),
+    RM_COLUMN(avg_core_voltage_1, kColumnXor),
+    RM_COLUMN(peak_speed_mhz, kColumnXor),
+    RM_COLUMN(ppt_limit_w, kColumnXor),
+    RM_COLUMN(ppt_value_w, kColumnXor),
+    RM_COLUMN(tdc_limit_vdd_a, kColumnXor),
+    RM_COLUMN(tdc_value_vdd_a, kColumnXor),
+    RM_COLUMN(tdc_value_vdd_1_a, kColumnXor),
+    RM_COLUMN(edc_limit_vdd_a, kColumnXor),
+    RM_COLUMN(edc_value_vdd_a, kColumnXor),
+    RM_COLUMN(edc_value_vdd_1_a, kColumnXor),
+    RM_COLUMN(chtc_limit_c, kColumnXor),
+    RM_COLUMN(fclk_p0_freq_mhz, kColumnXor),
+    RM_COLUMN(cclk_fmax_mhz, kColumnXor),
+    RM_COLUMN(tdc_limit_soc_a, kColumnXor),
+    RM_COLUMN(tdc_value_soc_a, kColumnXor),
+    RM_COLUMN(edc_limit_soc_a, kColumnXor),
+    RM_COLUMN(edc_value_soc_a, kColumnXor),
+    RM_COLUMN(vddcr_vdd_power_w, kColumnXor),
+    RM_COLUMN(vddcr_soc_power_w, kColumnXor),
+    RM_COLUMN(tdc_limit_ccd_a, kColumnXor),
+    RM_COLUMN(tdc_value_ccd_a, kColumnXor),
+    RM_COLUMN(edc_limit_ccd_a, kColumnXor),
+    RM_COLUMN(edc_value_ccd_a, kColumnXor),
+};
+
+#undef RM_COLUMN
+
+// Per-core arrays; each contributes one column per core in the block.
+constexpr size_t kCoreArrays[] = {
+    offsetof(RMCpuSnapshot, core_freq_mhz),
+    offsetof(RMCpuSnapshot, core_residency),
+    offsetof(RMCpuSnapshot, core_current_freq_mhz),
+    offsetof(RMCpuSnapshot, core_temp_c),
+};
+
+constexpr size_t kMaxVarintBytes = 10;
+constexpr size_t kMaxColumns = sizeof(kScalarColumns) / sizeof(kScalarColumns[0]) + RM_MAX_CORES * (sizeof(kCoreArrays) / sizeof(kCoreArrays[0]));
+constexpr size_t kMaxPayloadBytes = kBlockSamples * kMaxColumns * kMaxVarintBytes;
+
+size_t AlignUp8(size_t value)
+{
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+uint64_t LoadBits(const RMCpuSnapshot& snapshot, size_t offset, size_t size)
+{
+    uint64_t value = 0;
+    memcpy(&value, reinterpret_cast<const uint8_t*>(&snapshot) + offset, size);
+    return value;
+}
+
+void StoreBits(RMCpuSnapshot& snapshot, size_t offset, size_t size, uint64_t value)
+{
+    memcpy(reinterpret_cast<uint8_t*>(&snapshot) + offset, &value, size);
+}
+
+uint64_t ReverseBytes(uint64_t value, size_t size)
+{
+    uint64_t reversed = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        reversed = (reversed << 8) | (value & 0xFF);
+        value >>= 8;
+    }
+    return reversed;
+}
+
+uint64_t EncodeValue(uint64_t current, uint64_t previous, size_t size, ColumnEncoding encoding)
+{
+    if (encoding == kColumnDelta)
+    {
+        const int64_t delta = static_cast<int64_t>(current - previous);
+        return (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+    }
+    return ReverseBytes(current ^ previous, size);
+}
+
+uint64_t DecodeValue(uint64_t encoded, uint64_t previous, size_t size, ColumnEncoding encoding)
+{
+    if (encoding == kColumnDelta)
+    {
+        const uint64_t delta = (encoded >> 1) ^ (0 - (encoded & 1));
+        return previous + delta;
+    }
+    return ReverseBytes(encoded, size) ^ previous;
+}
+
+uint8_t* PutVarint(uint8_t* out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+bool GetVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && in < end; shift += 7)
+    {
+        const uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Calls fn(offset, size, encoding) for every column of a block, in file order.
+template <typename Fn>
+bool ForEachColumn(uint32_t core_count, Fn&& fn)
+{
+    for (const Column& column : kScalarColumns)
+    {
+        if (!fn(column.offset, column.size, column.encoding))
+        {
+            return false;
+        }
+    }
+    for (size_t base : kCoreArrays)
+    {
+        for (uint32_t core = 0; core < core_count; ++core)
+        {
+            if (!fn(base + core * sizeof(double), sizeof(double), kColumnXor))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t EncodeBlock(const RMCpuSnapshot* samples, uint32_t count, uint32_t core_count, uint8_t* out)
+{
+    uint8_t* cursor = out;
+    ForEachColumn(core_count, [&](size_t offset, size_t size, ColumnEncoding encoding)
+    {
+        uint64_t previous = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint64_t current = LoadBits(samples[i], offset, size);
+            cursor = PutVarint(cursor, EncodeValue(current, previous, size, encoding));
+            previous = current;
+        }
+        return true;
+    });
+    return static_cast<size_t>(cursor - out);
+}
+
+bool DecodeBlock(const uint8_t* in, size_t size, uint32_t count, uint32_t core_count, RMCpuSnapshot* samples)
+{
+    const uint8_t* end = in + size;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        samples[i] = {};
+    }
+
+    return ForEachColumn(core_count, [&](size_t offset, size_t field_size, ColumnEncoding encoding)
+    {
+        uint64_t previous = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t encoded = 0;
+            if (!GetVarint(in, end, encoded))
+            {
+                return false;
+            }
+            previous = DecodeValue(encoded, previous, field_size, encoding);
+            StoreBits(samples[i], offset, field_size, previous);
+        }
+        return true;
+    });
+}
+
+uint64_t UtcNowMs()
+{
+    FILETIME now{};
+    GetSystemTimeAsFileTime(&now);
+    const uint64_t ticks = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    // FILETIME counts 100 ns intervals since 1601-01-01.
+    return (ticks - 116444736000000000ull) / 10000;
+}
+
+uint64_t ThreadCpuMicroseconds(HANDLE thread)
+{
+    FILETIME creation{};
+    FILETIME exit{};
+    FILETIME kernel{};
+    FILETIME user{};
+    if (!thread || !GetThreadTimes(thread, &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    const uint64_t kernel_100ns = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const uint64_t user_100ns = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernel_100ns + user_100ns) / 10;
+}
+
+struct RecorderState
+{
+    HANDLE thread = nullptr;
+    HANDLE stop_event = nullptr;
+    HANDLE data_event = nullptr;
+    std::wstring directory;
+    uint64_t max_segment_bytes = 0;
+    uint64_t max_segment_ms = 0;
+
+    // Heap slots: a snapshot is several KB, too many to keep in static data.
+    RMCpuSnapshot* queue_slots = nullptr;
+    SubmitQueue<RMCpuSnapshot, kQueueCapacity> queue;
+
+    // Recorder thread only.
+    RMCpuSnapshot* block = nullptr;
+    uint32_t block_count = 0;
+    uint8_t* scratch = nullptr;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    uint8_t* view = nullptr;
+    uint32_t segment_seq = 0;
+
+    SRWLOCK stats_lock = SRWLOCK_INIT;
+    RMRecorderStats stats = {};
+};
+
+static RecorderState g_recorder;
+
+SegmentHeader* Segment()
+{
+    return reinterpret_cast<SegmentHeader*>(g_recorder.view);
+}
+
+void CloseSegment()
+{
+    uint64_t committed = 0;
+    if (g_recorder.view)
+    {
+        committed = static_cast<uint64_t>(Segment()->committed_bytes);
+        FlushViewOfFile(g_recorder.view, static_cast<SIZE_T>(committed));
+        UnmapViewOfFile(g_recorder.view);
+        g_recorder.view = nullptr;
+    }
+    if (g_recorder.mapping)
+    {
+        CloseHandle(g_recorder.mapping);
+        g_recorder.mapping = nullptr;
+    }
+    if (g_recorder.file != INVALID_HANDLE_VALUE)
+    {
+        // Drop the unused preallocated tail.
+        if (committed)
+        {
+            LARGE_INTEGER end{};
+            end.QuadPart = static_cast<LONGLONG>(committed);
+            if (SetFilePointerEx(g_recorder.file, end, nullptr, FILE_BEGIN))
+            {
+                SetEndOfFile(g_recorder.file);
+            }
+        }
+        CloseHandle(g_recorder.file);
+        g_recorder.file = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool OpenSegment()
+{
+    SYSTEMTIME now{};
+    GetSystemTime(&now);
+
+    for (uint32_t attempt = 0; attempt < kSegmentNameAttempts; ++attempt)
+    {
+        wchar_t name[64] = {};
+        swprintf_s(name, L"rm-%04u%02u%02u-%02u%02u%02u-%04u.rmlog",
+            now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond,
+            g_recorder.segment_seq++ % 10000);
+        const std::wstring path = g_recorder.directory + L"\\" + name;
+        g_recorder.file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (g_recorder.file != INVALID_HANDLE_VALUE || GetLastError() != ERROR_FILE_EXISTS)
+        {
+            break;
+        }
+    }
+    if (g_recorder.file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    const uint64_t size = g_recorder.max_segment_bytes;
+    g_recorder.mapping = CreateFileMappingW(g_recorder.file, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (g_recorder.mapping)
+    {
+        g_recorder.view = static_cast<uint8_t*>(MapViewOfFile(g_recorder.mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)));
+    }
+    if (!g_recorder.view)
+    {
+        CloseSegment();
+        return false;
+    }
+
+    SegmentHeader* segment = Segment();
+    segment->magic = kSegmentMagic;
+    segment->version = kSegmentVersion;
+    segment->header_size = static_cast<uint32_t>(AlignUp8(sizeof(SegmentHeader)));
+    segment->snapshot_size = sizeof(RMCpuSnapshot);
+    segment->created_utc_ms = UtcNowMs();
+    segment->created_tick_ms = GetTickCount64();
+    segment->first_timestamp_ms = 0;
+    segment->last_timestamp_ms = 0;
+    segment->block_count = 0;
+    InterlockedExchange64(&segment->committed_bytes, segment->header_size);
+
+    AcquireSRWLockExclusive(&g_recorder.stats_lock);
+    g_recorder.stats.segments_opened++;
+    ReleaseSRWLockExclusive(&g_recorder.stats_lock);
+    return true;
+}
+
+bool WriteBlock(const BlockHeader& header, const uint8_t* payload)
+{
+    const uint64_t needed = sizeof(BlockHeader) + AlignUp8(header.payload_bytes);
+    if (g_recorder.view)
+    {
+        const SegmentHeader* segment = Segment();
+        const bool full = static_cast<uint64_t>(segment->committed_bytes) + needed > g_recorder.max_segment_bytes;
+        const bool expired = GetTickCount64() - segment->created_tick_ms >= g_recorder.max_segment_ms;
+        if (full || expired)
+        {
+            CloseSegment();
+        }
+    }
+    if (!g_recorder.view && !OpenSegment())
+    {
+        return false;
+    }
+
+    SegmentHeader* segment = Segment();
+    const uint64_t committed = static_cast<uint64_t>(segment->committed_bytes);
+    if (committed + needed > g_recorder.max_segment_bytes)
+    {
+        return false;
+    }
+
+    uint8_t* out = g_recorder.view + committed;
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), payload, header.payload_bytes);
+    if (segment->block_count == 0)
+    {
+        segment->first_timestamp_ms = header.first_timestamp_ms;
+    }
+    segment->last_timestamp_ms = header.last_timestamp_ms;
+    segment->block_count++;
+    InterlockedExchange64(&segment->committed_bytes, static_cast<LONG64>(committed + needed));
+    return true;
+}
+
+void FlushBlock()
+{
+    const uint32_t count = g_recorder.block_count;
+    if (count == 0)
+    {
+        return;
+    }
+    g_recorder.block_count = 0;
+
+    const RMCpuSnapshot* samples = g_recorder.block;
+    const LONGLONG start = QpcNow();
+    BlockHeader header{};
+    header.magic = kBlockMagic;
+    header.sample_count = count;
+    header.core_count = std::min<uint32_t>(samples[0].core_count, RM_MAX_CORES);
+    header.first_timestamp_ms = samples[0].timestamp_ms;
+    header.last_timestamp_ms = samples[count - 1].timestamp_ms;
+    header.payload_bytes = static_cast<uint32_t>(EncodeBlock(samples, count, header.core_count, g_recorder.scratch));
+    const uint64_t encode_us = QpcToMicroseconds(QpcNow() - start);
+
+    const bool written = WriteBlock(header, g_recorder.scratch);
+
+    AcquireSRWLockExclusive(&g_recorder.stats_lock);
+    RMRecorderStats& stats = g_recorder.stats;
+    if (written)
+    {
+        stats.samples_written += count;
+        stats.blocks_written++;
+        stats.bytes_written += sizeof(BlockHeader) + AlignUp8(header.payload_bytes);
+        stats.raw_bytes += static_cast<uint64_t>(count) * sizeof(RMCpuSnapshot);
+    }
+    else
+    {
+        stats.write_errors++;
+        stats.samples_dropped += count;
+    }
+    stats.max_block_encode_us = std::max(stats.max_block_encode_us, encode_us);
+    ReleaseSRWLockExclusive(&g_recorder.stats_lock);
+}
+
+void AppendSample(const RMCpuSnapshot& snapshot)
+{
+    if (g_recorder.block_count)
+    {
+        const RMCpuSnapshot& first = g_recorder.block[0];
+        const RMCpuSnapshot& last = g_recorder.block[g_recorder.block_count - 1];
+        if (snapshot.core_count != first.core_count ||
+            snapshot.timestamp_ms < last.timestamp_ms ||
+            snapshot.timestamp_ms - first.timestamp_ms >= kBlockMaxSpanMs)
+        {
+            FlushBlock();
+        }
+    }
+
+    g_recorder.block[g_recorder.block_count++] = snapshot;
+    if (g_recorder.block_count == kBlockSamples)
+    {
+        FlushBlock();
+    }
+}
+
+void DrainQueue()
+{
+    g_recorder.queue.Drain(AppendSample);
+}
+
+DWORD WINAPI RecorderThreadProc(LPVOID)
+{
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    const HANDLE handles[2] = { g_recorder.stop_event, g_recorder.data_event };
+    for (;;)
+    {
+        DWORD wait = WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(kBlockMaxSpanMs));
+        DrainQueue();
+        if (wait == WAIT_TIMEOUT)
+        {
+            // Sampling paused: persist the partial block rather than hold it.
+            FlushBlock();
+        }
+        else if (wait != WAIT_OBJECT_0 + 1)
+        {
+            break;
+        }
+    }
+
+    DrainQueue();
+    FlushBlock();
+    CloseSegment();
+    return 0;
+}
+
+void FreeRecorderBuffers()
+{
+    delete[] g_recorder.queue_slots;
+    delete[] g_recorder.block;
+    delete[] g_recorder.scratch;
+    g_recorder.queue_slots = nullptr;
+    g_recorder.block = nullptr;
+    g_recorder.scratch = nullptr;
+    g_recorder.block_count = 0;
+}
+
+void CloseRecorderEvents()
+{
+    if (g_recorder.stop_event)
+    {
+        CloseHandle(g_recorder.stop_event);
+        g_recorder.stop_event = nullptr;
+    }
+    if (g_recorder.data_event)
+    {
+        CloseHandle(g_recorder.data_event);
+        g_recorder.data_event = nullptr;
+    }
+}
+
+// Synthetic sample `index` for rm_recorder_bench: slow drifts quantized to the
+// steps the SDK reports in, plus a little noise, so the encoder sees data
+// shaped like a live capture rather than constants or white noise.
+void FillBenchSnapshot(RMCpuSnapshot& snapshot, uint32_t core_count, uint64_t index)
+{
+    uint64_t seed = index * 0x9E3779B97F4A7C15ull;
+    auto noise = [&seed]()
+    {
+        seed ^= seed >> 29;
+        seed *= 0xBF58476D1CE4E5B9ull;
+        seed ^= seed >> 32;
+        return static_cast<int>(seed % 5) - 2;
+    };
+    auto step = [](double value, double quantum) { return static_cast<int64_t>(value / quantum) * quantum; };
+
+    const double load = static_cast<double>((index / 250) % 40) / 40.0;
+    snapshot.cursor = index;
+    snapshot.timestamp_ms = 0;
+    snapshot.core_count = core_count;
+    snapshot.core_fields = RM_CORE_FIELD_FREQ | RM_CORE_FIELD_RESIDENCY | RM_CORE_FIELD_CURRENT_FREQ | RM_CORE_FIELD_TEMP;
+    snapshot.temperature_c = step(50.0 + 30.0 * load + 0.125 * noise(), 0.125);
+    snapshot.package_temperature_c = snapshot.temperature_c;
+    snapshot.power_w = step(25.0 + 80.0 * load + 0.5 * noise(), 0.001);
+    snapshot.usage_percent = step(100.0 * load, 0.01);
+    snapshot.peak_core_voltage = step(0.9 + 0.4 * load, 0.00625);
+    snapshot.avg_core_voltage = snapshot.peak_core_voltage - 0.025;
+    snapshot.soc_voltage = 1.1;
+    snapshot.peak_speed_mhz = step(3600.0 + 1600.0 * load, 25.0);
+    for (uint32_t i = 0; i < core_count; ++i)
+    {
+        const bool idle = (i + index / 500) % 5 == 0;
+        snapshot.core_freq_mhz[i] = idle ? 0.0 : step(3000.0 + 2000.0 * load + 25.0 * noise(), 25.0);
+        snapshot.core_current_freq_mhz[i] = snapshot.core_freq_mhz[i];
+        snapshot.core_residency[i] = idle ? 0.0 : step(100.0 * load + 0.5 * noise(), 0.01);
+        snapshot.core_temp_c[i] = step(snapshot.temperature_c - 5.0 + (i % 8) + 0.125 * noise(), 0.125);
+    }
+}
+
+// Deletes the segments rm_recorder_bench wrote, then the directory itself.
+void RemoveRecording(const std::wstring& directory)
+{
+    const std::wstring base = directory + L"\\";
+    WIN32_FIND_DATAW data{};
+    HANDLE find = FindFirstFileW((base + kSegmentPattern).c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            DeleteFileW((base + data.cFileName).c_str());
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+    RemoveDirectoryW(directory.c_str());
+}
+
+} // namespace
+
+void RecorderSubmit(const RMCpuSnapshot& snapshot)
+{
+    g_recorder.queue.TryPush([&snapshot](RMCpuSnapshot& slot)
+    {
+        slot = snapshot;
+        if (!slot.timestamp_ms)
+        {
+            slot.timestamp_ms = GetTickCount64();
+        }
+    });
+}
+
+// Starts recording every snapshot passed to rm_ipc_publish_snapshot into
+// `directory`. A segment is closed and a new one started once it reaches
+// max_segment_bytes or is max_segment_seconds old; 0 selects 64 MiB / 1 hour.
+extern "C" int rm_recorder_start(const wchar_t* directory, unsigned long long max_segment_bytes, unsigned int max_segment_seconds)
+{
+    if (!directory || !*directory || g_recorder.thread)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    if (!CreateDirectoryW(directory, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        return RM_STATUS_IO_FAILED;
+    }
+    const DWORD attributes = GetFileAttributesW(directory);
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return RM_STATUS_IO_FAILED;
+    }
+
+    try
+    {
+        g_recorder.directory = directory;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    g_recorder.max_segment_bytes = std::max<uint64_t>(max_segment_bytes ? max_segment_bytes : kDefaultSegmentBytes, kMinSegmentBytes);
+    g_recorder.max_segment_ms = static_cast<uint64_t>(max_segment_seconds ? max_segment_seconds : kDefaultSegmentSeconds) * 1000;
+
+    g_recorder.queue_slots = new (std::nothrow) RMCpuSnapshot[kQueueCapacity];
+    g_recorder.block = new (std::nothrow) RMCpuSnapshot[kBlockSamples];
+    g_recorder.scratch = new (std::nothrow) uint8_t[kMaxPayloadBytes];
+    g_recorder.stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    g_recorder.data_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!g_recorder.queue_slots || !g_recorder.block || !g_recorder.scratch || !g_recorder.stop_event || !g_recorder.data_event)
+    {
+        FreeRecorderBuffers();
+        CloseRecorderEvents();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    AcquireSRWLockExclusive(&g_recorder.stats_lock);
+    g_recorder.stats = {};
+    ReleaseSRWLockExclusive(&g_recorder.stats_lock);
+    g_recorder.queue.Attach(g_recorder.queue_slots, g_recorder.data_event);
+
+    g_recorder.thread = CreateThread(nullptr, 0, RecorderThreadProc, nullptr, 0, nullptr);
+    if (!g_recorder.thread)
+    {
+        FreeRecorderBuffers();
+        CloseRecorderEvents();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    g_recorder.queue.Open();
+    return RM_STATUS_OK;
+}
+
+// Stops accepting samples, writes out everything queued and closes the
+// current segment.
+extern "C" void rm_recorder_stop()
+{
+    if (!g_recorder.thread)
+    {
+        return;
+    }
+
+    // The thread drains whatever was accepted before Close returned.
+    g_recorder.queue.Close();
+    SetEvent(g_recorder.stop_event);
+    WaitForSingleObject(g_recorder.thread, INFINITE);
+
+    const uint64_t cpu_us = ThreadCpuMicroseconds(g_recorder.thread);
+    AcquireSRWLockExclusive(&g_recorder.stats_lock);
+    g_recorder.stats.writer_cpu_us = cpu_us;
+    g_recorder.stats.samples_dropped += g_recorder.queue.TakeDropped();
+    ReleaseSRWLockExclusive(&g_recorder.stats_lock);
+
+    CloseHandle(g_recorder.thread);
+    g_recorder.thread = nullptr;
+    CloseRecorderEvents();
+    FreeRecorderBuffers();
+}
+
+extern "C" int rm_recorder_stats(RMRecorderStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    AcquireSRWLockShared(&g_recorder.stats_lock);
+    *stats = g_recorder.stats;
+    ReleaseSRWLockShared(&g_recorder.stats_lock);
+
+    stats->samples_dropped += g_recorder.queue.Dropped();
+    if (g_recorder.thread)
+    {
+        stats->writer_cpu_us = ThreadCpuMicroseconds(g_recorder.thread);
+        stats->running = 1;
+    }
+    return RM_STATUS_OK;
+}
+
+// Records synthetic snapshots through RecorderSubmit into a fresh directory
+// under %TEMP%, which is removed afterwards, to measure what the writer thread
+// costs at a given sampling rate. Fails if a recording is already running.
+extern "C" int rm_recorder_bench(const RMRecorderBenchConfig* config, RMRecorderBenchStats* stats)
+{
+    if (!config || !stats || config->duration_ms == 0 || config->core_count == 0 ||
+        config->core_count > RM_MAX_CORES || g_recorder.thread)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    std::unique_ptr<RMCpuSnapshot> snapshot(new (std::nothrow) RMCpuSnapshot());
+    if (!snapshot)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    wchar_t temp[MAX_PATH] = {};
+    const DWORD length = GetTempPathW(MAX_PATH, temp);
+    if (length == 0 || length >= MAX_PATH)
+    {
+        return RM_STATUS_IO_FAILED;
+    }
+    wchar_t name[64] = {};
+    swprintf_s(name, L"rm-recorder-bench-%lu-%llu", GetCurrentProcessId(), GetTickCount64());
+    std::wstring directory;
+    try
+    {
+        directory = std::wstring(temp) + name;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    const int status = rm_recorder_start(directory.c_str(), 0, 0);
+    if (status != RM_STATUS_OK)
+    {
+        RemoveDirectoryW(directory.c_str());
+        return status;
+    }
+
+    *stats = {};
+    const LONGLONG interval = config->publish_rate_hz ? std::max<LONGLONG>(QpcFrequency() / config->publish_rate_hz, 1) : 0;
+    const LONGLONG begin = QpcNow();
+    const LONGLONG end = begin + MicrosecondsToQpc(static_cast<uint64_t>(config->duration_ms) * 1000);
+    LONGLONG next = begin;
+    for (;;)
+    {
+        LONGLONG now = QpcNow();
+        if (now >= end)
+        {
+            break;
+        }
+        if (interval)
+        {
+            if (now < next)
+            {
+                SwitchToThread();
+                continue;
+            }
+            next = std::max(next + interval, now);
+        }
+
+        FillBenchSnapshot(*snapshot, config->core_count, stats->submitted);
+        RecorderSubmit(*snapshot);
+        stats->submitted++;
+    }
+    rm_recorder_stop();
+    stats->elapsed_us = QpcToMicroseconds(QpcNow() - begin);
+
+    RMRecorderStats recorder = {};
+    rm_recorder_stats(&recorder);
+    RemoveRecording(directory);
+
+    stats->samples_written = recorder.samples_written;
+    stats->samples_dropped = recorder.samples_dropped;
+    stats->blocks_written = recorder.blocks_written;
+    stats->bytes_written = recorder.bytes_written;
+    stats->raw_bytes = recorder.raw_bytes;
+    stats->writer_cpu_us = recorder.writer_cpu_us;
+    stats->max_block_encode_us = recorder.max_block_encode_us;
+    stats->writer_cpu_percent = stats->elapsed_us ? 100.0 * recorder.writer_cpu_us / stats->elapsed_us : 0.0;
+    stats->compression_ratio = recorder.bytes_written ? static_cast<double>(recorder.raw_bytes) / recorder.bytes_written : 0.0;
+    return recorder.write_errors ? RM_STATUS_IO_FAILED : RM_STATUS_OK;
+}
+
+LogReader::LogReader() = default;
+
+LogReader::~LogReader()
+{
+    CloseSegment();
+}
+
+int LogReader::Open(const wchar_t* directory, uint64_t from_utc_ms, uint64_t to_utc_ms)
+{
+    Rewind();
+    segments_.clear();
+    if (!directory || !*directory || from_utc_ms > to_utc_ms)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+    from_utc_ms_ = from_utc_ms;
+    to_utc_ms_ = to_utc_ms;
+
+    try
+    {
+        samples_.resize(kBlockSamples);
+
+        const std::wstring base = std::wstring(directory) + L"\\";
+        WIN32_FIND_DATAW data{};
+        HANDLE find = FindFirstFileW((base + kSegmentPattern).c_str(), &data);
+        if (find == INVALID_HANDLE_VALUE)
+        {
+            return GetLastError() == ERROR_FILE_NOT_FOUND ? RM_STATUS_OK : RM_STATUS_IO_FAILED;
+        }
+        do
+        {
+            if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            {
+                segments_.push_back(base + data.cFileName);
+            }
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+    catch (const std::bad_alloc&)
+    {
+        segments_.clear();
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    // Names start with the UTC creation time, so name order is time order.
+    std::sort(segments_.begin(), segments_.end());
+    return RM_STATUS_OK;
+}
+
+void LogReader::Rewind()
+{
+    CloseSegment();
+    next_segment_ = 0;
+    sample_count_ = 0;
+    sample_index_ = 0;
+}
+
+bool LogReader::Next(const RMCpuSnapshot*& snapshot, uint64_t& utc_ms)
+{
+    for (;;)
+    {
+        while (sample_index_ < sample_count_)
+        {
+            const RMCpuSnapshot& sample = samples_[sample_index_++];
+            const uint64_t utc = ToUtc(sample.timestamp_ms);
+            if (utc >= from_utc_ms_ && utc <= to_utc_ms_)
+            {
+                snapshot = &sample;
+                utc_ms = utc;
+                return true;
+            }
+        }
+
+        if (LoadBlock())
+        {
+            continue;
+        }
+        CloseSegment();
+        if (next_segment_ >= segments_.size())
+        {
+            return false;
+        }
+        OpenSegment(segments_[next_segment_++]);
+    }
+}
+
+uint64_t LogReader::ToUtc(uint64_t timestamp_ms) const
+{
+    return created_utc_ms_ + static_cast<uint64_t>(static_cast<int64_t>(timestamp_ms - created_tick_ms_));
+}
+
+// Maps a segment read-only. Leaves the reader closed when the segment is
+// unreadable or has nothing inside the window.
+bool LogReader::OpenSegment(const std::wstring& path)
+{
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER file_size{};
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &file_size) ||
+        static_cast<uint64_t>(file_size.QuadPart) < sizeof(SegmentHeader))
+    {
+        CloseSegment();
+        return false;
+    }
+
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_)
+    {
+        view_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!view_)
+    {
+        CloseSegment();
+        return false;
+    }
+
+    // committed_bytes is loaded before the rest of the header; see SegmentHeader.
+    const SegmentHeader* live = reinterpret_cast<const SegmentHeader*>(view_);
+    const uint64_t committed = static_cast<uint64_t>(live->committed_bytes);
+    MemoryBarrier();
+    SegmentHeader header{};
+    memcpy(&header, live, sizeof(header));
+
+    created_utc_ms_ = header.created_utc_ms;
+    created_tick_ms_ = header.created_tick_ms;
+    committed_ = std::min(committed, static_cast<uint64_t>(file_size.QuadPart));
+    offset_ = header.header_size;
+
+    const bool valid = header.magic == kSegmentMagic && header.version == kSegmentVersion &&
+        header.snapshot_size == sizeof(RMCpuSnapshot) && header.header_size >= sizeof(SegmentHeader);
+    const bool overlaps = header.block_count != 0 &&
+        ToUtc(header.last_timestamp_ms) >= from_utc_ms_ &&
+        ToUtc(header.first_timestamp_ms) <= to_utc_ms_;
+    if (!valid || !overlaps)
+    {
+        CloseSegment();
+        return false;
+    }
+    return true;
+}
+
+void LogReader::CloseSegment()
+{
+    if (view_)
+    {
+        UnmapViewOfFile(view_);
+        view_ = nullptr;
+    }
+    if (mapping_)
+    {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    committed_ = 0;
+    offset_ = 0;
+}
+
+// Decodes the next block of the open segment that overlaps the window.
+bool LogReader::LoadBlock()
+{
+    while (view_ && offset_ + sizeof(BlockHeader) <= committed_)
+    {
+        BlockHeader block{};
+        memcpy(&block, view_ + offset_, sizeof(block));
+        const uint64_t payload = offset_ + sizeof(BlockHeader);
+        const uint64_t next = payload + AlignUp8(block.payload_bytes);
+        if (block.magic != kBlockMagic || block.sample_count == 0 || block.sample_count > kBlockSamples ||
+            block.core_count > RM_MAX_CORES || next > committed_)
+        {
+            break;
+        }
+        offset_ = next;
+
+        if (ToUtc(block.last_timestamp_ms) < from_utc_ms_ || ToUtc(block.first_timestamp_ms) > to_utc_ms_)
+        {
+            continue;
+        }
+        if (!DecodeBlock(view_ + payload, block.payload_bytes, block.sample_count, block.core_count, samples_.data()))
+        {
+            break;
+        }
+        // The per-core summary fields are derived, so they are not stored.
+        for (uint32_t i = 0; i < block.sample_count; ++i)
+        {
+            SummarizeSnapshotCores(samples_[i]);
+        }
+        sample_count_ = block.sample_count;
+        sample_index_ = 0;
+        return true;
+    }
+
+    sample_count_ = 0;
+    sample_index_ = 0;
+    return false;
+}
+
+// Calls `callback` for every recorded sample in `directory` whose time falls in
+// [from_utc_ms, to_utc_ms] (milliseconds since the Unix epoch), oldest first.
+// `visited` receives the number of samples delivered.
+extern "C" int rm_log_scan(const wchar_t* directory, unsigned long long from_utc_ms, unsigned long long to_utc_ms,
+    RMLogScanCallback callback, void* user, unsigned long long* visited)
+{
+    if (visited)
+    {
+        *visited = 0;
+    }
+    if (!callback)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    LogReader reader;
+    int status = reader.Open(directory, from_utc_ms, to_utc_ms);
+    if (status != RM_STATUS_OK)
+    {
+        return status;
+    }
+
+    uint64_t count = 0;
+    const RMCpuSnapshot* snapshot = nullptr;
+    uint64_t utc_ms = 0;
+    while (reader.Next(snapshot, utc_ms))
+    {
+        count++;
+        if (callback(snapshot, utc_ms, user) != 0)
+        {
+            break;
+        }
+    }
+
+    if (visited)
+    {
+        *visited = count;
+    }
+    return RM_STATUS_OK;
+}
@@ -0,0 +1,350 @@
+// Replays a recorded telemetry log: as an ICPUEx behind rm_monitor_init, or
+// pushed straight through rm_ipc_publish_snapshot by rm_replay_run with
+// per-stage latency statistics.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "Clock.hpp"
+#include "Recorder.hpp"
+#include "TelemetrySource.hpp"
+
+extern "C" int rm_ipc_publish_snapshot(const RMCpuSnapshot* snapshot);
+
+namespace {
+
+class ReplayCPU final : public ICPUEx
+{
+public:
+    ReplayCPU(double speed, bool loop)
+        : speed_(speed > 0.0 ? speed : 0.0),
+          loop_(loop)
+    {
+    }
+
+    // Returns an RMMonitorStatus code; fails if the window holds no samples.
+    int Open(const wchar_t* directory, uint64_t from_utc_ms, uint64_t to_utc_ms)
+    {
+        int status = reader_.Open(directory, from_utc_ms, to_utc_ms);
+        if (status != RM_STATUS_OK)
+        {
+            return status;
+        }
+        if (!Restart())
+        {
+            return RM_STATUS_READ_FAILED;
+        }
+        core_count_ = pending_->core_count;
+        return RM_STATUS_OK;
+    }
+
+    // Recorded time of the sample the next sequential read returns.
+    bool PeekUtcMs(uint64_t& utc_ms) const
+    {
+        if (!pending_)
+        {
+            return false;
+        }
+        utc_ms = pending_utc_ms_;
+        return true;
+    }
+
+    bool Init(unsigned long) override { return true; }
+    bool UnInit(void) override { return true; }
+    const wchar_t* GetName(void) override { return L"Recorded telemetry"; }
+    const wchar_t* GetDescription(void) override { return L"Replayed telemetry log"; }
+    const wchar_t* GetVendor(void) override { return L"AuthenticAMD"; }
+    const wchar_t* GetRole(void) override { return L"CPU"; }
+    const wchar_t* GetClassName(void) override { return L"Replay"; }
+    AOD_DEVICE_TYPE GetType(void) override { return dtCPU; }
+    unsigned long GetIndex(void) override { return 0; }
+
+    // The log only holds CPUParameters; identification and cache data were
+    // never recorded.
+    int GetL1DataCache(CACHE_INFO&) override { return -1; }
+    int GetL1InstructionCache(CACHE_INFO&) override { return -1; }
+    int GetL2Cache(CACHE_INFO&) override { return -1; }
+    int GetL3Cache(CACHE_INFO&) override { return -1; }
+    int GetCorePark(unsigned int&) override { return -1; }
+    const wchar_t* GetPackage(void) override { return L""; }
+    int GetChipsetName(wchar_t*) override { return -1; }
+    int GetFamily(unsigned long&) override { return -1; }
+    int GetStepping(unsigned long&) override { return -1; }
+    int GetModel(unsigned long&) override { return -1; }
+
+    int GetCoreCount(unsigned int& uVal) override
+    {
+        uVal = core_count_;
+        return 0;
+    }
+
+    int GetCPUParameters(CPUParameters& stInfo) override
+    {
+        if (!(speed_ > 0.0 ? AdvancePaced() : AdvanceSequential()))
+        {
+            return -1;
+        }
+        FillParameters(current_, stInfo);
+        return 0;
+    }
+
+private:
+    bool Restart()
+    {
+        reader_.Rewind();
+        FetchPending();
+        if (!pending_)
+        {
+            return false;
+        }
+        first_utc_ms_ = pending_utc_ms_;
+        start_qpc_ = QpcNow();
+        has_current_ = false;
+        return true;
+    }
+
+    void FetchPending()
+    {
+        if (!reader_.Next(pending_, pending_utc_ms_))
+        {
+            pending_ = nullptr;
+        }
+    }
+
+    bool AdvanceSequential()
+    {
+        if (!pending_ && !(loop_ && Restart()))
+        {
+            return false;
+        }
+        current_ = *pending_;
+        has_current_ = true;
+        FetchPending();
+        return true;
+    }
+
+    // Moves to the latest sample recorded at or before the scaled elapsed time.
+    bool AdvancePaced()
+    {
+        if (!pending_ && loop_)
+        {
+            Restart();
+        }
+
+        const double elapsed_ms = static_cast<double>(QpcNow() - start_qpc_) * 1000.0 / static_cast<double>(QpcFrequency());
+        const double target_utc_ms = static_cast<double>(first_utc_ms_) + elapsed_ms * speed_;
+        bool advanced = false;
+        while (pending_ && static_cast<double>(pending_utc_ms_) <= target_utc_ms)
+        {
+            current_ = *pending_;
+            advanced = true;
+            FetchPending();
+        }
+        has_current_ = has_current_ || advanced;
+        return has_current_ && (advanced || pending_ || loop_);
+    }
+
+    static void FillParameters(const RMCpuSnapshot& snapshot, CPUParameters& stInfo)
+    {
+        stInfo = {};
+        stInfo.eMode.uOCMode = snapshot.oc_mode;
+
+        EffectiveFreqData& freq = stInfo.stFreqData;
+        freq.uLength = snapshot.core_count;
+        freq.dFreq = (snapshot.core_fields & RM_CORE_FIELD_FREQ) ? const_cast<double*>(snapshot.core_freq_mhz) : nullptr;
+        freq.dState = (snapshot.core_fields & RM_CORE_FIELD_RESIDENCY) ? const_cast<double*>(snapshot.core_residency) : nullptr;
+        freq.dCurrentFreq = (snapshot.core_fields & RM_CORE_FIELD_CURRENT_FREQ) ? const_cast<double*>(snapshot.core_current_freq_mhz) : nullptr;
+        freq.dCurrentTemp = (snapshot.core_fields & RM_CORE_FIELD_TEMP) ? const_cast<double*>(snapshot.core_temp_c) : nullptr;
+
+        stInfo.dTemperature = snapshot.package_temperature_c;
+        stInfo.dPeakCoreVoltage = snapshot.peak_core_voltage;
+        stInfo.dPeakCoreVoltage_1 = snapshot.peak_core_voltage_1;
+        stInfo.dSocVoltage = snapshot.soc_voltage;
+        stInfo.dAvgCoreVoltage = snapshot.avg_core_voltage;
+        stInfo.dAvgCoreVoltage_1 = snapshot.avg_core_voltage_1;
+        stInfo.dPeakSpeed = snapshot.peak_speed_mhz;
+
+        stInfo.fPPTLimit = snapshot.ppt_limit_w;
+        stInfo.fPPTValue = snapshot.ppt_value_w;
+        stInfo.fTDCLimit_VDD = snapshot.tdc_limit_vdd_a;
+        stInfo.fTDCValue_VDD = snapshot.tdc_value_vdd_a;
+        stInfo.fTDCValue_VDD_1 = snapshot.tdc_value_vdd_1_a;
+        stInfo.fEDCLimit_VDD = snapshot.edc_limit_vdd_a;
+        stInfo.fEDCValue_VDD = snapshot.edc_value_vdd_a;
+        stInfo.fEDCValue_VDD_1 = snapshot.edc_value_vdd_1_a;
+        stInfo.fcHTCLimit = snapshot.chtc_limit_c;
+        stInfo.fFCLKP0Freq = snapshot.fclk_p0_freq_mhz;
+        stInfo.fCCLK_Fmax = snapshot.cclk_fmax_mhz;
+        stInfo.fTDCLimit_SOC = snapshot.tdc_limit_soc_a;
+        stInfo.fTDCValue_SOC = snapshot.tdc_value_soc_a;
+        stInfo.fEDCLimit_SOC = snapshot.edc_limit_soc_a;
+        stInfo.fEDCValue_SOC = snapshot.edc_value_soc_a;
+        stInfo.fVDDCR_VDD_Power = snapshot.vddcr_vdd_power_w;
+        stInfo.fVDDCR_SOC_Power = snapshot.vddcr_soc_power_w;
+        stInfo.fTDCLimit_CCD = snapshot.tdc_limit_ccd_a;
+        stInfo.fTDCValue_CCD = snapshot.tdc_value_ccd_a;
+        stInfo.fEDCLimit_CCD = snapshot.edc_limit_ccd_a;
+        stInfo.fEDCValue_CCD = snapshot.edc_value_ccd_a;
+    }
+
+    LogReader reader_;
+    double speed_;
+    bool loop_;
+    unsigned int core_count_ = 0;
+    const RMCpuSnapshot* pending_ = nullptr;
+    uint64_t pending_utc_ms_ = 0;
+    uint64_t first_utc_ms_ = 0;
+    LONGLONG start_qpc_ = 0;
+    bool has_current_ = false;
+    RMCpuSnapshot current_ = {};
+};
+
+class ReplaySource final : public TelemetrySource
+{
+public:
+    explicit ReplaySource(std::unique_ptr<ReplayCPU> cpu)
+        : cpu_(std::move(cpu))
+    {
+    }
+
+    ICPUEx* GetCPU() override { return cpu_.get(); }
+    IBIOSEx* GetBIOS() override { return nullptr; }
+
+private:
+    std::unique_ptr<ReplayCPU> cpu_;
+};
+
+// Sleeps until `deadline` on a high-resolution timer when one is available.
+void WaitUntil(HANDLE timer, LONGLONG deadline)
+{
+    LONGLONG remaining = deadline - QpcNow();
+    if (remaining <= 0)
+    {
+        return;
+    }
+
+    LARGE_INTEGER due{};
+    due.QuadPart = -std::max<LONGLONG>(static_cast<LONGLONG>(QpcTo100ns(remaining)), 1);
+    if (timer && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE))
+    {
+        WaitForSingleObject(timer, INFINITE);
+    }
+    else
+    {
+        Sleep(static_cast<DWORD>(QpcToMicroseconds(remaining) / 1000));
+    }
+}
+
+} // namespace
+
+std::unique_ptr<TelemetrySource> CreateReplaySource(const ReplayOptions& options)
+{
+    std::unique_ptr<ReplayCPU> cpu(new (std::nothrow) ReplayCPU(options.speed, options.loop));
+    if (!cpu || cpu->Open(options.directory, options.from_utc_ms, options.to_utc_ms) != RM_STATUS_OK)
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<TelemetrySource>(new (std::nothrow) ReplaySource(std::move(cpu)));
+}
+
+// Publishes every recorded sample in [from_utc_ms, to_utc_ms] over IPC, so all
+// consumers (TM plugin, ryzenmaster-monitor's HID output, aggregators) see the
+// captured workload. speed 1 keeps the recorded timing, N runs N times faster
+// and 0 publishes back to back. Blocks until the window is exhausted.
+extern "C" int rm_replay_run(const wchar_t* directory, unsigned long long from_utc_ms, unsigned long long to_utc_ms,
+    double speed, RMReplayStats* stats)
+{
+    if (!stats || speed < 0.0)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+    *stats = {};
+
+    std::unique_ptr<ReplayCPU> cpu(new (std::nothrow) ReplayCPU(0.0, false));
+    if (!cpu)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    int status = cpu->Open(directory, from_utc_ms, to_utc_ms);
+    if (status != RM_STATUS_OK)
+    {
+        return status;
+    }
+
+    HANDLE timer = nullptr;
+    if (speed > 0.0)
+    {
+        timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!timer)
+        {
+            timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+    }
+
+    try
+    {
+        std::vector<uint64_t> read_ns;
+        std::vector<uint64_t> publish_ns;
+        std::vector<uint64_t> lateness_ns;
+        std::vector<uint64_t> total_ns;
+        std::unique_ptr<RMCpuSnapshot> snapshot(new RMCpuSnapshot());
+
+        uint64_t first_utc_ms = 0;
+        uint64_t utc_ms = 0;
+        cpu->PeekUtcMs(first_utc_ms);
+        const LONGLONG start = QpcNow();
+        while (cpu->PeekUtcMs(utc_ms))
+        {
+            LONGLONG scheduled = QpcNow();
+            if (speed > 0.0)
+            {
+                const double offset_ms = static_cast<double>(utc_ms - first_utc_ms) / speed;
+                scheduled = start + static_cast<LONGLONG>(offset_ms * static_cast<double>(QpcFrequency()) / 1000.0);
+                WaitUntil(timer, scheduled);
+            }
+
+            const LONGLONG read_start = QpcNow();
+            if (!ReadCPUSnapshot(cpu.get(), *snapshot))
+            {
+                break;
+            }
+            snapshot->status = RM_STATUS_OK;
+            snapshot->timestamp_ms = GetTickCount64();
+            const LONGLONG read_end = QpcNow();
+            rm_ipc_publish_snapshot(snapshot.get());
+            const LONGLONG publish_end = QpcNow();
+
+            read_ns.push_back(QpcToNanoseconds(read_end - read_start));
+            publish_ns.push_back(QpcToNanoseconds(publish_end - read_end));
+            lateness_ns.push_back(QpcToNanoseconds(read_start - scheduled));
+            total_ns.push_back(QpcToNanoseconds(publish_end - scheduled));
+        }
+        const LONGLONG elapsed = QpcNow() - start;
+
+        stats->samples = read_ns.size();
+        stats->elapsed_us = QpcToMicroseconds(elapsed);
+        stats->recorded_span_ms = utc_ms - first_utc_ms;
+        stats->samples_per_second = elapsed > 0
+            ? static_cast<double>(stats->samples) * static_cast<double>(QpcFrequency()) / static_cast<double>(elapsed)
+            : 0.0;
+        stats->read = SummarizeLatencies(read_ns);
+        stats->publish = SummarizeLatencies(publish_ns);
+        stats->lateness = SummarizeLatencies(lateness_ns);
+        stats->total = SummarizeLatencies(total_ns);
+    }
+    catch (const std::bad_alloc&)
+    {
+        status = RM_STATUS_ALLOC_FAILED;
+    }
+
+    if (timer)
+    {
+        CloseHandle(timer);
+    }
+    return status;
+}
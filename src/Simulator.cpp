@@ -0,0 +1,448 @@
+// Deterministic ICPUEx simulator: replays per-core frequency, residency,
+// temperature and package power curves without AMD hardware or the driver.
+//
+// Script format (text, one keyframe per line, '#' starts a comment):
+//   cores <count>
+//   sockets <count>
+//   <time_ms> <package_temp_c> <ppt_w> <freq_mhz> <residency_pct> <temp_c> [<freq> <residency> <temp> ...]
+// Each keyframe lists per-core triples starting at core 0; when it lists fewer
+// triples than `cores`, the last triple is repeated. Values are linearly
+// interpolated between keyframes and the script loops after the last one.
+// With more than one socket, every socket is a CPU device of its own with
+// `cores` cores, served through a simulated IDeviceManager; socket N replays
+// the script N * 3 s ahead so the sockets do not move in lockstep.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Clock.hpp"
+#include "GlobalDef.h"
+#include "IDeviceManager.h"
+#include "Sockets.hpp"
+#include "TelemetrySource.hpp"
+
+namespace {
+
+constexpr unsigned int kDefaultCoreCount = 16;
+constexpr unsigned int kMaxSimulatedCores = 512;
+constexpr float kPptLimitW = 230.0f;
+constexpr float kTdcLimitA = 160.0f;
+constexpr float kEdcLimitA = 225.0f;
+constexpr double kSocketPhaseMs = 3000.0;
+
+struct CoreFrame
+{
+    double freq_mhz;
+    double residency;
+    double temp_c;
+};
+
+struct Keyframe
+{
+    double time_ms;
+    double temp_c;
+    double ppt_w;
+    std::vector<CoreFrame> cores;
+};
+
+// Idle, single-thread boost, all-core render, cool-down; 20 s per cycle.
+std::vector<Keyframe> BuildDefaultScript(unsigned int cores)
+{
+    auto uniform = [cores](double time_ms, double temp, double ppt, CoreFrame core)
+    {
+        Keyframe frame{ time_ms, temp, ppt, std::vector<CoreFrame>(cores, core) };
+        for (unsigned int i = 0; i < cores; ++i)
+        {
+            frame.cores[i].temp_c -= (i % 4) * 1.5;
+        }
+        return frame;
+    };
+
+    std::vector<Keyframe> script;
+    script.push_back(uniform(0.0, 42.0, 28.0, { 3600.0, 4.0, 41.0 }));
+    Keyframe boost = uniform(4000.0, 62.0, 55.0, { 3600.0, 6.0, 50.0 });
+    boost.cores[0] = { 5700.0, 100.0, 63.0 };
+    script.push_back(boost);
+    script.push_back(uniform(8000.0, 88.0, 200.0, { 5100.0, 100.0, 87.0 }));
+    script.push_back(uniform(14000.0, 95.0, 200.0, { 4900.0, 100.0, 94.0 }));
+    script.push_back(uniform(16000.0, 55.0, 35.0, { 3600.0, 8.0, 54.0 }));
+    script.push_back(uniform(20000.0, 42.0, 28.0, { 3600.0, 4.0, 41.0 }));
+    return script;
+}
+
+bool LoadScript(const wchar_t* path, std::vector<Keyframe>& script, unsigned int& sockets)
+{
+    std::ifstream file{ std::filesystem::path(path) };
+    if (!file)
+    {
+        return false;
+    }
+
+    unsigned int cores = kDefaultCoreCount;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first))
+        {
+            continue;
+        }
+        if (first == "cores")
+        {
+            if (!(fields >> cores) || cores == 0 || cores > kMaxSimulatedCores || !script.empty())
+            {
+                return false;
+            }
+            continue;
+        }
+        if (first == "sockets")
+        {
+            if (!(fields >> sockets) || sockets == 0 || sockets > RM_MAX_SOCKETS)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        Keyframe frame{};
+        frame.time_ms = std::strtod(first.c_str(), nullptr);
+        if (!(fields >> frame.temp_c >> frame.ppt_w))
+        {
+            return false;
+        }
+        CoreFrame core{};
+        while (fields >> core.freq_mhz >> core.residency >> core.temp_c)
+        {
+            if (frame.cores.size() < cores)
+            {
+                frame.cores.push_back(core);
+            }
+        }
+        if (frame.cores.empty())
+        {
+            return false;
+        }
+        frame.cores.resize(cores, frame.cores.back());
+
+        if (!script.empty() && frame.time_ms <= script.back().time_ms)
+        {
+            return false;
+        }
+        script.push_back(std::move(frame));
+    }
+
+    return !script.empty();
+}
+
+double Lerp(double a, double b, double t)
+{
+    return a + (b - a) * t;
+}
+
+class SimulatedCPU final : public ICPUEx
+{
+public:
+    SimulatedCPU(std::vector<Keyframe> script, double speed, unsigned int step_ms, unsigned long index)
+        : script_(std::move(script)),
+          speed_(speed > 0.0 ? speed : 1.0),
+          step_ms_(step_ms),
+          index_(index),
+          sim_time_ms_(index * kSocketPhaseMs)
+    {
+        const size_t cores = script_.front().cores.size();
+        freq_.resize(cores);
+        residency_.resize(cores);
+        core_temp_.resize(cores);
+        start_qpc_ = QpcNow();
+    }
+
+    bool Init(unsigned long) override { return true; }
+    bool UnInit(void) override { return true; }
+    const wchar_t* GetName(void) override { return L"AMD Ryzen Simulated Processor"; }
+    const wchar_t* GetDescription(void) override { return L"Simulated telemetry source"; }
+    const wchar_t* GetVendor(void) override { return L"AuthenticAMD"; }
+    const wchar_t* GetRole(void) override { return L"CPU"; }
+    const wchar_t* GetClassName(void) override { return L"Simulator"; }
+    AOD_DEVICE_TYPE GetType(void) override { return dtCPU; }
+    unsigned long GetIndex(void) override { return index_; }
+
+    int GetL1DataCache(CACHE_INFO& info) override { return FillCache(info, 32.0, 8.0); }
+    int GetL1InstructionCache(CACHE_INFO& info) override { return FillCache(info, 32.0, 8.0); }
+    int GetL2Cache(CACHE_INFO& info) override { return FillCache(info, 1024.0, 8.0); }
+    int GetL3Cache(CACHE_INFO& info) override { return FillCache(info, 32768.0, 16.0); }
+
+    int GetCoreCount(unsigned int& uVal) override
+    {
+        uVal = static_cast<unsigned int>(freq_.size());
+        return 0;
+    }
+
+    int GetCorePark(unsigned int& uVal) override
+    {
+        uVal = 0;
+        return 0;
+    }
+
+    const wchar_t* GetPackage(void) override { return L"AM5"; }
+
+    int GetCPUParameters(CPUParameters& stInfo) override
+    {
+        Evaluate(NextTimeMs());
+
+        double peak = 0.0;
+        double load = 0.0;
+        for (size_t i = 0; i < freq_.size(); ++i)
+        {
+            peak = std::max(peak, freq_[i]);
+            load += residency_[i];
+        }
+        load = freq_.empty() ? 0.0 : load / (100.0 * freq_.size());
+
+        stInfo = {};
+        stInfo.eMode.uOCMode = 0;
+        stInfo.eMode.uAuto = 1;
+        stInfo.stFreqData.uLength = static_cast<unsigned int>(freq_.size());
+        stInfo.stFreqData.dFreq = freq_.data();
+        stInfo.stFreqData.dState = residency_.data();
+        stInfo.stFreqData.dCurrentFreq = freq_.data();
+        stInfo.stFreqData.dCurrentTemp = core_temp_.data();
+        stInfo.dTemperature = temp_c_;
+        stInfo.dPeakSpeed = peak;
+        stInfo.dPeakCoreVoltage = 0.95 + 0.45 * load;
+        stInfo.dPeakCoreVoltage_1 = stInfo.dPeakCoreVoltage;
+        stInfo.dAvgCoreVoltage = 0.90 + 0.35 * load;
+        stInfo.dAvgCoreVoltage_1 = stInfo.dAvgCoreVoltage;
+        stInfo.dSocVoltage = 1.05;
+
+        const float ppt = static_cast<float>(ppt_w_);
+        const float tdc = ppt / 1.25f;
+        stInfo.fPPTLimit = kPptLimitW;
+        stInfo.fPPTValue = ppt;
+        stInfo.fTDCLimit_VDD = kTdcLimitA;
+        stInfo.fTDCValue_VDD = tdc;
+        stInfo.fTDCValue_VDD_1 = tdc;
+        stInfo.fEDCLimit_VDD = kEdcLimitA;
+        stInfo.fEDCValue_VDD = tdc * 1.3f;
+        stInfo.fEDCValue_VDD_1 = tdc * 1.3f;
+        stInfo.fcHTCLimit = 95.0f;
+        stInfo.fFCLKP0Freq = 2000.0f;
+        stInfo.fCCLK_Fmax = 5750.0f;
+        stInfo.fTDCLimit_SOC = 25.0f;
+        stInfo.fTDCValue_SOC = 8.0f;
+        stInfo.fEDCLimit_SOC = 30.0f;
+        stInfo.fEDCValue_SOC = 10.0f;
+        stInfo.fVDDCR_VDD_Power = ppt * 0.8f;
+        stInfo.fVDDCR_SOC_Power = ppt * 0.1f;
+        return 0;
+    }
+
+    int GetChipsetName(wchar_t* sChipsetName) override
+    {
+        if (sChipsetName)
+        {
+            wcscpy_s(sChipsetName, MAX_STRING_LEN, L"Simulated");
+        }
+        return 0;
+    }
+
+    int GetFamily(unsigned long& uFamily) override
+    {
+        uFamily = 0x19;
+        return 0;
+    }
+
+    int GetStepping(unsigned long& uStepping) override
+    {
+        uStepping = 2;
+        return 0;
+    }
+
+    int GetModel(unsigned long& uModel) override
+    {
+        uModel = 0x61;
+        return 0;
+    }
+
+private:
+    static int FillCache(CACHE_INFO& info, double size_kb, double associativity)
+    {
+        info.fSize = size_kb;
+        info.fAssociativity = associativity;
+        info.fLines = 1.0;
+        info.fLineSize = 64.0;
+        return 0;
+    }
+
+    double NextTimeMs()
+    {
+        if (step_ms_)
+        {
+            double now = sim_time_ms_;
+            sim_time_ms_ += step_ms_;
+            return now;
+        }
+
+        const double elapsed_ms = static_cast<double>(QpcNow() - start_qpc_) * 1000.0 / static_cast<double>(QpcFrequency());
+        return elapsed_ms * speed_ + index_ * kSocketPhaseMs;
+    }
+
+    void Evaluate(double time_ms)
+    {
+        const Keyframe* from = &script_.front();
+        const Keyframe* to = from;
+        double t = 0.0;
+
+        const double duration = script_.back().time_ms;
+        if (script_.size() > 1 && duration > 0.0)
+        {
+            time_ms = std::fmod(time_ms, duration);
+            auto next = std::upper_bound(script_.begin(), script_.end(), time_ms,
+                [](double value, const Keyframe& frame) { return value < frame.time_ms; });
+            if (next == script_.begin())
+            {
+                next = script_.begin() + 1;
+            }
+            if (next == script_.end())
+            {
+                next = script_.end() - 1;
+            }
+            to = &*next;
+            from = &*(next - 1);
+            const double span = to->time_ms - from->time_ms;
+            t = span > 0.0 ? std::clamp((time_ms - from->time_ms) / span, 0.0, 1.0) : 0.0;
+        }
+
+        temp_c_ = Lerp(from->temp_c, to->temp_c, t);
+        ppt_w_ = Lerp(from->ppt_w, to->ppt_w, t);
+        for (size_t i = 0; i < freq_.size(); ++i)
+        {
+            freq_[i] = Lerp(from->cores[i].freq_mhz, to->cores[i].freq_mhz, t);
+            residency_[i] = Lerp(from->cores[i].residency, to->cores[i].residency, t);
+            core_temp_[i] = Lerp(from->cores[i].temp_c, to->cores[i].temp_c, t);
+        }
+    }
+
+    std::vector<Keyframe> script_;
+    double speed_;
+    unsigned int step_ms_;
+    unsigned long index_;
+    double sim_time_ms_;
+    LONGLONG start_qpc_ = 0;
+    double temp_c_ = 0.0;
+    double ppt_w_ = 0.0;
+    std::vector<double> freq_;
+    std::vector<double> residency_;
+    std::vector<double> core_temp_;
+};
+
+// Device manager holding one SimulatedCPU per socket and nothing else.
+class SimulatedDeviceManager final : public IDeviceManager
+{
+public:
+    explicit SimulatedDeviceManager(std::vector<std::unique_ptr<SimulatedCPU>> cpus)
+        : cpus_(std::move(cpus))
+    {
+    }
+
+    bool Init(const char*, bool) override { return true; }
+    bool UnInit(void) override { return true; }
+
+    IDevice* GetDevice(AOD_DEVICE_TYPE eDeviceType, unsigned long uIndex) override
+    {
+        return eDeviceType == dtCPU ? GetDevice(uIndex) : nullptr;
+    }
+
+    IDevice* GetDevice(unsigned long uIndex) override
+    {
+        return uIndex < cpus_.size() ? cpus_[uIndex].get() : nullptr;
+    }
+
+    unsigned long GetDeviceCount(AOD_DEVICE_TYPE eDeviceType) override
+    {
+        return eDeviceType == dtCPU ? GetTotalDeviceCount() : 0;
+    }
+
+    unsigned long GetDeviceCount(const wchar_t*) override { return 0; }
+    unsigned long GetTotalDeviceCount() override { return static_cast<unsigned long>(cpus_.size()); }
+
+private:
+    std::vector<std::unique_ptr<SimulatedCPU>> cpus_;
+};
+
+// Enumerates its sockets the way the SDK source does.
+class SimulatedSource final : public TelemetrySource
+{
+public:
+    explicit SimulatedSource(std::unique_ptr<SimulatedDeviceManager> manager)
+        : manager_(std::move(manager))
+    {
+        cpu_count_ = EnumerateCPUs(*manager_, cpus_, RM_MAX_SOCKETS);
+    }
+
+    ICPUEx* GetCPU() override { return cpus_[0]; }
+    IBIOSEx* GetBIOS() override { return nullptr; }
+    uint32_t GetCPUCount() override { return cpu_count_; }
+    ICPUEx* GetCPUAt(uint32_t index) override { return index < cpu_count_ ? cpus_[index] : nullptr; }
+
+private:
+    std::unique_ptr<SimulatedDeviceManager> manager_;
+    ICPUEx* cpus_[RM_MAX_SOCKETS] = {};
+    uint32_t cpu_count_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<TelemetrySource> CreateSimulatedSource(const SimulatorOptions& options)
+{
+    try
+    {
+        std::vector<Keyframe> script;
+        unsigned int sockets = 1;
+        if (options.script_path && *options.script_path)
+        {
+            if (!LoadScript(options.script_path, script, sockets))
+            {
+                return nullptr;
+            }
+        }
+        else
+        {
+            script = BuildDefaultScript(kDefaultCoreCount);
+        }
+
+        if (options.sockets)
+        {
+            sockets = std::min<unsigned int>(options.sockets, RM_MAX_SOCKETS);
+        }
+
+        std::vector<std::unique_ptr<SimulatedCPU>> cpus;
+        for (unsigned int i = 0; i < sockets; ++i)
+        {
+            cpus.push_back(std::make_unique<SimulatedCPU>(script, options.speed, options.step_ms, i));
+        }
+        auto manager = std::make_unique<SimulatedDeviceManager>(std::move(cpus));
+        return std::make_unique<SimulatedSource>(std::move(manager));
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
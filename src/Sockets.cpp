@@ -0,0 +1,272 @@
+// Multi-socket reads. Dual-socket SP3/SP6 boards expose one CPU device per
+// socket; GetCPUParameters on one device reports only that socket's package,
+// cores and limits.
+//
+// Each extra socket has a worker parked on an auto-reset "go" event. Read
+// points the workers at their output, signals them, reads socket 0 itself and
+// then waits on the "done" events, so the SDK calls overlap without a thread
+// being created per tick.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#include "CoreReduce.hpp"
+#include "Sockets.hpp"
+#include "TelemetrySource.hpp"
+
+namespace {
+
+void ReadSocket(ICPUEx* cpu, RMCpuSnapshot& snapshot)
+{
+    snapshot.cursor = 0;
+    snapshot.status = ReadCPUSnapshot(cpu, snapshot) ? RM_STATUS_OK : RM_STATUS_READ_FAILED;
+    snapshot.timestamp_ms = GetTickCount64();
+}
+
+struct Worker
+{
+    ICPUEx* cpu = nullptr;
+    RMCpuSnapshot* target = nullptr;
+    HANDLE go = nullptr;
+    HANDLE done = nullptr;
+    HANDLE thread = nullptr;
+    const std::atomic<bool>* stop = nullptr;
+};
+
+DWORD WINAPI SocketWorkerProc(LPVOID param)
+{
+    Worker& worker = *static_cast<Worker*>(param);
+    for (;;)
+    {
+        WaitForSingleObject(worker.go, INFINITE);
+        if (worker.stop->load(std::memory_order_acquire))
+        {
+            return 0;
+        }
+        ReadSocket(worker.cpu, *worker.target);
+        SetEvent(worker.done);
+    }
+}
+
+} // namespace
+
+uint32_t EnumerateCPUs(IDeviceManager& manager, ICPUEx** cpus, uint32_t max_cpus)
+{
+    const unsigned long reported = manager.GetDeviceCount(dtCPU);
+    const unsigned long count = std::min<unsigned long>(reported ? reported : 1, max_cpus);
+    uint32_t found = 0;
+    for (unsigned long index = 0; index < count; ++index)
+    {
+        ICPUEx* cpu = (ICPUEx*)manager.GetDevice(dtCPU, index);
+        if (cpu)
+        {
+            cpus[found++] = cpu;
+        }
+    }
+    return found;
+}
+
+struct SocketReader::State
+{
+    ICPUEx* cpu0 = nullptr;
+    uint32_t count = 0;
+    Worker workers[RM_MAX_SOCKETS];
+    HANDLE done[RM_MAX_SOCKETS] = {};
+    std::atomic<bool> stop{ false };
+
+    ~State()
+    {
+        stop.store(true, std::memory_order_release);
+        for (Worker& worker : workers)
+        {
+            if (worker.thread)
+            {
+                SetEvent(worker.go);
+                WaitForSingleObject(worker.thread, INFINITE);
+                CloseHandle(worker.thread);
+            }
+            if (worker.go)
+            {
+                CloseHandle(worker.go);
+            }
+            if (worker.done)
+            {
+                CloseHandle(worker.done);
+            }
+        }
+    }
+};
+
+SocketReader::SocketReader() = default;
+
+SocketReader::~SocketReader() = default;
+
+bool SocketReader::Start(ICPUEx* const* cpus, uint32_t count)
+{
+    state_.reset();
+    std::unique_ptr<State> state(new (std::nothrow) State());
+    if (!state || !count)
+    {
+        return false;
+    }
+
+    state->count = std::min<uint32_t>(count, RM_MAX_SOCKETS);
+    state->cpu0 = cpus[0];
+    for (uint32_t i = 1; i < state->count; ++i)
+    {
+        Worker& worker = state->workers[i];
+        worker.cpu = cpus[i];
+        worker.stop = &state->stop;
+        worker.go = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        worker.done = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!worker.go || !worker.done)
+        {
+            return false;
+        }
+        worker.thread = CreateThread(nullptr, 0, SocketWorkerProc, &worker, 0, nullptr);
+        if (!worker.thread)
+        {
+            return false;
+        }
+        state->done[i - 1] = worker.done;
+    }
+
+    state_ = std::move(state);
+    return true;
+}
+
+uint32_t SocketReader::Read(RMSocketSnapshots& out)
+{
+    if (!state_)
+    {
+        out.socket_count = 0;
+        return 0;
+    }
+
+    State& state = *state_;
+    out.socket_count = state.count;
+    for (uint32_t i = 1; i < state.count; ++i)
+    {
+        state.workers[i].target = &out.sockets[i];
+        SetEvent(state.workers[i].go);
+    }
+    ReadSocket(state.cpu0, out.sockets[0]);
+    if (state.count > 1)
+    {
+        WaitForMultipleObjects(state.count - 1, state.done, TRUE, INFINITE);
+    }
+
+    uint32_t ok = 0;
+    for (uint32_t i = 0; i < state.count; ++i)
+    {
+        ok += out.sockets[i].status == RM_STATUS_OK;
+    }
+    return ok;
+}
+
+bool CombineSocketSnapshots(const RMSocketSnapshots& sockets, RMCpuSnapshot& out)
+{
+    const uint32_t count = std::min<uint32_t>(sockets.socket_count, RM_MAX_SOCKETS);
+    const RMCpuSnapshot* first = nullptr;
+    uint32_t read = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (sockets.sockets[i].status == RM_STATUS_OK)
+        {
+            first = first ? first : &sockets.sockets[i];
+            ++read;
+        }
+    }
+    if (!first)
+    {
+        return false;
+    }
+    if (read == 1)
+    {
+        out = *first;
+        return true;
+    }
+
+    // Scalars start from the first socket read; oc_mode and anything not
+    // folded below come from it.
+    const uint64_t cursor = out.cursor;
+    std::memcpy(&out, first, offsetof(RMCpuSnapshot, core_freq_mhz));
+    out.cursor = cursor;
+    out.core_count = 0;
+
+    double usage_sum = 0.0;
+    double avg_voltage_sum = 0.0;
+    double avg_voltage_1_sum = 0.0;
+    double weight_sum = 0.0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const RMCpuSnapshot& socket = sockets.sockets[i];
+        if (socket.status != RM_STATUS_OK)
+        {
+            continue;
+        }
+
+        const double weight = socket.core_count ? socket.core_count : 1.0;
+        usage_sum += socket.usage_percent * weight;
+        avg_voltage_sum += socket.avg_core_voltage * weight;
+        avg_voltage_1_sum += socket.avg_core_voltage_1 * weight;
+        weight_sum += weight;
+
+        const uint32_t copied = std::min<uint32_t>(socket.core_count, RM_MAX_CORES - out.core_count);
+        const size_t bytes = copied * sizeof(double);
+        std::memcpy(out.core_freq_mhz + out.core_count, socket.core_freq_mhz, bytes);
+        std::memcpy(out.core_residency + out.core_count, socket.core_residency, bytes);
+        std::memcpy(out.core_current_freq_mhz + out.core_count, socket.core_current_freq_mhz, bytes);
+        std::memcpy(out.core_temp_c + out.core_count, socket.core_temp_c, bytes);
+        out.core_count += copied;
+        out.core_fields &= socket.core_fields;
+
+        if (&socket == first)
+        {
+            continue;
+        }
+        out.timestamp_ms = std::max(out.timestamp_ms, socket.timestamp_ms);
+        out.temperature_c = std::max(out.temperature_c, socket.temperature_c);
+        out.package_temperature_c = std::max(out.package_temperature_c, socket.package_temperature_c);
+        out.peak_core_voltage = std::max(out.peak_core_voltage, socket.peak_core_voltage);
+        out.peak_core_voltage_1 = std::max(out.peak_core_voltage_1, socket.peak_core_voltage_1);
+        out.soc_voltage = std::max(out.soc_voltage, socket.soc_voltage);
+        out.peak_speed_mhz = std::max(out.peak_speed_mhz, socket.peak_speed_mhz);
+        out.chtc_limit_c = std::max(out.chtc_limit_c, socket.chtc_limit_c);
+        out.fclk_p0_freq_mhz = std::max(out.fclk_p0_freq_mhz, socket.fclk_p0_freq_mhz);
+        out.cclk_fmax_mhz = std::max(out.cclk_fmax_mhz, socket.cclk_fmax_mhz);
+
+        out.power_w += socket.power_w;
+        out.ppt_limit_w += socket.ppt_limit_w;
+        out.ppt_value_w += socket.ppt_value_w;
+        out.vddcr_vdd_power_w += socket.vddcr_vdd_power_w;
+        out.vddcr_soc_power_w += socket.vddcr_soc_power_w;
+        out.tdc_limit_vdd_a += socket.tdc_limit_vdd_a;
+        out.tdc_value_vdd_a += socket.tdc_value_vdd_a;
+        out.tdc_value_vdd_1_a += socket.tdc_value_vdd_1_a;
+        out.edc_limit_vdd_a += socket.edc_limit_vdd_a;
+        out.edc_value_vdd_a += socket.edc_value_vdd_a;
+        out.edc_value_vdd_1_a += socket.edc_value_vdd_1_a;
+        out.tdc_limit_soc_a += socket.tdc_limit_soc_a;
+        out.tdc_value_soc_a += socket.tdc_value_soc_a;
+        out.edc_limit_soc_a += socket.edc_limit_soc_a;
+        out.edc_value_soc_a += socket.edc_value_soc_a;
+        out.tdc_limit_ccd_a += socket.tdc_limit_ccd_a;
+        out.tdc_value_ccd_a += socket.tdc_value_ccd_a;
+        out.edc_limit_ccd_a += socket.edc_limit_ccd_a;
+        out.edc_value_ccd_a += socket.edc_value_ccd_a;
+    }
+
+    out.usage_percent = usage_sum / weight_sum;
+    out.avg_core_voltage = avg_voltage_sum / weight_sum;
+    out.avg_core_voltage_1 = avg_voltage_1_sum / weight_sum;
+    SummarizeSnapshotCores(out);
+    return true;
+}
@@ -0,0 +1,134 @@
+// Sparkline rasterizer. Graph items scroll by advancing the ring head of a
+// cached bitmap instead of redrawing every point, so one sample costs one
+// column of pixels. Only the standard library is used, so this file and
+// rm_sparkline_bench build and run anywhere, not just inside TrafficMonitor.
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#include "Sparkline.hpp"
+#include "Telemetry.hpp"
+
+namespace {
+
+int32_t ValueRow(const Sparkline& line, double value)
+{
+    const double span = line.max - line.min;
+    double scaled = span > 0.0 ? (value - line.min) / span : 0.0;
+    scaled = std::clamp(scaled, 0.0, 1.0);
+    const int32_t bottom = static_cast<int32_t>(line.height) - 1;
+    return bottom - static_cast<int32_t>(scaled * bottom + 0.5);
+}
+
+} // namespace
+
+void SparklineInit(Sparkline& line, uint32_t* pixels, uint32_t width, uint32_t height, double min, double max,
+    const SparklineStyle& style)
+{
+    line.pixels = pixels;
+    line.width = width;
+    line.height = height;
+    line.head = 0;
+    line.last_row = -1;
+    line.min = min;
+    line.max = max;
+    line.style = style;
+    std::fill(pixels, pixels + static_cast<size_t>(width) * height, style.background);
+}
+
+void SparklinePush(Sparkline& line, double value)
+{
+    if (line.width == 0 || line.height == 0)
+    {
+        return;
+    }
+
+    uint32_t* column = line.pixels + line.head;
+    const uint32_t stride = line.width;
+    const SparklineStyle& style = line.style;
+    line.head = line.head + 1 == line.width ? 0 : line.head + 1;
+
+    if (value != value)
+    {
+        for (uint32_t row = 0; row < line.height; ++row)
+        {
+            column[static_cast<size_t>(row) * stride] = style.background;
+        }
+        line.last_row = -1;
+        return;
+    }
+
+    // Background above the line, the run joining the previous sample, fill
+    // below it.
+    const int32_t row = ValueRow(line, value);
+    const int32_t from = line.last_row < 0 ? row : std::min(row, line.last_row);
+    const int32_t to = line.last_row < 0 ? row : std::max(row, line.last_row);
+    for (int32_t y = 0; y < static_cast<int32_t>(line.height); ++y)
+    {
+        column[static_cast<size_t>(y) * stride] = y < from ? style.background : y <= to ? style.line : style.fill;
+    }
+    line.last_row = row;
+}
+
+// Times SparklinePush on a width x height buffer against redrawing the whole
+// history per sample, which is what a painter without the column ring would do.
+extern "C" int rm_sparkline_bench(unsigned int width, unsigned int height, unsigned int iterations, RMSparklineBenchStats* stats)
+{
+    if (!stats || width == 0 || height == 0 || iterations == 0)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    std::vector<uint32_t> pixels;
+    std::vector<double> history;
+    try
+    {
+        pixels.resize(static_cast<size_t>(width) * height);
+        history.resize(width);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    const SparklineStyle style = { 0x202020, 0x1E465A, 0x5AC8FA };
+    Sparkline line = {};
+    SparklineInit(line, pixels.data(), width, height, 0.0, 100.0, style);
+    for (unsigned int i = 0; i < width; ++i)
+    {
+        history[i] = 50.0 + (i * 37 % 50);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    uint64_t checksum = 0;
+    const Clock::time_point push_start = Clock::now();
+    for (unsigned int n = 0; n < iterations; ++n)
+    {
+        SparklinePush(line, history[n % width]);
+        checksum += pixels[line.head];
+    }
+    const Clock::time_point push_stop = Clock::now();
+
+    const unsigned int redraws = std::max(1u, iterations / width);
+    const Clock::time_point redraw_start = Clock::now();
+    for (unsigned int n = 0; n < redraws; ++n)
+    {
+        SparklineInit(line, pixels.data(), width, height, 0.0, 100.0, style);
+        for (unsigned int i = 0; i < width; ++i)
+        {
+            SparklinePush(line, history[(n + i) % width]);
+        }
+        checksum += pixels[n % pixels.size()];
+    }
+    const Clock::time_point redraw_stop = Clock::now();
+
+    stats->width = width;
+    stats->height = height;
+    stats->iterations = iterations;
+    stats->ns_per_push = std::chrono::duration<double, std::nano>(push_stop - push_start).count() / iterations;
+    stats->ns_per_redraw = std::chrono::duration<double, std::nano>(redraw_stop - redraw_start).count() / redraws;
+    stats->checksum = checksum;
+    return RM_STATUS_OK;
+}
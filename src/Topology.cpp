@@ -0,0 +1,369 @@
+// Core topology: which SDK cores share an L3 (CCX) and a die (CCD), and
+// per-domain reductions of the per-core arrays.
+//
+// Zen 1, Zen+ and Zen 2 (family 17h) put two CCXs on each CCD. From Zen 3 on,
+// a CCD has a single CCX. CCD numbers follow from that rule, taken from the
+// generation table in src/CpuSupport.cpp when it knows the model. Neither the
+// OS nor CPUID reports the die directly.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <intrin.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "CoreReduce.hpp"
+#include "CpuSupport.hpp"
+#include "Topology.hpp"
+#include "Utility.hpp"
+
+namespace {
+
+constexpr uint32_t kDefaultCoresPerCcx = 8;
+
+struct CpuidTopology
+{
+    uint32_t threads_per_core;
+    uint32_t cores_per_ccx;
+    uint32_t table_cores_per_ccx;   // generation table hint, 0 if unknown
+    bool two_ccx_per_ccd;
+};
+
+CpuidTopology ReadCpuidTopology()
+{
+    CpuidTopology result = { 1, 0, 0, false };
+    if (!Authentic_AMD())
+    {
+        return result;
+    }
+
+    const CpuIdentity& identity = IdentifyThisCpu();
+    if (identity.generation)
+    {
+        result.two_ccx_per_ccd = identity.generation->ccx_per_ccd == 2;
+        result.table_cores_per_ccx = identity.generation->cores_per_ccx;
+    }
+    else
+    {
+        result.two_ccx_per_ccd = identity.family == 0x17;
+    }
+
+    int info[4] = {};
+    __cpuid(info, 0x80000000);
+    const uint32_t max_extended = static_cast<uint32_t>(info[0]);
+
+    // Leaf 0x8000001E EBX[15:8]: threads per compute unit minus one.
+    if (max_extended >= 0x8000001E)
+    {
+        __cpuid(info, 0x8000001E);
+        result.threads_per_core = ((static_cast<uint32_t>(info[1]) >> 8) & 0xFF) + 1;
+    }
+
+    // Leaf 0x8000001D enumerates caches; EAX[25:14] of the L3 entry is the
+    // number of logical processors sharing it, minus one.
+    if (max_extended >= 0x8000001D)
+    {
+        for (int subleaf = 0; subleaf < 8; ++subleaf)
+        {
+            __cpuidex(info, 0x8000001D, subleaf);
+            const uint32_t eax = static_cast<uint32_t>(info[0]);
+            if ((eax & 0x1F) == 0)
+            {
+                break;
+            }
+            if (((eax >> 5) & 0x7) == 3)
+            {
+                const uint32_t sharing = ((eax >> 14) & 0xFFF) + 1;
+                result.cores_per_ccx = std::max<uint32_t>(sharing / result.threads_per_core, 1);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool SameProcessors(const GROUP_AFFINITY& a, const GROUP_AFFINITY& b)
+{
+    return a.Group == b.Group && (a.Mask & b.Mask) != 0;
+}
+
+// Assigns each core the index of the L3 it sits under, in OS enumeration
+// order. Fails unless the OS lists exactly core_count physical cores.
+bool MapCoresFromOs(uint32_t core_count, uint32_t* ccx_of, double& l3_kb)
+{
+    DWORD length = 0;
+    if (GetLogicalProcessorInformationEx(RelationAll, nullptr, &length) || GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    std::vector<GROUP_AFFINITY> cores;
+    std::vector<GROUP_AFFINITY> l3s;
+    try
+    {
+        buffer.resize(length);
+        if (!GetLogicalProcessorInformationEx(RelationAll,
+            reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+        {
+            return false;
+        }
+
+        for (DWORD offset = 0; offset < length;)
+        {
+            const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+            if (info->Relationship == RelationProcessorCore)
+            {
+                cores.push_back(info->Processor.GroupMask[0]);
+            }
+            else if (info->Relationship == RelationCache && info->Cache.Level == 3)
+            {
+                l3s.push_back(info->Cache.GroupMask);
+                l3_kb = info->Cache.CacheSize / 1024.0;
+            }
+            offset += info->Size;
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    if (cores.size() != core_count || l3s.empty())
+    {
+        return false;
+    }
+
+    for (uint32_t core = 0; core < core_count; ++core)
+    {
+        const auto l3 = std::find_if(l3s.begin(), l3s.end(),
+            [&](const GROUP_AFFINITY& cache) { return SameProcessors(cores[core], cache); });
+        if (l3 == l3s.end())
+        {
+            return false;
+        }
+        ccx_of[core] = static_cast<uint32_t>(l3 - l3s.begin());
+    }
+    return true;
+}
+
+void FillDomainStats(const CoreReduction& cores, uint32_t core_count, bool has_residency, RMDomainStats& out)
+{
+    out.core_count = core_count;
+    out.active_cores = cores.active_count;
+    out.usage_percent = has_residency && cores.active_count ? cores.residency_sum / cores.active_count : 0.0;
+    if (cores.residency_max > 0.0 && cores.residency_max <= 1.0)
+    {
+        out.usage_percent *= 100.0;
+    }
+    out.freq_mean_mhz = cores.active_count ? cores.freq_sum / cores.active_count : 0.0;
+    out.freq_max_mhz = cores.freq_max;
+    out.temp_max_c = cores.temp_max;
+}
+
+void MergeReduction(CoreReduction& into, const CoreReduction& part)
+{
+    if (part.active_count)
+    {
+        const bool first = into.active_count == 0;
+        into.freq_min = first ? part.freq_min : std::min(into.freq_min, part.freq_min);
+        into.freq_max = first ? part.freq_max : std::max(into.freq_max, part.freq_max);
+    }
+    into.active_count += part.active_count;
+    into.residency_sum += part.residency_sum;
+    into.residency_max = std::max(into.residency_max, part.residency_max);
+    into.freq_sum += part.freq_sum;
+    into.freq_residency_sum += part.freq_residency_sum;
+    into.temp_max = std::max(into.temp_max, part.temp_max);
+}
+
+} // namespace
+
+bool BuildCoreTopology(ICPUEx* cpu, uint32_t core_count, RMTopology& out)
+{
+    out = {};
+
+    unsigned int sdk_cores = 0;
+    if (!core_count && cpu && cpu->GetCoreCount(sdk_cores) == 0)
+    {
+        core_count = sdk_cores;
+    }
+    core_count = std::min<uint32_t>(core_count, RM_MAX_CORES);
+    if (!core_count)
+    {
+        return false;
+    }
+
+    const CpuidTopology cpuid = ReadCpuidTopology();
+    uint32_t ccx_of[RM_MAX_CORES] = {};
+    double l3_kb = 0.0;
+    if (MapCoresFromOs(core_count, ccx_of, l3_kb))
+    {
+        out.source = RM_TOPOLOGY_SOURCE_OS;
+    }
+    else
+    {
+        uint32_t per_ccx = kDefaultCoresPerCcx;
+        out.source = RM_TOPOLOGY_SOURCE_DEFAULT;
+        if (cpuid.cores_per_ccx)
+        {
+            per_ccx = cpuid.cores_per_ccx;
+            out.source = RM_TOPOLOGY_SOURCE_CPUID;
+        }
+        else if (cpuid.table_cores_per_ccx)
+        {
+            per_ccx = cpuid.table_cores_per_ccx;
+            out.source = RM_TOPOLOGY_SOURCE_TABLE;
+        }
+        for (uint32_t core = 0; core < core_count; ++core)
+        {
+            ccx_of[core] = core / per_ccx;
+        }
+    }
+
+    CACHE_INFO l3 = {};
+    if (cpu && cpu->GetL3Cache(l3) == 0 && l3.fSize > 0.0)
+    {
+        l3_kb = l3.fSize;
+    }
+    out.l3_kb_per_ccx = l3_kb;
+    out.threads_per_core = cpuid.threads_per_core;
+    out.core_count = core_count;
+
+    // Raw L3 indices come in OS (or core) order, which keeps CCXs of one CCD
+    // adjacent. Domains beyond RM_MAX_DOMAINS fold into the last one.
+    uint32_t raw_count[RM_MAX_DOMAINS] = {};
+    for (uint32_t core = 0; core < core_count; ++core)
+    {
+        ccx_of[core] = std::min<uint32_t>(ccx_of[core], RM_MAX_DOMAINS - 1);
+        raw_count[ccx_of[core]]++;
+    }
+
+    // Compact to the CCXs that have cores, then lay the cores out CCX by CCX
+    // (stable, so SDK order is kept within a CCX).
+    uint32_t dense_of[RM_MAX_DOMAINS] = {};
+    uint32_t last_raw_ccd = RM_DOMAIN_NONE;
+    uint32_t first = 0;
+    for (uint32_t raw = 0; raw < RM_MAX_DOMAINS; ++raw)
+    {
+        if (!raw_count[raw])
+        {
+            continue;
+        }
+        const uint32_t raw_ccd = cpuid.two_ccx_per_ccd ? raw / 2 : raw;
+        if (raw_ccd != last_raw_ccd)
+        {
+            out.ccd_count++;
+            last_raw_ccd = raw_ccd;
+        }
+
+        RMCoreDomain& domain = out.ccx[out.ccx_count];
+        domain.ccd = out.ccd_count - 1;
+        domain.first = first;
+        domain.core_count = 0;
+        dense_of[raw] = out.ccx_count++;
+        first += raw_count[raw];
+    }
+
+    for (uint32_t core = 0; core < core_count; ++core)
+    {
+        const uint32_t ccx = dense_of[ccx_of[core]];
+        RMCoreDomain& domain = out.ccx[ccx];
+        out.core_order[domain.first + domain.core_count++] = static_cast<uint16_t>(core);
+        out.core_ccx[core] = static_cast<uint8_t>(ccx);
+    }
+    return true;
+}
+
+void ComputeDomainStats(const RMTopology& topology, const RMCpuSnapshot& snapshot, RMTopologySnapshot& out)
+{
+    out.topology = topology;
+    out.hottest_ccx = RM_DOMAIN_NONE;
+    out.hottest_ccd = RM_DOMAIN_NONE;
+
+    for (uint32_t d = 0; d < RM_MAX_DOMAINS; ++d)
+    {
+        out.ccx[d] = {};
+        out.ccd[d] = {};
+    }
+
+    const uint32_t count = std::min<uint32_t>(snapshot.core_count, RM_MAX_CORES);
+    if (count != topology.core_count)
+    {
+        return;
+    }
+
+    const double* freq = nullptr;
+    if (snapshot.core_fields & RM_CORE_FIELD_CURRENT_FREQ)
+    {
+        freq = snapshot.core_current_freq_mhz;
+    }
+    else if (snapshot.core_fields & RM_CORE_FIELD_FREQ)
+    {
+        freq = snapshot.core_freq_mhz;
+    }
+    const double* residency = (snapshot.core_fields & RM_CORE_FIELD_RESIDENCY) ? snapshot.core_residency : nullptr;
+    const double* temp = (snapshot.core_fields & RM_CORE_FIELD_TEMP) ? snapshot.core_temp_c : nullptr;
+
+    // Gather into domain order once; every domain is then a contiguous run.
+    alignas(64) double freq_by_domain[RM_MAX_CORES];
+    alignas(64) double residency_by_domain[RM_MAX_CORES];
+    alignas(64) double temp_by_domain[RM_MAX_CORES];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t core = topology.core_order[i];
+        if (freq)
+        {
+            freq_by_domain[i] = freq[core];
+        }
+        if (residency)
+        {
+            residency_by_domain[i] = residency[core];
+        }
+        if (temp)
+        {
+            temp_by_domain[i] = temp[core];
+        }
+    }
+
+    CoreReduction ccd_total = {};
+    uint32_t ccd_cores = 0;
+    double hottest_ccx_temp = 0.0;
+    double hottest_ccd_temp = 0.0;
+    for (uint32_t ccx = 0; ccx < topology.ccx_count; ++ccx)
+    {
+        const RMCoreDomain& domain = topology.ccx[ccx];
+        CoreArrays arrays = {};
+        arrays.count = domain.core_count;
+        arrays.freq = freq ? freq_by_domain + domain.first : nullptr;
+        arrays.residency = residency ? residency_by_domain + domain.first : nullptr;
+        arrays.temp = temp ? temp_by_domain + domain.first : nullptr;
+
+        CoreReduction cores;
+        ReduceCoreArrays(arrays, cores);
+        FillDomainStats(cores, domain.core_count, residency != nullptr, out.ccx[ccx]);
+        if (temp && cores.temp_max > hottest_ccx_temp)
+        {
+            hottest_ccx_temp = cores.temp_max;
+            out.hottest_ccx = ccx;
+        }
+
+        MergeReduction(ccd_total, cores);
+        ccd_cores += domain.core_count;
+        const bool last_of_ccd = ccx + 1 == topology.ccx_count || topology.ccx[ccx + 1].ccd != domain.ccd;
+        if (last_of_ccd)
+        {
+            FillDomainStats(ccd_total, ccd_cores, residency != nullptr, out.ccd[domain.ccd]);
+            if (temp && ccd_total.temp_max > hottest_ccd_temp)
+            {
+                hottest_ccd_temp = ccd_total.temp_max;
+                out.hottest_ccd = domain.ccd;
+            }
+            ccd_total = {};
+            ccd_cores = 0;
+        }
+    }
+}
@@ -11,7 +11,11 @@
 #include <Shlobj.h>
 #include <intrin.h>
 #include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cmath>
+#include <cstddef>
+#include <memory>
 #include <new>
 #include <string>
 #include "ICPUEx.h"
@@ -19,28 +23,26 @@
 #include "IDeviceManager.h"
 #include "IBIOSEx.h"
 
+#include "Telemetry.hpp"
+#include "Recorder.hpp"
+#include "Clock.hpp"
+#include "HidOutput.hpp"
+#include "Fanout.hpp"
+#include "Aggregator.hpp"
+#include "CoreReduce.hpp"
+#include "CpuSupport.hpp"
+#include "Topology.hpp"
+#include "Sockets.hpp"
+#include "TelemetrySource.hpp"
 #include "Utility.hpp"
 
 
 typedef IPlatform& (__stdcall* GetPlatformFunc)();
 
-enum CPU_PackageType
-{
-	cptFP5 = 0,
-	cptAM5 = 0,
-	cptFP7 = 1,
-	cptFL1 = 1,
-	cptFP8 = 1,
-	cptAM4 = 2,
-	cptFP7r2 = 2,
-	cptAM5_B0 = 3,
-	cptSP3 = 4,
-	cptFP7_B0 = 4,
-	cptFP7R2_B0 = 5,
-	cptSP3r2 = 7,
-	cptSP6 = 8,
-	cptUnknown = 0xF
-};
+// SDK call instrumentation, defined with the stats page further down.
+static LONGLONG SdkCallStart();
+static void RecordSdkCall(uint32_t call, LONGLONG start, int error);
+static int CountMonitorStatus(int status);
 
 struct MonitoringContext
 {
@@ -48,6 +50,8 @@ struct MonitoringContext
 	IPlatform* platform = nullptr;
 	ICPUEx* cpu = nullptr;
 	IBIOSEx* bios = nullptr;
+	ICPUEx* cpus[RM_MAX_SOCKETS] = {};
+	uint32_t cpuCount = 0;
 	bool platformInitialized = false;
 };
 
@@ -81,32 +85,35 @@ const double* GetCurrentTempPtr(const FreqData& data)
 	}
 }
 
+// Returns the C0 residency array in percent. SDKs that only report a busy flag
+// per core get it expanded into `scratch`, capped at RM_MAX_CORES cores.
 template <typename FreqData>
-bool GetResidencyPercent(const FreqData& data, unsigned int idx, double& out_percent)
+const double* GetResidencyPtr(const FreqData& data, double (&scratch)[RM_MAX_CORES], unsigned int& count)
 {
 	if constexpr (requires { data.dState; })
 	{
-		if (!data.dState)
-		{
-			return false;
-		}
-		out_percent = data.dState[idx];
-		return true;
+		(void)scratch;
+		(void)count;
+		return data.dState;
 	}
 	else if constexpr (requires { data.bState; })
 	{
 		if (!data.bState)
 		{
-			return false;
+			return nullptr;
 		}
-		out_percent = data.bState[idx] ? 100.0 : 0.0;
-		return true;
+		count = std::min<unsigned int>(count, RM_MAX_CORES);
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			scratch[i] = data.bState[i] ? 100.0 : 0.0;
+		}
+		return scratch;
 	}
 	else
 	{
-		(void)idx;
-		(void)out_percent;
-		return false;
+		(void)scratch;
+		(void)count;
+		return nullptr;
 	}
 }
 
@@ -158,7 +165,14 @@ void CleanupMonitoringContext(MonitoringContext& ctx)
 bool InitMonitoringContext(MonitoringContext& ctx)
 {
 	const wchar_t* sdkPath = GetMonitorSdkPath();
-	if (!sdkPath || !TryLoadPlatformFromDir(ctx, sdkPath))
+	if (!sdkPath)
+	{
+		return false;
+	}
+	LONGLONG loadStart = SdkCallStart();
+	bool loaded = TryLoadPlatformFromDir(ctx, sdkPath);
+	RecordSdkCall(RM_SDK_CALL_LOAD_PLATFORM, loadStart, loaded ? 0 : -1);
+	if (!loaded)
 	{
 		return false;
 	}
@@ -176,7 +190,9 @@ bool InitMonitoringContext(MonitoringContext& ctx)
 	}
 
 	ctx.platform = &platformFunc();
+	LONGLONG initStart = SdkCallStart();
 	ctx.platformInitialized = ctx.platform->Init();
+	RecordSdkCall(RM_SDK_CALL_PLATFORM_INIT, initStart, ctx.platformInitialized ? 0 : -1);
 	if (!ctx.platformInitialized)
 	{
 		CleanupMonitoringContext(ctx);
@@ -184,7 +200,8 @@ bool InitMonitoringContext(MonitoringContext& ctx)
 	}
 
 	IDeviceManager& rDeviceManager = ctx.platform->GetIDeviceManager();
-	ctx.cpu = (ICPUEx*)rDeviceManager.GetDevice(dtCPU, 0);
+	ctx.cpuCount = EnumerateCPUs(rDeviceManager, ctx.cpus, RM_MAX_SOCKETS);
+	ctx.cpu = ctx.cpus[0];
 	ctx.bios = (IBIOSEx*)rDeviceManager.GetDevice(dtBIOS, 0);
 	if (!ctx.cpu || !ctx.bios)
 	{
@@ -196,181 +213,59 @@ bool InitMonitoringContext(MonitoringContext& ctx)
 }
 
 
-BOOL IsSupportedProcessor(VOID)
+// Derives the rm_monitor_read values. The per-core arrays are reduced in one
+// vectorized pass (src/CoreReduce.cpp); the reduction is also returned through
+// `cores` for callers that want the rest of it.
+void DeriveTelemetry(const CPUParameters& stData, double& temperatureC, double& powerW, double& usagePercent, CoreReduction* cores = nullptr)
 {
-	bool retBool = false;
-	int CPUInfo[4] = { -1 };
-	__cpuid(CPUInfo, 0x80000001);
-	unsigned long uCPUID = CPUInfo[0];
-	CPU_PackageType pkgType = (CPU_PackageType)((CPUInfo[1] >> 28) & 0x0F);
+	double residency_scratch[RM_MAX_CORES];
+	CoreArrays arrays = {};
+	arrays.count = stData.stFreqData.uLength;
+	arrays.residency = GetResidencyPtr(stData.stFreqData, residency_scratch, arrays.count);
+	arrays.freq = GetCurrentFreqPtr(stData.stFreqData);
+	arrays.temp = GetCurrentTempPtr(stData.stFreqData);
+
+	CoreReduction reduction;
+	ReduceCoreArrays(arrays, reduction);
+	if (cores)
+	{
+		*cores = reduction;
+	}
 
-	switch (pkgType)
+	const bool has_residency = arrays.residency && reduction.active_count;
+	usagePercent = has_residency ? (reduction.residency_sum / reduction.active_count) : 0.0;
+	if (reduction.residency_max > 0.0 && reduction.residency_max <= 1.0)
 	{
-	case cptFP5:
-		//case cptAM5:
-		switch (uCPUID)
-		{
-		case 0x00810F80:
-		case 0x00810F81:
-		case 0x00860F00:
-		case 0x00860F01:
-		case 0x00A50F00:
-		case 0x00A50F01:
-		case 0x00860F81:
-		case 0x00A60F00:
-		case 0x00A60F01:
-		case 0x00A60F10:
-		case 0x00A60F11:
-		case 0x00A60F12:
-		case 0x00A60F13:
-		case 0x00A70F80:
-		case 0x00A70F52:
-
-		case 0x00B40F40:
-		case 0x00B40F41:
-			retBool = true;
-			break;
-		default:
-			break;
-		}
-		break;
+		usagePercent *= 100.0;
+	}
 
-	case cptAM4:
-	case cptFP7R2_B0:
-		switch (uCPUID)
-		{
-		case 0x00800F00:
-		case 0x00800F10:
-		case 0x00800F11:
-		case 0x00800F12:
-
-		case 0x00810F10:
-		case 0x00810F11:
-
-		case 0x00800F82:
-		case 0x00800F83:
-
-		case 0x00870F00:
-		case 0x00870F10:
-
-		case 0x00810F80:
-		case 0x00810F81:
-
-		case 0x00860F00:
-		case 0x00860F01:
-
-		case 0x00A20F00:
-		case 0x00A20F10:
-		case 0x00A20F12:
-
-		case 0x00A50F00:
-		case 0x00A50F01:
-
-		//cptFP7r2
-		case 0x00A40F00:
-		case 0x00A40F40:
-		case 0x00A40F41:
-
-		case 0x00A70F00:
-		case 0x00A70F40:
-		case 0x00A70F41:
-		case 0x00A70F42:
-		case 0x00A70F80:
-		
-		case 0x00A70F52:
-		case 0x00A70FC0:
-			retBool = true;
-			break;
-		default:
-			break;
-		}
-		break;
+	temperatureC = stData.dTemperature;
+	if ((!std::isfinite(temperatureC) || temperatureC <= 0.0) && reduction.temp_max > 0.0)
+	{
+		temperatureC = reduction.temp_max;
+	}
 
-	case cptSP3r2:
-		switch (uCPUID)
+	powerW = stData.fPPTValue;
+	if (!std::isfinite(powerW) || powerW <= 0.0)
+	{
+		double alt_power = 0.0;
+		if (std::isfinite(stData.fVDDCR_VDD_Power) && stData.fVDDCR_VDD_Power > 0.0f)
 		{
-		case 0x00800F10:
-		case 0x00800F11:
-		case 0x00800F12:
-
-		case 0x00800F82:
-		case 0x00800F83:
-		case 0x00830F00:
-		case 0x00830F10:
-			retBool = true;
-			break;
-		case 0x00B00F11:
-		case 0x00B00F80:
-		case 0x00B00F81:
-			retBool = true;
-			break;
-		default:
-			break;
+			alt_power += stData.fVDDCR_VDD_Power;
 		}
-		break;
-
-	case cptFP7:
-	//case cptFL1:
-	//case cptFP8:
-	//case cptFP7_B0:
-	case cptSP3:
-		switch (uCPUID)
+		if (std::isfinite(stData.fVDDCR_SOC_Power) && stData.fVDDCR_SOC_Power > 0.0f)
 		{
-		case 0x00A40F00:
-		case 0x00A40F40:
-		case 0x00A40F41:
-
-		case 0x00A60F11:
-		case 0x00A60F12:
-			retBool = true;
-			break;
-		case 0x00A00F80:
-		case 0x00A00F82:
-
-		case 0x00A70F00:
-		case 0x00A70F40:
-		case 0x00A70F41:
-		case 0x00A70F42:
-		case 0x00A70F80:
-		case 0x00A70F52:
-		case 0x00A70FC0:
-		case 0x00B20F40:
-
-		case 0x00B40F40:
-			retBool = true;
-			break;
-
-			//STXH - FP11
-		case 0x00B70F00:
-			retBool = true;
-			break;
-			//KRK
-		case 0x00B60F00:
-			retBool = true;
-			break;
-			//KRK2
-		case 0x00B60F80:
-			retBool = true;
-			break;
-		default:
-			break;
+			alt_power += stData.fVDDCR_SOC_Power;
 		}
-		break;
-
-	case cptSP6:
-		switch (uCPUID)
+		if (alt_power > 0.0)
 		{
-		case 0x00A10F81:
-		case 0x00A10F80:
-			retBool = true;
-			break;
+			powerW = alt_power;
 		}
-		break;
-
-	default:
-		break;
 	}
-	return retBool;
+	if (!std::isfinite(powerW) || powerW < 0.0)
+	{
+		powerW = 0.0;
+	}
 }
 
 bool ReadCPUTelemetry(ICPUEx* cpu, double& temperatureC, double& powerW, double& usagePercent)
@@ -381,353 +276,1928 @@ bool ReadCPUTelemetry(ICPUEx* cpu, double& temperatureC, double& powerW, double&
 	}
 
 	CPUParameters stData = {};
+	LONGLONG start = SdkCallStart();
 	int iRet = cpu->GetCPUParameters(stData);
+	RecordSdkCall(RM_SDK_CALL_GET_CPU_PARAMETERS, start, iRet);
 	if (iRet)
 	{
 		return false;
 	}
 
-	double occupancy_sum = 0.0;
-	unsigned int occupancy_count = 0;
-	double max_residency = 0.0;
-	const double* freq_ptr = GetCurrentFreqPtr(stData.stFreqData);
-	if (stData.stFreqData.uLength)
+	DeriveTelemetry(stData, temperatureC, powerW, usagePercent);
+	return true;
+}
+
+template <typename FreqData>
+const double* GetEffectiveFreqPtr(const FreqData& data)
+{
+	if constexpr (requires { data.dFreq; })
 	{
-		for (unsigned int i = 0; i < stData.stFreqData.uLength; ++i)
-		{
-			if (!freq_ptr || freq_ptr[i] != 0)
-			{
-				double residency = 0.0;
-				if (GetResidencyPercent(stData.stFreqData, i, residency))
-				{
-					occupancy_sum += residency;
-					occupancy_count++;
-					max_residency = std::max(max_residency, residency);
-				}
-			}
-		}
+		return data.dFreq;
+	}
+	else
+	{
+		return nullptr;
 	}
+}
 
-	usagePercent = occupancy_count ? (occupancy_sum / occupancy_count) : 0.0;
-	if (max_residency > 0.0 && max_residency <= 1.0)
+template <typename FreqData>
+const double* GetReportedFreqPtr(const FreqData& data)
+{
+	if constexpr (requires { data.dCurrentFreq; })
 	{
-		usagePercent *= 100.0;
+		return data.dCurrentFreq;
+	}
+	else
+	{
+		return nullptr;
 	}
+}
 
-	temperatureC = stData.dTemperature;
-	if ((!std::isfinite(temperatureC) || temperatureC <= 0.0) && stData.stFreqData.uLength)
+static void CopyCoreArray(const double* src, unsigned int count, double* dst, uint32_t field, uint32_t& fields)
+{
+	if (!src)
 	{
-		const double* temp_ptr = GetCurrentTempPtr(stData.stFreqData);
-		if (temp_ptr)
-		{
-			double max_temp = 0.0;
-			for (unsigned int i = 0; i < stData.stFreqData.uLength; ++i)
-			{
-				if (temp_ptr[i] > max_temp)
-				{
-					max_temp = temp_ptr[i];
-				}
-			}
-			if (max_temp > 0.0)
-			{
-				temperatureC = max_temp;
-			}
-		}
+		return;
 	}
+	std::copy(src, src + count, dst);
+	fields |= field;
+}
 
-	powerW = stData.fPPTValue;
-	if (!std::isfinite(powerW) || powerW <= 0.0)
+void FillCPUSnapshot(const CPUParameters& stData, RMCpuSnapshot& snapshot)
+{
+	const unsigned int count = std::min<unsigned int>(stData.stFreqData.uLength, RM_MAX_CORES);
+
+	snapshot.oc_mode = stData.eMode.uOCMode;
+	snapshot.core_count = count;
+	snapshot.core_fields = 0;
+
+	CoreReduction cores;
+	DeriveTelemetry(stData, snapshot.temperature_c, snapshot.power_w, snapshot.usage_percent, &cores);
+	ApplyCoreSummary(cores, GetCurrentFreqPtr(stData.stFreqData) != nullptr, snapshot);
+
+	snapshot.package_temperature_c = stData.dTemperature;
+	snapshot.peak_core_voltage = stData.dPeakCoreVoltage;
+	snapshot.peak_core_voltage_1 = stData.dPeakCoreVoltage_1;
+	snapshot.soc_voltage = stData.dSocVoltage;
+	snapshot.avg_core_voltage = stData.dAvgCoreVoltage;
+	snapshot.avg_core_voltage_1 = stData.dAvgCoreVoltage_1;
+	snapshot.peak_speed_mhz = stData.dPeakSpeed;
+
+	snapshot.ppt_limit_w = stData.fPPTLimit;
+	snapshot.ppt_value_w = stData.fPPTValue;
+	snapshot.tdc_limit_vdd_a = stData.fTDCLimit_VDD;
+	snapshot.tdc_value_vdd_a = stData.fTDCValue_VDD;
+	snapshot.tdc_value_vdd_1_a = stData.fTDCValue_VDD_1;
+	snapshot.edc_limit_vdd_a = stData.fEDCLimit_VDD;
+	snapshot.edc_value_vdd_a = stData.fEDCValue_VDD;
+	snapshot.edc_value_vdd_1_a = stData.fEDCValue_VDD_1;
+	snapshot.chtc_limit_c = stData.fcHTCLimit;
+	snapshot.fclk_p0_freq_mhz = stData.fFCLKP0Freq;
+	snapshot.cclk_fmax_mhz = stData.fCCLK_Fmax;
+	snapshot.tdc_limit_soc_a = stData.fTDCLimit_SOC;
+	snapshot.tdc_value_soc_a = stData.fTDCValue_SOC;
+	snapshot.edc_limit_soc_a = stData.fEDCLimit_SOC;
+	snapshot.edc_value_soc_a = stData.fEDCValue_SOC;
+	snapshot.vddcr_vdd_power_w = stData.fVDDCR_VDD_Power;
+	snapshot.vddcr_soc_power_w = stData.fVDDCR_SOC_Power;
+	snapshot.tdc_limit_ccd_a = stData.fTDCLimit_CCD;
+	snapshot.tdc_value_ccd_a = stData.fTDCValue_CCD;
+	snapshot.edc_limit_ccd_a = stData.fEDCLimit_CCD;
+	snapshot.edc_value_ccd_a = stData.fEDCValue_CCD;
+
+	const EffectiveFreqData& freq = stData.stFreqData;
+	CopyCoreArray(GetEffectiveFreqPtr(freq), count, snapshot.core_freq_mhz, RM_CORE_FIELD_FREQ, snapshot.core_fields);
+	CopyCoreArray(GetReportedFreqPtr(freq), count, snapshot.core_current_freq_mhz, RM_CORE_FIELD_CURRENT_FREQ, snapshot.core_fields);
+	CopyCoreArray(GetCurrentTempPtr(freq), count, snapshot.core_temp_c, RM_CORE_FIELD_TEMP, snapshot.core_fields);
+
+	unsigned int residency_count = count;
+	const double* residency = GetResidencyPtr(freq, snapshot.core_residency, residency_count);
+	if (residency && residency_count == count && count > 0)
 	{
-		double alt_power = 0.0;
-		if (std::isfinite(stData.fVDDCR_VDD_Power) && stData.fVDDCR_VDD_Power > 0.0f)
-		{
-			alt_power += stData.fVDDCR_VDD_Power;
-		}
-		if (std::isfinite(stData.fVDDCR_SOC_Power) && stData.fVDDCR_SOC_Power > 0.0f)
-		{
-			alt_power += stData.fVDDCR_SOC_Power;
-		}
-		if (alt_power > 0.0)
+		if (residency != snapshot.core_residency)
 		{
-			powerW = alt_power;
+			std::copy(residency, residency + count, snapshot.core_residency);
 		}
+		snapshot.core_fields |= RM_CORE_FIELD_RESIDENCY;
 	}
-	if (!std::isfinite(powerW) || powerW < 0.0)
+}
+
+bool ReadCPUSnapshot(ICPUEx* cpu, RMCpuSnapshot& snapshot)
+{
+	if (!cpu)
 	{
-		powerW = 0.0;
+		return false;
 	}
+
+	CPUParameters stData = {};
+	LONGLONG start = SdkCallStart();
+	int iRet = cpu->GetCPUParameters(stData);
+	RecordSdkCall(RM_SDK_CALL_GET_CPU_PARAMETERS, start, iRet);
+	if (iRet)
+	{
+		return false;
+	}
+
+	FillCPUSnapshot(stData, snapshot);
 	return true;
 }
 
-enum RMMonitorStatus
+// Telemetry source backed by the Ryzen Master SDK's Platform.dll.
+class RyzenSdkSource final : public TelemetrySource
 {
-    RM_STATUS_OK = 0,
-    RM_STATUS_INVALID_ARG = 1,
-    RM_STATUS_NOT_ADMIN = 2,
-    RM_STATUS_UNSUPPORTED_OS = 3,
-    RM_STATUS_NOT_AMD = 4,
-    RM_STATUS_DRIVER = 5,
-    RM_STATUS_UNSUPPORTED_CPU = 6,
-    RM_STATUS_ALLOC_FAILED = 7,
-    RM_STATUS_SDK_INIT_FAILED = 8,
-    RM_STATUS_READ_FAILED = 9
+public:
+    ~RyzenSdkSource() override
+    {
+        CleanupMonitoringContext(ctx_);
+    }
+
+    bool Init()
+    {
+        return InitMonitoringContext(ctx_);
+    }
+
+    ICPUEx* GetCPU() override { return ctx_.cpu; }
+    IBIOSEx* GetBIOS() override { return ctx_.bios; }
+    uint32_t GetCPUCount() override { return ctx_.cpuCount; }
+    ICPUEx* GetCPUAt(uint32_t index) override { return index < ctx_.cpuCount ? ctx_.cpus[index] : nullptr; }
+
+private:
+    MonitoringContext ctx_ = {};
 };
 
 struct RMMonitorContext
 {
-    MonitoringContext ctx = {};
+    std::unique_ptr<TelemetrySource> source;
+    ICPUEx* cpu = nullptr;
+    SocketReader reader;
+    std::unique_ptr<RMSocketSnapshots> sockets;
+    RMCpuSnapshot snapshot = {};
+    RMTopology topology = {};
 };
 
+// Set to a script path (or "builtin") to make rm_monitor_init use the simulator.
+constexpr wchar_t kSimulatorEnvVar[] = L"RM_TELEMETRY_SIMULATOR";
+// Set to a recording directory to make rm_monitor_init replay it at 1x.
+constexpr wchar_t kReplayEnvVar[] = L"RM_TELEMETRY_REPLAY";
+
+static void StopSamplerForContext(RMMonitorContext* ctx);
+static void SetPublishTopology(const RMTopology& topology);
+static bool LoadPlatformInventory(RMPlatformInventory& inventory, uint64_t stamp);
+static void StorePlatformInventory(const RMPlatformInventory& inventory);
+
 extern "C" void rm_monitor_set_sdk_path(const wchar_t* path)
 {
     SetMonitorSdkPath(path);
 }
 
-extern "C" int rm_monitor_init(RMMonitorContext** out_ctx)
+static int AttachSource(RMMonitorContext** out_ctx, std::unique_ptr<TelemetrySource> source)
 {
-    if (!out_ctx)
+    RMMonitorContext* wrapper = new (std::nothrow) RMMonitorContext();
+    if (!wrapper)
     {
-        return RM_STATUS_INVALID_ARG;
+        return RM_STATUS_ALLOC_FAILED;
     }
 
-    *out_ctx = nullptr;
-    if (!IsUserAnAdmin())
-    {
-        return RM_STATUS_NOT_ADMIN;
-    }
-    if (!IsSupportedOS())
-    {
-        return RM_STATUS_UNSUPPORTED_OS;
-    }
-    if (!Authentic_AMD())
+    ICPUEx* cpus[RM_MAX_SOCKETS] = { source->GetCPU() };
+    const uint32_t cpu_count = std::max<uint32_t>(std::min<uint32_t>(source->GetCPUCount(), RM_MAX_SOCKETS), 1);
+    uint32_t core_count = 0;
+    for (uint32_t i = 1; i < cpu_count; ++i)
     {
-        return RM_STATUS_NOT_AMD;
+        cpus[i] = source->GetCPUAt(i);
     }
-    if (QueryDrvService() < 0)
+    for (uint32_t i = 0; i < cpu_count; ++i)
     {
-        if (!InstallDriver())
+        unsigned int cores = 0;
+        if (cpus[i] && cpus[i]->GetCoreCount(cores) == 0)
         {
-            return RM_STATUS_DRIVER;
+            core_count += cores;
         }
     }
-    if (!IsSupportedProcessor())
-    {
-        return RM_STATUS_UNSUPPORTED_CPU;
-    }
-
-    RMMonitorContext* wrapper = new (std::nothrow) RMMonitorContext();
-    if (!wrapper)
+    wrapper->cpu = cpus[0];
+    wrapper->source = std::move(source);
+    wrapper->sockets.reset(new (std::nothrow) RMSocketSnapshots());
+    if (!wrapper->sockets || !wrapper->reader.Start(cpus, cpu_count))
     {
+        delete wrapper;
         return RM_STATUS_ALLOC_FAILED;
     }
-    if (!InitMonitoringContext(wrapper->ctx))
+    wrapper->sockets->socket_count = cpu_count;
+
+    // With several sockets the OS relations list every socket's cores, in the
+    // order their arrays are concatenated.
+    if (BuildCoreTopology(wrapper->cpu, cpu_count > 1 ? std::min<uint32_t>(core_count, RM_MAX_CORES) : 0, wrapper->topology))
     {
-        delete wrapper;
-        return RM_STATUS_SDK_INIT_FAILED;
+        SetPublishTopology(wrapper->topology);
     }
-
     *out_ctx = wrapper;
     return RM_STATUS_OK;
 }
 
-extern "C" int rm_monitor_read(RMMonitorContext* ctx, double* temperatureC, double* powerW, double* usagePercent)
+// Replays a keyframe script (or the built-in load cycle when script_path is
+// null or empty) instead of touching hardware. step_ms > 0 advances simulated
+// time by a fixed amount per read, making output independent of wall time.
+extern "C" int rm_monitor_init_simulated(RMMonitorContext** out_ctx, const wchar_t* script_path, double speed, unsigned int step_ms)
 {
-    if (!ctx || !temperatureC || !powerW || !usagePercent)
+    if (!out_ctx)
     {
         return RM_STATUS_INVALID_ARG;
     }
 
-    double temp = 0.0;
-    double power = 0.0;
-    double usage = 0.0;
-    if (!ReadCPUTelemetry(ctx->ctx.cpu, temp, power, usage))
+    *out_ctx = nullptr;
+    SimulatorOptions options;
+    options.script_path = script_path;
+    options.speed = speed;
+    options.step_ms = step_ms;
+    std::unique_ptr<TelemetrySource> source = CreateSimulatedSource(options);
+    if (!source)
     {
-        return RM_STATUS_READ_FAILED;
+        return RM_STATUS_SDK_INIT_FAILED;
     }
 
-    *temperatureC = temp;
-    *powerW = power;
-    *usagePercent = usage;
-    return RM_STATUS_OK;
+    return AttachSource(out_ctx, std::move(source));
 }
 
-extern "C" void rm_monitor_shutdown(RMMonitorContext* ctx)
+// Serves samples from a directory written by rm_recorder_start, looping at the
+// end. speed 1 keeps the recorded timing, N runs N times faster and 0 returns
+// the next recorded sample on every read.
+extern "C" int rm_monitor_init_replay(RMMonitorContext** out_ctx, const wchar_t* directory, double speed)
 {
-    if (!ctx)
+    if (!out_ctx || !directory || speed < 0.0)
     {
-        return;
+        return RM_STATUS_INVALID_ARG;
     }
 
-    CleanupMonitoringContext(ctx->ctx);
-    delete ctx;
+    *out_ctx = nullptr;
+    ReplayOptions options;
+    options.directory = directory;
+    options.speed = speed;
+    std::unique_ptr<TelemetrySource> source = CreateReplaySource(options);
+    if (!source)
+    {
+        return RM_STATUS_SDK_INIT_FAILED;
+    }
+
+    return AttachSource(out_ctx, std::move(source));
 }
 
 namespace {
 
-constexpr uint32_t kIpcVersion = 1;
-constexpr wchar_t kIpcMapName[] = L"Global\\RyzenTelemetryShared";
-constexpr wchar_t kIpcOwnerMutexName[] = L"Global\\RyzenTelemetryOwner";
-constexpr wchar_t kIpcServiceEventName[] = L"Global\\RyzenTelemetryService";
-constexpr wchar_t kIpcSecurityDescriptor[] = L"D:(A;;GA;;;WD)";
-
-enum IpcResult
-{
-    IPC_OK = 0,
-    IPC_NOT_READY = 1,
-    IPC_STALE = 2,
-    IPC_ERROR = 3
-};
-
-struct RMSharedTelemetry
+// FNV-1a; only has to tell one set of SDK files from another.
+void HashBytes(uint64_t& hash, const void* data, size_t size)
 {
-    uint32_t version;
-    uint32_t size;
-    volatile LONG seq;
-    uint32_t status;
-    uint32_t reserved;
-    ULONGLONG timestamp_ms;
-    double temperature_c;
-    double power_w;
-    double usage_percent;
-    uint32_t writer_pid;
-    uint32_t reserved2;
-};
-
-static HANDLE g_ipc_service_event = nullptr;
-static HANDLE g_ipc_owner_mutex = nullptr;
-static bool g_ipc_owner_held = false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+}
 
-class SecurityAttributesHolder
+void HashFile(uint64_t& hash, const std::wstring& path)
 {
-public:
-    SecurityAttributesHolder()
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
     {
-        attrs_.nLength = sizeof(attrs_);
-        attrs_.bInheritHandle = FALSE;
-        if (ConvertStringSecurityDescriptorToSecurityDescriptorW(
-                kIpcSecurityDescriptor,
-                SDDL_REVISION_1,
-                &descriptor_,
-                nullptr))
-        {
-            attrs_.lpSecurityDescriptor = descriptor_;
-        }
-        else
-        {
-            descriptor_ = nullptr;
-            attrs_.lpSecurityDescriptor = nullptr;
-        }
+        HashBytes(hash, &data.nFileSizeLow, sizeof(data.nFileSizeLow));
+        HashBytes(hash, &data.nFileSizeHigh, sizeof(data.nFileSizeHigh));
+        HashBytes(hash, &data.ftLastWriteTime, sizeof(data.ftLastWriteTime));
     }
+}
 
-    ~SecurityAttributesHolder()
+// Identifies the SDK and driver an inventory was taken with: the SDK path, the
+// driver service name, and size and write time of the files InitMonitor loads
+// or installs. 0 when no SDK path is set yet.
+uint64_t PlatformStamp()
+{
+    // Checked here as in GetDriverPath rather than relied on from
+    // GetMonitorSdkPath, since base.back() below needs a non-empty path.
+    const wchar_t* sdkPath = GetMonitorSdkPath();
+    if (!sdkPath || !*sdkPath)
     {
-        if (descriptor_)
-        {
-            LocalFree(descriptor_);
-            descriptor_ = nullptr;
-        }
+        return 0;
     }
 
-    SECURITY_ATTRIBUTES* Get()
+    std::wstring base(sdkPath);
+    if (base.back() != L'\\' && base.back() != L'/')
     {
-        return descriptor_ ? &attrs_ : nullptr;
+        base += L'\\';
     }
 
-private:
-    SECURITY_ATTRIBUTES attrs_{};
-    PSECURITY_DESCRIPTOR descriptor_ = nullptr;
-};
+    uint64_t hash = 14695981039346656037ull;
+    HashBytes(hash, base.data(), base.size() * sizeof(wchar_t));
+    HashBytes(hash, RM_DRIVER_NAME, sizeof(RM_DRIVER_NAME));
+    HashFile(hash, base + L"Platform.dll");
+    HashFile(hash, base + L"bin\\Platform.dll");
+    HashFile(hash, base + L"bin\\Device.dll");
+    HashFile(hash, base + DRIVER_FILE_PATH_64);
+    return hash ? hash : 1;
+}
 
-SECURITY_ATTRIBUTES* GetIpcSecurityAttributes()
+template <size_t N>
+void CopyText(wchar_t (&out)[N], const wchar_t* text)
 {
-    static SecurityAttributesHolder holder;
-    return holder.Get();
+    size_t i = 0;
+    for (; text && text[i] && i + 1 < N; ++i)
+    {
+        out[i] = text[i];
+    }
+    out[i] = L'\0';
 }
 
-RMSharedTelemetry* GetSharedTelemetry()
+// Runs the machine-wide checks InitMonitor makes before loading the SDK, except
+// the driver service, which only InitMonitor queries.
+void ProbeHostInventory(RMPlatformInventory& inventory, uint64_t stamp)
 {
-    static HANDLE s_map = nullptr;
-    static RMSharedTelemetry* s_view = nullptr;
-
-    if (s_view)
+    inventory = {};
+    inventory.timestamp_ms = GetTickCount64();
+    inventory.sdk_stamp = stamp;
+
+    const CpuIdentity& cpu = IdentifyThisCpu();
+    inventory.cpuid_signature = cpu.signature;
+    inventory.package_type = cpu.package_type;
+    inventory.family = cpu.family;
+    inventory.model = cpu.model;
+    inventory.stepping = cpu.stepping;
+    if (cpu.generation)
     {
-        return s_view;
+        for (size_t i = 0; cpu.generation->codename[i] && i + 1 < RM_INVENTORY_TEXT_LEN; ++i)
+        {
+            inventory.codename[i] = static_cast<wchar_t>(cpu.generation->codename[i]);
+        }
     }
-
-    HANDLE map = CreateFileMappingW(
-        INVALID_HANDLE_VALUE,
-        GetIpcSecurityAttributes(),
-        PAGE_READWRITE,
-        0,
-        static_cast<DWORD>(sizeof(RMSharedTelemetry)),
-        kIpcMapName);
-    if (!map)
+    if (IsSupportedOS())
     {
-        return nullptr;
+        inventory.flags |= RM_INVENTORY_OS_SUPPORTED;
     }
-
-    bool created = (GetLastError() != ERROR_ALREADY_EXISTS);
-    void* view = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(RMSharedTelemetry));
-    if (!view)
+    if (Authentic_AMD())
     {
-        CloseHandle(map);
-        return nullptr;
+        inventory.flags |= RM_INVENTORY_AUTHENTIC_AMD;
     }
-
-    s_map = map;
-    s_view = static_cast<RMSharedTelemetry*>(view);
-
-    if (created)
+    if (cpu.supported)
     {
-        ZeroMemory(s_view, sizeof(RMSharedTelemetry));
-        s_view->version = kIpcVersion;
-        s_view->size = sizeof(RMSharedTelemetry);
+        inventory.flags |= RM_INVENTORY_CPU_SUPPORTED;
     }
-
-    return s_view;
 }
 
-LONG AtomicRead(volatile LONG* value)
+// Adds what the SDK devices report. None of it changes while the machine runs.
+void FillDeviceInventory(TelemetrySource& source, RMPlatformInventory& inventory)
 {
-    return InterlockedCompareExchange(value, 0, 0);
-}
-
+    ICPUEx* cpu = source.GetCPU();
+    if (cpu)
+    {
+        CopyText(inventory.cpu_name, cpu->GetName());
+        CopyText(inventory.package, cpu->GetPackage());
+        wchar_t chipset[MAX_STRING_LEN] = {};
+        if (cpu->GetChipsetName(chipset) == 0)
+        {
+            CopyText(inventory.chipset, chipset);
+        }
+
+        CACHE_INFO cache = {};
+        inventory.l1d_kb = cpu->GetL1DataCache(cache) == 0 ? cache.fSize : 0.0;
+        inventory.l1i_kb = cpu->GetL1InstructionCache(cache) == 0 ? cache.fSize : 0.0;
+        inventory.l2_kb = cpu->GetL2Cache(cache) == 0 ? cache.fSize : 0.0;
+        inventory.l3_kb = cpu->GetL3Cache(cache) == 0 ? cache.fSize : 0.0;
+
+        inventory.socket_count = source.GetCPUCount();
+        inventory.core_count = 0;
+        for (uint32_t i = 0; i < inventory.socket_count; ++i)
+        {
+            ICPUEx* socket = source.GetCPUAt(i);
+            unsigned int cores = 0;
+            if (socket && socket->GetCoreCount(cores) == 0)
+            {
+                inventory.core_count += cores;
+            }
+        }
+        inventory.flags |= RM_INVENTORY_DEVICES;
+    }
+
+    IBIOSEx* bios = source.GetBIOS();
+    if (bios)
+    {
+        CopyText(inventory.bios_vendor, bios->GetVendor());
+        CopyText(inventory.bios_version, bios->GetVersion());
+        CopyText(inventory.bios_date, bios->GetDate());
+
+        // Each call returns 2 when the BIOS does not implement it.
+        unsigned short word = 0;
+        unsigned char clocks = 0;
+        inventory.mem_clock_mhz = bios->GetCurrentMemClock(word) == 0 ? word : 0;
+        inventory.mem_vddio_mv = bios->GetMemVDDIO(word) == 0 ? word : 0;
+        inventory.mem_tcl = bios->GetMemCtrlTcl(clocks) == 0 ? clocks : 0;
+        inventory.mem_trcdrd = bios->GetMemCtrlTrcdrd(clocks) == 0 ? clocks : 0;
+        inventory.mem_tras = bios->GetMemCtrlTras(clocks) == 0 ? clocks : 0;
+        inventory.mem_trp = bios->GetMemCtrlTrp(clocks) == 0 ? clocks : 0;
+        inventory.flags |= RM_INVENTORY_BIOS;
+    }
+}
+
+} // namespace
+
+static int InitMonitor(RMMonitorContext** out_ctx)
+{
+    if (!out_ctx)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    *out_ctx = nullptr;
+    wchar_t replayDirectory[MAX_PATH] = {};
+    DWORD replayLen = GetEnvironmentVariableW(kReplayEnvVar, replayDirectory, MAX_PATH);
+    if (replayLen > 0)
+    {
+        if (replayLen >= MAX_PATH)
+        {
+            return RM_STATUS_INVALID_ARG;
+        }
+        return rm_monitor_init_replay(out_ctx, replayDirectory, 1.0);
+    }
+
+    wchar_t simulatorScript[MAX_PATH] = {};
+    SetLastError(ERROR_SUCCESS);
+    DWORD simulatorLen = GetEnvironmentVariableW(kSimulatorEnvVar, simulatorScript, MAX_PATH);
+    if (simulatorLen != 0 || GetLastError() != ERROR_ENVVAR_NOT_FOUND)
+    {
+        if (simulatorLen >= MAX_PATH)
+        {
+            return RM_STATUS_INVALID_ARG;
+        }
+        const bool builtin = simulatorLen == 0 || _wcsicmp(simulatorScript, L"builtin") == 0;
+        return rm_monitor_init_simulated(out_ctx, builtin ? nullptr : simulatorScript, 1.0, 0);
+    }
+
+    // Admin rights belong to this process, so they are the one check that is
+    // never cached.
+    if (!IsUserAnAdmin())
+    {
+        return RM_STATUS_NOT_ADMIN;
+    }
+
+    const uint64_t stamp = PlatformStamp();
+    RMPlatformInventory inventory;
+    bool changed = false;
+    if (!LoadPlatformInventory(inventory, stamp))
+    {
+        ProbeHostInventory(inventory, stamp);
+        changed = true;
+    }
+    const auto finish = [&](int status)
+    {
+        if (changed)
+        {
+            StorePlatformInventory(inventory);
+        }
+        return status;
+    };
+
+    if (!(inventory.flags & RM_INVENTORY_OS_SUPPORTED))
+    {
+        return finish(RM_STATUS_UNSUPPORTED_OS);
+    }
+    if (!(inventory.flags & RM_INVENTORY_AUTHENTIC_AMD))
+    {
+        return finish(RM_STATUS_NOT_AMD);
+    }
+    if (!(inventory.flags & RM_INVENTORY_DRIVER_RUNNING))
+    {
+        LONGLONG queryStart = SdkCallStart();
+        int service = QueryDrvService();
+        RecordSdkCall(RM_SDK_CALL_QUERY_DRIVER, queryStart, service < 0 ? service : 0);
+        if (service < 0)
+        {
+            LONGLONG installStart = SdkCallStart();
+            bool installed = InstallDriver();
+            RecordSdkCall(RM_SDK_CALL_INSTALL_DRIVER, installStart, installed ? 0 : -1);
+            if (!installed)
+            {
+                return finish(RM_STATUS_DRIVER);
+            }
+        }
+        inventory.flags |= RM_INVENTORY_DRIVER_RUNNING;
+        changed = true;
+    }
+    if (!(inventory.flags & RM_INVENTORY_CPU_SUPPORTED))
+    {
+        return finish(RM_STATUS_UNSUPPORTED_CPU);
+    }
+
+    std::unique_ptr<RyzenSdkSource> source(new (std::nothrow) RyzenSdkSource());
+    if (!source)
+    {
+        return finish(RM_STATUS_ALLOC_FAILED);
+    }
+    if (!source->Init())
+    {
+        // The driver may have been stopped since it was cached as running;
+        // query the service again on the next attempt.
+        inventory.flags &= ~RM_INVENTORY_DRIVER_RUNNING;
+        changed = true;
+        return finish(RM_STATUS_SDK_INIT_FAILED);
+    }
+    if (!(inventory.flags & RM_INVENTORY_DEVICES))
+    {
+        FillDeviceInventory(*source, inventory);
+        changed = true;
+    }
+
+    return finish(AttachSource(out_ctx, std::move(source)));
+}
+
+extern "C" int rm_monitor_init(RMMonitorContext** out_ctx)
+{
+    return CountMonitorStatus(InitMonitor(out_ctx));
+}
+
+// Reads all sockets into ctx->sockets and combines them into `snapshot`.
+static int ReadSockets(RMMonitorContext* ctx, RMCpuSnapshot& snapshot)
+{
+    RMSocketSnapshots& sockets = *ctx->sockets;
+    ctx->reader.Read(sockets);
+    if (!CombineSocketSnapshots(sockets, snapshot))
+    {
+        return RM_STATUS_READ_FAILED;
+    }
+
+    snapshot.status = RM_STATUS_OK;
+    snapshot.timestamp_ms = GetTickCount64();
+    sockets.timestamp_ms = snapshot.timestamp_ms;
+    return RM_STATUS_OK;
+}
+
+extern "C" int rm_monitor_read(RMMonitorContext* ctx, double* temperatureC, double* powerW, double* usagePercent)
+{
+    if (!ctx || !temperatureC || !powerW || !usagePercent)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    double temp = 0.0;
+    double power = 0.0;
+    double usage = 0.0;
+    if (ctx->sockets->socket_count > 1)
+    {
+        RMCpuSnapshot combined;
+        if (ReadSockets(ctx, combined) != RM_STATUS_OK)
+        {
+            return CountMonitorStatus(RM_STATUS_READ_FAILED);
+        }
+        temp = combined.temperature_c;
+        power = combined.power_w;
+        usage = combined.usage_percent;
+    }
+    else if (!ReadCPUTelemetry(ctx->cpu, temp, power, usage))
+    {
+        return CountMonitorStatus(RM_STATUS_READ_FAILED);
+    }
+
+    *temperatureC = temp;
+    *powerW = power;
+    *usagePercent = usage;
+    return CountMonitorStatus(RM_STATUS_OK);
+}
+
+extern "C" int rm_monitor_read_snapshot(RMMonitorContext* ctx, RMCpuSnapshot* snapshot)
+{
+    if (!ctx || !snapshot)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    return CountMonitorStatus(ReadSockets(ctx, *snapshot));
+}
+
+// Reads every socket like rm_monitor_read_snapshot and returns them one by
+// one; combined (optional) receives the view rm_monitor_read_snapshot returns.
+// Fails only when no socket could be read.
+extern "C" int rm_monitor_read_sockets(RMMonitorContext* ctx, RMSocketSnapshots* sockets, RMCpuSnapshot* combined)
+{
+    if (!ctx || !sockets)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    RMCpuSnapshot scratch;
+    const int status = ReadSockets(ctx, combined ? *combined : scratch);
+    *sockets = *ctx->sockets;
+    return CountMonitorStatus(status);
+}
+
+extern "C" int rm_monitor_get_socket_count(RMMonitorContext* ctx, unsigned int* count)
+{
+    if (!ctx || !count)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    *count = ctx->sockets->socket_count;
+    return RM_STATUS_OK;
+}
+
+// Copies the core-to-CCX/CCD mapping built when the context was created.
+// core_order and the domain ranges index the per-core arrays of RMCpuSnapshot.
+extern "C" int rm_monitor_get_topology(RMMonitorContext* ctx, RMTopology* topology)
+{
+    if (!ctx || !topology)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    if (!ctx->topology.core_count)
+    {
+        return RM_STATUS_READ_FAILED;
+    }
+
+    *topology = ctx->topology;
+    return RM_STATUS_OK;
+}
+
+extern "C" void rm_monitor_shutdown(RMMonitorContext* ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+
+    StopSamplerForContext(ctx);
+    delete ctx;
+}
+
+namespace {
+
+constexpr uint32_t kIpcVersion = 1;
+constexpr uint32_t kIpcRingVersion = 3;
+constexpr uint32_t kIpcRingCapacity = RM_IPC_RING_CAPACITY;
+constexpr wchar_t kIpcMapName[] = L"Global\\RyzenTelemetryShared";
+constexpr wchar_t kIpcRingMapName[] = L"Global\\RyzenTelemetrySharedV3";
+constexpr uint32_t kIpcAggregateVersion = 1;
+constexpr wchar_t kIpcAggregateMapName[] = L"Global\\RyzenTelemetryAggregates";
+constexpr uint32_t kIpcTopologyVersion = 1;
+constexpr wchar_t kIpcTopologyMapName[] = L"Global\\RyzenTelemetryTopology";
+constexpr uint32_t kIpcSamplerVersion = 1;
+constexpr wchar_t kIpcSamplerMapName[] = L"Global\\RyzenTelemetrySampler";
+constexpr uint32_t kIpcSocketsVersion = 1;
+constexpr wchar_t kIpcSocketsMapName[] = L"Global\\RyzenTelemetrySockets";
+constexpr uint32_t kIpcInventoryVersion = 2;
+constexpr wchar_t kIpcInventoryMapName[] = L"Global\\RyzenTelemetryInventory";
+constexpr uint32_t kIpcStatsVersion = 1;
+constexpr wchar_t kIpcStatsMapName[] = L"Global\\RyzenTelemetryStats";
+constexpr wchar_t kIpcOwnerMutexName[] = L"Global\\RyzenTelemetryOwner";
+constexpr wchar_t kIpcServiceEventName[] = L"Global\\RyzenTelemetryService";
+// rm_ipc_wait sleeps on these manual-reset events; see RingWake.
+constexpr uint32_t kIpcWakeEventCount = 4;
+constexpr const wchar_t* kIpcWakeEventNames[kIpcWakeEventCount] = {
+    L"Global\\RyzenTelemetryWake0",
+    L"Global\\RyzenTelemetryWake1",
+    L"Global\\RyzenTelemetryWake2",
+    L"Global\\RyzenTelemetryWake3"
+};
+constexpr wchar_t kIpcSecurityDescriptor[] = L"D:(A;;GA;;;WD)";
+
+enum IpcResult
+{
+    IPC_OK = 0,
+    IPC_NOT_READY = 1,
+    IPC_STALE = 2,
+    IPC_ERROR = 3,
+    IPC_TIMEOUT = 4
+};
+
+struct RMSharedTelemetry
+{
+    uint32_t version;
+    uint32_t size;
+    volatile LONG seq;
+    uint32_t status;
+    uint32_t reserved;
+    ULONGLONG timestamp_ms;
+    double temperature_c;
+    double power_w;
+    double usage_percent;
+    uint32_t writer_pid;
+    uint32_t reserved2;
+};
+
+constexpr size_t kCacheLine = 64;
+
+// Each slot carries its own seqlock so a reader only ever retries the slot it
+// is copying, never the whole ring. A slot fills exactly one cache line: the
+// sequence stays with its payload because every read needs both, and no slot
+// shares a line with its neighbours.
+struct alignas(kCacheLine) RMSharedSlot
+{
+    volatile LONG seq;
+    uint32_t reserved;
+    RMIpcSample sample;
+};
+
+static_assert(sizeof(RMSharedSlot) == kCacheLine, "ring slot must fill one cache line");
+
+// Full snapshots are double-buffered: the writer fills the buffer readers are
+// not pointed at, then flips snapshot_index.
+struct RMSharedSnapshot
+{
+    volatile LONG seq;
+    uint32_t reserved;
+    RMCpuSnapshot snapshot;
+};
+
+// The per-core summary fields took over padding; the ring layout must not move.
+static_assert(offsetof(RMCpuSnapshot, core_freq_mhz) == 256, "RMCpuSnapshot scalar block outgrew its padding");
+
+// v3 mapping: fixed-capacity ring of samples. write_cursor counts every sample
+// ever published; the sample with cursor N lives in slot N % capacity.
+// Fields with different writers sit on separate cache lines: the header is
+// written once, write_cursor, writer_pid and wake_signaled by the writer on
+// every publish, waiters by consumers entering rm_ipc_wait. Readers only load
+// the header, the cursor and the slots, so those lines stay shared between
+// them instead of moving with every read. (v2 packed all of this into the first line.)
+struct RMSharedTelemetryV3
+{
+    uint32_t version;
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t slot_size;
+    alignas(kCacheLine) volatile LONG64 write_cursor;
+    alignas(kCacheLine) uint32_t writer_pid;
+    uint32_t wake_signaled;     // wake events the writer has set and not reset yet
+    alignas(kCacheLine) volatile LONG waiters;
+    RMSharedSlot slots[kIpcRingCapacity];
+    alignas(kCacheLine) volatile LONG snapshot_index;
+    RMSharedSnapshot snapshots[2];
+};
+
+static_assert(offsetof(RMSharedTelemetryV3, write_cursor) == kCacheLine &&
+              offsetof(RMSharedTelemetryV3, writer_pid) == 2 * kCacheLine &&
+              offsetof(RMSharedTelemetryV3, waiters) == 3 * kCacheLine &&
+              offsetof(RMSharedTelemetryV3, slots) == 4 * kCacheLine,
+              "ring header fields must each own a cache line");
+
+// Values published beside the ring (rolling aggregates, domain statistics)
+// get a mapping each, so the ring layout stays unchanged. Each mapping holds
+// one value, double-buffered like the ring snapshots.
+template <typename T>
+struct RMSharedPage
+{
+    volatile LONG seq;
+    uint32_t reserved;
+    T value;
+};
+
+template <typename T>
+struct RMSharedPages
+{
+    uint32_t version;
+    uint32_t size;
+    volatile LONG page_index;
+    uint32_t writer_pid;
+    RMSharedPage<T> pages[2];
+};
+
+using RMSharedAggregates = RMSharedPages<RMAggregateSnapshot>;
+using RMSharedTopology = RMSharedPages<RMTopologySnapshot>;
+using RMSharedSampler = RMSharedPages<RMSamplerStatus>;
+using RMSharedSockets = RMSharedPages<RMSocketSnapshots>;
+using RMSharedInventory = RMSharedPages<RMPlatformInventory>;
+
+static HANDLE g_ipc_service_event = nullptr;
+static HANDLE g_ipc_owner_mutex = nullptr;
+static bool g_ipc_owner_held = false;
+
+// Serializes the publishers of this process (the sampler, rm_replay_run and
+// direct rm_ipc_publish* callers). The slot seqlocks and the write cursor
+// assume a single writer, and a snapshot must get the cursor of the sample
+// published after it.
+static SRWLOCK g_publish_lock = SRWLOCK_INIT;
+
+class SecurityAttributesHolder
+{
+public:
+    SecurityAttributesHolder()
+    {
+        attrs_.nLength = sizeof(attrs_);
+        attrs_.bInheritHandle = FALSE;
+        if (ConvertStringSecurityDescriptorToSecurityDescriptorW(
+                kIpcSecurityDescriptor,
+                SDDL_REVISION_1,
+                &descriptor_,
+                nullptr))
+        {
+            attrs_.lpSecurityDescriptor = descriptor_;
+        }
+        else
+        {
+            descriptor_ = nullptr;
+            attrs_.lpSecurityDescriptor = nullptr;
+        }
+    }
+
+    ~SecurityAttributesHolder()
+    {
+        if (descriptor_)
+        {
+            LocalFree(descriptor_);
+            descriptor_ = nullptr;
+        }
+    }
+
+    SECURITY_ATTRIBUTES* Get()
+    {
+        return descriptor_ ? &attrs_ : nullptr;
+    }
+
+private:
+    SECURITY_ATTRIBUTES attrs_{};
+    PSECURITY_DESCRIPTOR descriptor_ = nullptr;
+};
+
+SECURITY_ATTRIBUTES* GetIpcSecurityAttributes()
+{
+    static SecurityAttributesHolder holder;
+    return holder.Get();
+}
+
+void* MapSharedBlock(const wchar_t* name, size_t size, bool& created)
+{
+    HANDLE map = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        GetIpcSecurityAttributes(),
+        PAGE_READWRITE,
+        0,
+        static_cast<DWORD>(size),
+        name);
+    if (!map)
+    {
+        return nullptr;
+    }
+
+    created = (GetLastError() != ERROR_ALREADY_EXISTS);
+    void* view = MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(map);
+        return nullptr;
+    }
+
+    // The mapping handle stays open for the lifetime of the process.
+    return view;
+}
+
+RMSharedTelemetry* GetSharedTelemetry()
+{
+    static RMSharedTelemetry* s_view = nullptr;
+
+    if (s_view)
+    {
+        return s_view;
+    }
+
+    bool created = false;
+    void* view = MapSharedBlock(kIpcMapName, sizeof(RMSharedTelemetry), created);
+    if (!view)
+    {
+        return nullptr;
+    }
+
+    s_view = static_cast<RMSharedTelemetry*>(view);
+
+    if (created)
+    {
+        ZeroMemory(s_view, sizeof(RMSharedTelemetry));
+        s_view->version = kIpcVersion;
+        s_view->size = sizeof(RMSharedTelemetry);
+    }
+
+    return s_view;
+}
+
+RMSharedTelemetryV3* GetSharedRing()
+{
+    static RMSharedTelemetryV3* s_view = nullptr;
+
+    if (s_view)
+    {
+        return s_view;
+    }
+
+    bool created = false;
+    void* view = MapSharedBlock(kIpcRingMapName, sizeof(RMSharedTelemetryV3), created);
+    if (!view)
+    {
+        return nullptr;
+    }
+
+    s_view = static_cast<RMSharedTelemetryV3*>(view);
+
+    if (created)
+    {
+        ZeroMemory(s_view, sizeof(RMSharedTelemetryV3));
+        s_view->version = kIpcRingVersion;
+        s_view->size = sizeof(RMSharedTelemetryV3);
+        s_view->capacity = kIpcRingCapacity;
+        s_view->slot_size = sizeof(RMSharedSlot);
+    }
+
+    return s_view;
+}
+
+bool IsRingCompatible(const RMSharedTelemetryV3* ring)
+{
+    return ring->version == kIpcRingVersion &&
+           ring->size == sizeof(RMSharedTelemetryV3) &&
+           ring->capacity == kIpcRingCapacity &&
+           ring->slot_size == sizeof(RMSharedSlot);
+}
+
+// Plain acquire loads: readers must not take ownership of the lines they poll,
+// which a locked read-modify-write would.
+LONG AtomicRead(volatile LONG* value)
+{
+    return ReadAcquire(value);
+}
+
+LONG64 AtomicRead64(volatile LONG64* value)
+{
+    return ReadAcquire64(value);
+}
+
+// Orders a seqlock reader's payload copy before it reads the sequence again.
+// x64 does not reorder loads with loads, so there this only restrains the
+// compiler.
+void SeqlockReadFence()
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+// Instrumentation counters get a mapping of their own that every process adds
+// to with interlocked operations, so a tool can scrape them without owning the
+// SDK. If the mapping cannot be opened the counters stay process-local.
+struct RMSharedStats
+{
+    uint32_t version;
+    uint32_t size;
+    RMStats stats;
+};
+
+constexpr uint32_t kLatencySubBits = 4;
+static_assert(RM_LATENCY_SUB_BUCKETS == 1u << kLatencySubBits, "latency sub-bucket count");
+static_assert(RM_LATENCY_BUCKETS == RM_LATENCY_SUB_BUCKETS * (32 - kLatencySubBits + 1), "latency buckets must reach 2^32 us");
+
+static RMSharedStats g_local_stats;
+
+RMSharedStats* GetStatsPage()
+{
+    static RMSharedStats* s_page = []()
+    {
+        bool created = false;
+        RMSharedStats* page = static_cast<RMSharedStats*>(MapSharedBlock(kIpcStatsMapName, sizeof(RMSharedStats), created));
+        if (page && created)
+        {
+            ZeroMemory(page, sizeof(RMSharedStats));
+            page->version = kIpcStatsVersion;
+            page->size = sizeof(RMSharedStats);
+            page->stats.since_ms = GetTickCount64();
+        }
+        if (!page || page->version != kIpcStatsVersion || page->size != sizeof(RMSharedStats))
+        {
+            g_local_stats.stats.since_ms = GetTickCount64();
+            return &g_local_stats;
+        }
+        return page;
+    }();
+    return s_page;
+}
+
+volatile LONG64* Counter(uint64_t& value)
+{
+    return reinterpret_cast<volatile LONG64*>(&value);
+}
+
+void CountEvent(RMStats& stats, uint64_t RMStats::*counter)
+{
+    InterlockedIncrement64(Counter(stats.*counter));
+}
+
+void CountEvent(uint64_t RMStats::*counter)
+{
+    CountEvent(GetStatsPage()->stats, counter);
+}
+
+uint32_t LatencyBucket(uint64_t us)
+{
+    if (us < RM_LATENCY_SUB_BUCKETS)
+    {
+        return static_cast<uint32_t>(us);
+    }
+    unsigned long msb = 0;
+    _BitScanReverse64(&msb, us);
+    if (msb >= 32)
+    {
+        return RM_LATENCY_BUCKETS - 1;
+    }
+    const uint32_t shift = msb - kLatencySubBits;
+    const uint32_t sub = static_cast<uint32_t>(us >> shift) - RM_LATENCY_SUB_BUCKETS;
+    return RM_LATENCY_SUB_BUCKETS + shift * RM_LATENCY_SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in `bucket`.
+uint64_t LatencyBucketHigh(uint32_t bucket)
+{
+    if (bucket < RM_LATENCY_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const uint32_t shift = (bucket - RM_LATENCY_SUB_BUCKETS) / RM_LATENCY_SUB_BUCKETS;
+    const uint64_t top = RM_LATENCY_SUB_BUCKETS + (bucket - RM_LATENCY_SUB_BUCKETS) % RM_LATENCY_SUB_BUCKETS;
+    return ((top + 1) << shift) - 1;
+}
+
+void RecordLatency(RMLatencyHistogram& histogram, uint64_t us, int error)
+{
+    InterlockedIncrement64(Counter(histogram.count));
+    InterlockedExchangeAdd64(Counter(histogram.total_us), static_cast<LONG64>(us));
+    LONG64 seen = AtomicRead64(Counter(histogram.max_us));
+    while (static_cast<LONG64>(us) > seen)
+    {
+        LONG64 previous = InterlockedCompareExchange64(Counter(histogram.max_us), static_cast<LONG64>(us), seen);
+        if (previous == seen)
+        {
+            break;
+        }
+        seen = previous;
+    }
+    InterlockedIncrement(reinterpret_cast<volatile LONG*>(&histogram.buckets[LatencyBucket(us)]));
+    if (error)
+    {
+        InterlockedIncrement64(Counter(histogram.failures));
+        InterlockedExchange(reinterpret_cast<volatile LONG*>(&histogram.last_error), error);
+    }
+}
+
+template <typename T>
+RMSharedPages<T>* GetSharedPages(const wchar_t* name, uint32_t version)
+{
+    static RMSharedPages<T>* s_view = nullptr;
+
+    if (s_view)
+    {
+        return s_view;
+    }
+
+    bool created = false;
+    void* view = MapSharedBlock(name, sizeof(RMSharedPages<T>), created);
+    if (!view)
+    {
+        return nullptr;
+    }
+
+    s_view = static_cast<RMSharedPages<T>*>(view);
+
+    if (created)
+    {
+        ZeroMemory(s_view, sizeof(RMSharedPages<T>));
+        s_view->version = version;
+        s_view->size = sizeof(RMSharedPages<T>);
+    }
+
+    return s_view;
+}
+
+template <typename T>
+bool IsPagesCompatible(const RMSharedPages<T>* shared, uint32_t version)
+{
+    return shared->version == version &&
+           shared->size == sizeof(RMSharedPages<T>);
+}
+
+RMSharedAggregates* GetSharedAggregates()
+{
+    RMSharedAggregates* shared = GetSharedPages<RMAggregateSnapshot>(kIpcAggregateMapName, kIpcAggregateVersion);
+    return shared && IsPagesCompatible(shared, kIpcAggregateVersion) ? shared : nullptr;
+}
+
+RMSharedTopology* GetSharedTopology()
+{
+    RMSharedTopology* shared = GetSharedPages<RMTopologySnapshot>(kIpcTopologyMapName, kIpcTopologyVersion);
+    return shared && IsPagesCompatible(shared, kIpcTopologyVersion) ? shared : nullptr;
+}
+
+RMSharedSampler* GetSharedSampler()
+{
+    RMSharedSampler* shared = GetSharedPages<RMSamplerStatus>(kIpcSamplerMapName, kIpcSamplerVersion);
+    return shared && IsPagesCompatible(shared, kIpcSamplerVersion) ? shared : nullptr;
+}
+
+RMSharedSockets* GetSharedSockets()
+{
+    RMSharedSockets* shared = GetSharedPages<RMSocketSnapshots>(kIpcSocketsMapName, kIpcSocketsVersion);
+    return shared && IsPagesCompatible(shared, kIpcSocketsVersion) ? shared : nullptr;
+}
+
+RMSharedInventory* GetSharedInventory()
+{
+    RMSharedInventory* shared = GetSharedPages<RMPlatformInventory>(kIpcInventoryMapName, kIpcInventoryVersion);
+    return shared && IsPagesCompatible(shared, kIpcInventoryVersion) ? shared : nullptr;
+}
+
+// Returns the page readers are not pointed at, with its seqlock taken.
+// Publishers must be serialized by the caller.
+template <typename T>
+T& BeginPageWrite(RMSharedPages<T>* shared, LONG& next)
+{
+    next = AtomicRead(&shared->page_index) ^ 1;
+    InterlockedIncrement(&shared->pages[next].seq);
+    return shared->pages[next].value;
+}
+
+template <typename T>
+void EndPageWrite(RMSharedPages<T>* shared, LONG next)
+{
+    InterlockedIncrement(&shared->pages[next].seq);
+    shared->writer_pid = GetCurrentProcessId();
+    InterlockedExchange(&shared->page_index, next);
+}
+
+// Reads the current page the way rm_ipc_read_snapshot reads the snapshot.
+template <typename T>
+int ReadSharedPage(RMSharedPages<T>* shared, T& out, unsigned int max_age_ms)
+{
+    if (!shared)
+    {
+        return IPC_NOT_READY;
+    }
+
+    bool read = false;
+    for (int attempt = 0; attempt < 3 && !read; ++attempt)
+    {
+        LONG index = AtomicRead(&shared->page_index) & 1;
+        RMSharedPage<T>& source = shared->pages[index];
+
+        LONG seq1 = AtomicRead(&source.seq);
+        if (seq1 & 1)
+        {
+            CountEvent(&RMStats::torn_read_retries);
+            continue;
+        }
+
+        out = source.value;
+        SeqlockReadFence();
+        LONG seq2 = AtomicRead(&source.seq);
+        read = seq1 == seq2;
+        if (!read)
+        {
+            CountEvent(&RMStats::torn_read_retries);
+        }
+    }
+
+    if (!read)
+    {
+        CountEvent(&RMStats::torn_read_failures);
+        return IPC_NOT_READY;
+    }
+    if (out.timestamp_ms == 0)
+    {
+        return IPC_NOT_READY;
+    }
+
+    if (max_age_ms > 0)
+    {
+        ULONGLONG now = GetTickCount64();
+        if (now >= out.timestamp_ms &&
+            now - out.timestamp_ms > static_cast<ULONGLONG>(max_age_ms))
+        {
+            CountEvent(&RMStats::stale_reads);
+            return IPC_STALE;
+        }
+    }
+
+    return IPC_OK;
+}
+
+// Copies the sample with the given cursor out of the ring. Fails if the slot is
+// being written or has already been recycled for a newer sample. Torn reads
+// are counted in `stats`.
+bool ReadRingSlot(RMSharedTelemetryV3* ring, uint64_t cursor, RMIpcSample& out, RMStats& stats)
+{
+    RMSharedSlot& slot = ring->slots[cursor % kIpcRingCapacity];
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        LONG seq1 = AtomicRead(&slot.seq);
+        if (seq1 & 1)
+        {
+            CountEvent(stats, &RMStats::torn_read_retries);
+            YieldProcessor();
+            continue;
+        }
+
+        out = slot.sample;
+        SeqlockReadFence();
+        LONG seq2 = AtomicRead(&slot.seq);
+        if (seq1 == seq2)
+        {
+            return out.cursor == cursor;
+        }
+        CountEvent(stats, &RMStats::torn_read_retries);
+    }
+    CountEvent(stats, &RMStats::torn_read_failures);
+    return false;
+}
+
+// Copies the newest sample out of the ring, retrying when the writer laps the
+// slot being read.
+bool ReadRingLatest(RMSharedTelemetryV3* ring, RMIpcSample& out, RMStats& stats)
+{
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+        uint64_t next = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+        if (next == 0)
+        {
+            return false;
+        }
+        if (ReadRingSlot(ring, next - 1, out, stats))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// rm_ipc_wait sleeps on kIpcWakeEventCount manual-reset events. The publish
+// that moves the write cursor to N resets event N % kIpcWakeEventCount, and
+// the publish after it sets that event, so a consumer that saw cursor N sleeps
+// on an event that stays clear until sample N is out. Nothing is counted per
+// wakeup: a consumer that times out or finds the cursor already moved leaves
+// no token behind, and `waiters` (which only consumers change) merely tells
+// the writer whether to bother setting an event; a consumer that dies while
+// registered costs the writer a SetEvent per publish, not anyone a spurious
+// wakeup. The event a consumer picked is only reset again
+// kIpcWakeEventCount - 1 publishes later; if that many land between its check
+// and its wait, it sleeps until the next publish.
+struct RingWake
+{
+    HANDLE events[kIpcWakeEventCount] = {};
+};
+
+// The shared ring uses the named events; the private ring of rm_ipc_bench
+// uses unnamed ones.
+bool CreateRingWake(RingWake& wake, bool named)
+{
+    for (uint32_t i = 0; i < kIpcWakeEventCount; ++i)
+    {
+        if (!wake.events[i])
+        {
+            wake.events[i] = named
+                ? CreateEventW(GetIpcSecurityAttributes(), TRUE, FALSE, kIpcWakeEventNames[i])
+                : CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        }
+        if (!wake.events[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CloseRingWake(RingWake& wake)
+{
+    for (HANDLE& event : wake.events)
+    {
+        if (event)
+        {
+            CloseHandle(event);
+            event = nullptr;
+        }
+    }
+}
+
+const RingWake* GetSharedRingWake()
+{
+    static RingWake s_wake;
+    return CreateRingWake(s_wake, true) ? &s_wake : nullptr;
+}
+
+// Runs before the sample with `cursor` is published: resets the event the
+// publish after it will set. Only events this ring's writer set are reset, so
+// publishing while nobody waits makes no system call.
+void RearmRingWake(RMSharedTelemetryV3* ring, const RingWake& wake, uint64_t cursor)
+{
+    const uint32_t bit = 1u << ((cursor + 1) % kIpcWakeEventCount);
+    if (ring->wake_signaled & bit)
+    {
+        ResetEvent(wake.events[(cursor + 1) % kIpcWakeEventCount]);
+        ring->wake_signaled &= ~bit;
+    }
+}
+
+// Runs after the sample with `cursor` is published.
+void WakeRingWaiters(RMSharedTelemetryV3* ring, const RingWake& wake, uint64_t cursor)
+{
+    // The write_cursor exchange before this is a full barrier, and waiters
+    // register before re-checking the cursor, so a load seeing no waiters
+    // cannot miss one. It spares the line a locked write on every publish.
+    if (AtomicRead(&ring->waiters) <= 0)
+    {
+        return;
+    }
+    // Marked before the event is set, so a writer that dies in between
+    // leaves at most an extra reset for the next one.
+    ring->wake_signaled |= 1u << (cursor % kIpcWakeEventCount);
+    SetEvent(wake.events[cursor % kIpcWakeEventCount]);
+}
+
+// Has a single writer: publishes to the shared ring hold g_publish_lock, and
+// rm_ipc_bench writes its private ring from one thread.
+void PublishToRing(RMSharedTelemetryV3* ring, const RMIpcSample& sample_in)
+{
+    uint64_t cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+    RMSharedSlot& slot = ring->slots[cursor % kIpcRingCapacity];
+
+    InterlockedIncrement(&slot.seq);
+    slot.sample = sample_in;
+    slot.sample.cursor = cursor;
+    InterlockedIncrement(&slot.seq);
+
+    ring->writer_pid = GetCurrentProcessId();
+    InterlockedExchange64(&ring->write_cursor, static_cast<LONG64>(cursor + 1));
+}
+
+void PublishAndWake(RMSharedTelemetryV3* ring, const RingWake& wake, const RMIpcSample& sample)
+{
+    const uint64_t cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+    RearmRingWake(ring, wake, cursor);
+    PublishToRing(ring, sample);
+    WakeRingWaiters(ring, wake, cursor);
+}
+
+// Body of rm_ipc_wait, also run by the rm_ipc_bench waiters on their private
+// ring. `spurious`, when set, counts wakeups that found the cursor unmoved.
+int WaitRing(RMSharedTelemetryV3* ring, const RingWake& wake, uint64_t seq, unsigned int timeout_ms,
+    uint64_t& current, uint64_t* spurious)
+{
+    ULONGLONG start = GetTickCount64();
+    for (;;)
+    {
+        uint64_t cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+        if (cursor > seq)
+        {
+            current = cursor;
+            return IPC_OK;
+        }
+
+        // Register before re-checking so a publish between the check and the
+        // wait sees a waiter and sets the event. Every path below drops the
+        // registration again, whether it waited, timed out or not.
+        InterlockedIncrement(&ring->waiters);
+        cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+        const bool waits = cursor <= seq;
+        DWORD wait = WAIT_OBJECT_0;
+        if (waits)
+        {
+            DWORD wait_ms = INFINITE;
+            if (timeout_ms != INFINITE)
+            {
+                ULONGLONG elapsed = GetTickCount64() - start;
+                wait_ms = elapsed >= timeout_ms ? 0 : static_cast<DWORD>(timeout_ms - elapsed);
+            }
+            wait = WaitForSingleObject(wake.events[cursor % kIpcWakeEventCount], wait_ms);
+        }
+        InterlockedDecrement(&ring->waiters);
+
+        if (wait == WAIT_TIMEOUT)
+        {
+            current = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+            return current > seq ? IPC_OK : IPC_TIMEOUT;
+        }
+        if (wait != WAIT_OBJECT_0)
+        {
+            return IPC_ERROR;
+        }
+        if (waits && static_cast<uint64_t>(AtomicRead64(&ring->write_cursor)) == cursor)
+        {
+            if (spurious)
+            {
+                ++*spurious;
+            }
+            // Even a wake that should not happen cannot keep the caller past
+            // its timeout.
+            if (timeout_ms != INFINITE && GetTickCount64() - start >= timeout_ms)
+            {
+                current = cursor;
+                return IPC_TIMEOUT;
+            }
+        }
+    }
+}
+
+} // namespace
+
+static LONGLONG SdkCallStart()
+{
+    return QpcNow();
+}
+
+// Adds one call that started at `start` to the call's latency histogram;
+// a non-zero `error` also counts as a failure.
+static void RecordSdkCall(uint32_t call, LONGLONG start, int error)
+{
+    if (call < RM_SDK_CALL_COUNT)
+    {
+        RecordLatency(GetStatsPage()->stats.calls[call], QpcToMicroseconds(QpcNow() - start), error);
+    }
+}
+
+// Counts a result of an rm_monitor_* call and passes it through.
+static int CountMonitorStatus(int status)
+{
+    const uint32_t index = std::min<uint32_t>(static_cast<uint32_t>(status), RM_STATUS_CODE_COUNT - 1);
+    InterlockedIncrement64(Counter(GetStatsPage()->stats.status_counts[index]));
+    return status;
+}
+
+// Copies the instrumentation counters (see RMStats). Any process can call it;
+// the SDK does not have to be loaded.
+extern "C" int rm_stats_snapshot(RMStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    const RMSharedStats* page = GetStatsPage();
+    *stats = page->stats;
+    stats->timestamp_ms = GetTickCount64();
+    stats->shared = page != &g_local_stats ? 1 : 0;
+    return RM_STATUS_OK;
+}
+
+// Estimates a quantile (0 to 1) of a latency histogram in microseconds: the
+// highest value of the bucket it falls in, capped at max_us. Returns 0 for an
+// empty histogram.
+extern "C" double rm_stats_percentile(const RMLatencyHistogram* histogram, double quantile)
+{
+    if (!histogram)
+    {
+        return 0.0;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t bucket = 0; bucket < RM_LATENCY_BUCKETS; ++bucket)
+    {
+        total += histogram->buckets[bucket];
+    }
+    if (!total)
+    {
+        return 0.0;
+    }
+
+    const double target = std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total);
+    uint64_t cumulative = 0;
+    for (uint32_t bucket = 0; bucket < RM_LATENCY_BUCKETS; ++bucket)
+    {
+        cumulative += histogram->buckets[bucket];
+        if (histogram->buckets[bucket] && static_cast<double>(cumulative) >= target)
+        {
+            return static_cast<double>(std::min(LatencyBucketHigh(bucket), histogram->max_us));
+        }
+    }
+    return static_cast<double>(histogram->max_us);
+}
+
+namespace {
+
+// The caller holds g_publish_lock.
+int PublishSample(const RMIpcSample& sample)
+{
+    RMSharedTelemetry* shared = GetSharedTelemetry();
+    if (!shared)
+    {
+        return IPC_ERROR;
+    }
+
+    InterlockedIncrement(&shared->seq);
+    shared->version = kIpcVersion;
+    shared->size = sizeof(RMSharedTelemetry);
+    shared->status = static_cast<uint32_t>(sample.status);
+    shared->timestamp_ms = sample.timestamp_ms;
+    shared->temperature_c = sample.temperature_c;
+    shared->power_w = sample.power_w;
+    shared->usage_percent = sample.usage_percent;
+    shared->writer_pid = GetCurrentProcessId();
+    InterlockedIncrement(&shared->seq);
+
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    if (ring && IsRingCompatible(ring))
+    {
+        const RingWake* wake = GetSharedRingWake();
+        if (wake)
+        {
+            PublishAndWake(ring, *wake, sample);
+        }
+        else
+        {
+            PublishToRing(ring, sample);
+        }
+    }
+
+    return IPC_OK;
+}
+
+void PublishSnapshotToRing(RMSharedTelemetryV3* ring, const RMCpuSnapshot& snapshot, uint64_t timestamp_ms)
+{
+    LONG next = AtomicRead(&ring->snapshot_index) ^ 1;
+    RMSharedSnapshot& target = ring->snapshots[next];
+
+    InterlockedIncrement(&target.seq);
+    target.snapshot = snapshot;
+    target.snapshot.cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+    target.snapshot.timestamp_ms = timestamp_ms;
+    InterlockedIncrement(&target.seq);
+
+    InterlockedExchange(&ring->snapshot_index, next);
+}
+
+bool ReadSnapshotFromRing(RMSharedTelemetryV3* ring, RMCpuSnapshot& out)
+{
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+        LONG index = AtomicRead(&ring->snapshot_index) & 1;
+        RMSharedSnapshot& source = ring->snapshots[index];
+
+        LONG seq1 = AtomicRead(&source.seq);
+        if (seq1 & 1)
+        {
+            CountEvent(&RMStats::torn_read_retries);
+            continue;
+        }
+
+        out = source.snapshot;
+        SeqlockReadFence();
+        LONG seq2 = AtomicRead(&source.seq);
+        if (seq1 == seq2)
+        {
+            return true;
+        }
+        CountEvent(&RMStats::torn_read_retries);
+    }
+    CountEvent(&RMStats::torn_read_failures);
+    return false;
+}
+
+struct AggregatorState
+{
+    SRWLOCK lock = SRWLOCK_INIT;
+    StreamingAggregator aggregator;
+};
+
+static AggregatorState g_aggregator;
+
+// Folds the snapshot into the rolling windows and publishes the result. The
+// lock only orders concurrent publishers; readers go through the seqlock.
+void PublishAggregates(const RMCpuSnapshot& snapshot, uint64_t cursor, uint64_t timestamp_ms)
+{
+    RMSharedAggregates* shared = GetSharedAggregates();
+    if (!shared)
+    {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&g_aggregator.lock);
+    if (g_aggregator.aggregator.Add(snapshot, timestamp_ms))
+    {
+        LONG next = 0;
+        RMAggregateSnapshot& target = BeginPageWrite(shared, next);
+        g_aggregator.aggregator.Fill(target);
+        target.cursor = cursor;
+        EndPageWrite(shared, next);
+    }
+    ReleaseSRWLockExclusive(&g_aggregator.lock);
+}
+
+struct TopologyState
+{
+    SRWLOCK lock = SRWLOCK_INIT;
+    RMTopology topology = {};
+};
+
+static TopologyState g_topology;
+
+// Reduces the snapshot per CCX and CCD and publishes the result. A snapshot
+// whose core count does not match the current layout (for instance one passed
+// straight to rm_ipc_publish_snapshot) gets a layout built from the OS alone.
+void PublishTopology(const RMCpuSnapshot& snapshot, uint64_t cursor, uint64_t timestamp_ms)
+{
+    RMSharedTopology* shared = GetSharedTopology();
+    if (!shared || snapshot.status != RM_STATUS_OK)
+    {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&g_topology.lock);
+    const uint32_t core_count = std::min<uint32_t>(snapshot.core_count, RM_MAX_CORES);
+    if (g_topology.topology.core_count != core_count)
+    {
+        BuildCoreTopology(nullptr, core_count, g_topology.topology);
+    }
+    if (g_topology.topology.core_count)
+    {
+        LONG next = 0;
+        RMTopologySnapshot& target = BeginPageWrite(shared, next);
+        ComputeDomainStats(g_topology.topology, snapshot, target);
+        target.cursor = cursor;
+        target.timestamp_ms = timestamp_ms;
+        EndPageWrite(shared, next);
+    }
+    ReleaseSRWLockExclusive(&g_topology.lock);
+}
+
 } // namespace
 
-extern "C" int rm_ipc_publish(double temperatureC, double powerW, double usagePercent, int status)
+// Sets the layout used for the published domain statistics. Each new monitor
+// context installs the mapping built from its ICPUEx.
+static void SetPublishTopology(const RMTopology& topology)
 {
-    RMSharedTelemetry* shared = GetSharedTelemetry();
+    AcquireSRWLockExclusive(&g_topology.lock);
+    g_topology.topology = topology;
+    ReleaseSRWLockExclusive(&g_topology.lock);
+}
+
+// Publishes the per-socket snapshots of a monitor context with the cursor of
+// the combined snapshot published next. The caller holds g_publish_lock, which
+// also makes it the page's only writer.
+static void PublishSocketSnapshots(const RMSocketSnapshots& sockets, uint64_t cursor)
+{
+    RMSharedSockets* shared = GetSharedSockets();
     if (!shared)
+    {
+        return;
+    }
+
+    LONG next = 0;
+    RMSocketSnapshots& target = BeginPageWrite(shared, next);
+    target = sockets;
+    target.cursor = cursor;
+    EndPageWrite(shared, next);
+}
+
+extern "C" int rm_ipc_publish(double temperatureC, double powerW, double usagePercent, int status)
+{
+    RMIpcSample sample{};
+    sample.timestamp_ms = GetTickCount64();
+    sample.status = status;
+    sample.temperature_c = temperatureC;
+    sample.power_w = powerW;
+    sample.usage_percent = usagePercent;
+
+    AcquireSRWLockExclusive(&g_publish_lock);
+    const int result = PublishSample(sample);
+    ReleaseSRWLockExclusive(&g_publish_lock);
+    return result;
+}
+
+// Publishes a full snapshot and, from a monitor context, its per-socket
+// snapshots. The snapshot is written before the matching ring sample so a
+// consumer woken by rm_ipc_wait always finds it in place.
+static int PublishSnapshot(const RMCpuSnapshot& snapshot, const RMSocketSnapshots* sockets)
+{
+    RMIpcSample sample{};
+    sample.timestamp_ms = snapshot.timestamp_ms ? snapshot.timestamp_ms : GetTickCount64();
+    sample.status = snapshot.status;
+    sample.temperature_c = snapshot.temperature_c;
+    sample.power_w = snapshot.power_w;
+    sample.usage_percent = snapshot.usage_percent;
+
+    // Everything below only copies or queues, so holding the lock across it
+    // keeps the sockets, the snapshot, the windows and the ring sample on one
+    // cursor.
+    AcquireSRWLockExclusive(&g_publish_lock);
+    uint64_t cursor = 0;
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    const bool ring_ok = ring && IsRingCompatible(ring);
+    if (ring_ok)
+    {
+        cursor = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+    }
+    if (sockets)
+    {
+        PublishSocketSnapshots(*sockets, cursor);
+    }
+    if (ring_ok)
+    {
+        PublishSnapshotToRing(ring, snapshot, sample.timestamp_ms);
+    }
+
+    PublishAggregates(snapshot, cursor, sample.timestamp_ms);
+    PublishTopology(snapshot, cursor, sample.timestamp_ms);
+    RecorderSubmit(snapshot);
+    HidOutputSubmit(snapshot);
+    FanoutPublish(snapshot);
+    const int result = PublishSample(sample);
+    ReleaseSRWLockExclusive(&g_publish_lock);
+    return result;
+}
+
+extern "C" int rm_ipc_publish_snapshot(const RMCpuSnapshot* snapshot)
+{
+    if (!snapshot)
     {
         return IPC_ERROR;
     }
+    return PublishSnapshot(*snapshot, nullptr);
+}
 
-    InterlockedIncrement(&shared->seq);
-    shared->version = kIpcVersion;
-    shared->size = sizeof(RMSharedTelemetry);
-    shared->status = static_cast<uint32_t>(status);
-    shared->timestamp_ms = GetTickCount64();
-    shared->temperature_c = temperatureC;
-    shared->power_w = powerW;
-    shared->usage_percent = usagePercent;
-    shared->writer_pid = GetCurrentProcessId();
-    InterlockedIncrement(&shared->seq);
+extern "C" int rm_ipc_read_snapshot(RMCpuSnapshot* snapshot, unsigned int max_age_ms)
+{
+    if (!snapshot)
+    {
+        return IPC_ERROR;
+    }
+
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    if (!ring || !IsRingCompatible(ring))
+    {
+        return IPC_NOT_READY;
+    }
+
+    if (!ReadSnapshotFromRing(ring, *snapshot) || snapshot->timestamp_ms == 0)
+    {
+        return IPC_NOT_READY;
+    }
+
+    if (max_age_ms > 0)
+    {
+        ULONGLONG now = GetTickCount64();
+        if (now >= snapshot->timestamp_ms &&
+            now - snapshot->timestamp_ms > static_cast<ULONGLONG>(max_age_ms))
+        {
+            CountEvent(&RMStats::stale_reads);
+            return IPC_STALE;
+        }
+    }
 
     return IPC_OK;
 }
 
-extern "C" int rm_ipc_read(
-    double* temperatureC,
-    double* powerW,
-    double* usagePercent,
-    int* status,
-    unsigned int max_age_ms)
+// Hands the newest snapshot in shared memory to this process's own consumers,
+// the HID output stage and the hub sinks, which rm_ipc_publish_snapshot feeds
+// directly in the process that samples. A snapshot already relayed is not
+// handed over again.
+extern "C" int rm_ipc_relay_snapshot(unsigned int max_age_ms)
 {
-    if (!temperatureC || !powerW || !usagePercent)
+    static std::atomic<uint64_t> s_relayed_cursor{ UINT64_MAX };
+
+    RMCpuSnapshot snapshot;
+    const int result = rm_ipc_read_snapshot(&snapshot, max_age_ms);
+    if (result != IPC_OK || s_relayed_cursor.exchange(snapshot.cursor, std::memory_order_relaxed) == snapshot.cursor)
+    {
+        return result;
+    }
+    HidOutputSubmit(snapshot);
+    FanoutPublish(snapshot);
+    return IPC_OK;
+}
+
+// Reads the rolling-window statistics (see RMAggregateSnapshot). cursor matches
+// the snapshot the statistics were last updated with.
+extern "C" int rm_ipc_read_aggregates(RMAggregateSnapshot* aggregates, unsigned int max_age_ms)
+{
+    if (!aggregates)
+    {
+        return IPC_ERROR;
+    }
+    return ReadSharedPage(GetSharedAggregates(), *aggregates, max_age_ms);
+}
+
+// Reads the per-CCX / per-CCD statistics of the latest snapshot together with
+// the layout they were computed on, so a fan controller can follow the hottest
+// CCD instead of the package average.
+extern "C" int rm_ipc_read_topology(RMTopologySnapshot* topology, unsigned int max_age_ms)
+{
+    if (!topology)
+    {
+        return IPC_ERROR;
+    }
+    return ReadSharedPage(GetSharedTopology(), *topology, max_age_ms);
+}
+
+// Reads the sampler's effective rate and SDK cost as of its last tick.
+extern "C" int rm_ipc_read_sampler(RMSamplerStatus* status, unsigned int max_age_ms)
+{
+    if (!status)
     {
         return IPC_ERROR;
     }
+    return ReadSharedPage(GetSharedSampler(), *status, max_age_ms);
+}
+
+// Reads the per-socket snapshots behind the latest combined snapshot. On a
+// single-socket machine socket_count is 1.
+extern "C" int rm_ipc_read_sockets(RMSocketSnapshots* sockets, unsigned int max_age_ms)
+{
+    if (!sockets)
+    {
+        return IPC_ERROR;
+    }
+    return ReadSharedPage(GetSharedSockets(), *sockets, max_age_ms);
+}
+
+struct InventoryCache
+{
+    SRWLOCK lock = SRWLOCK_INIT;
+    RMPlatformInventory inventory = {};
+};
+
+// This process's copy, used first and when the shared page is unavailable.
+static InventoryCache g_inventory;
+
+// Finds a cached inventory taken with the same SDK and driver files. stamp 0
+// (no SDK path set) accepts any.
+static bool LoadPlatformInventory(RMPlatformInventory& inventory, uint64_t stamp)
+{
+    const auto matches = [stamp](const RMPlatformInventory& cached)
+    {
+        return cached.timestamp_ms && (!stamp || cached.sdk_stamp == stamp);
+    };
+
+    AcquireSRWLockShared(&g_inventory.lock);
+    inventory = g_inventory.inventory;
+    ReleaseSRWLockShared(&g_inventory.lock);
+    if (matches(inventory))
+    {
+        return true;
+    }
+    return ReadSharedPage(GetSharedInventory(), inventory, 0) == IPC_OK && matches(inventory);
+}
+
+// Writes this process's copy and the shared page. A zeroed inventory (zero
+// timestamp) makes every reader probe again.
+static void StorePlatformInventory(const RMPlatformInventory& inventory)
+{
+    AcquireSRWLockExclusive(&g_inventory.lock);
+    g_inventory.inventory = inventory;
+    RMSharedInventory* shared = GetSharedInventory();
+    if (shared)
+    {
+        LONG next = 0;
+        BeginPageWrite(shared, next) = inventory;
+        EndPageWrite(shared, next);
+    }
+    ReleaseSRWLockExclusive(&g_inventory.lock);
+}
+
+// Copies the platform inventory (see RMPlatformInventory). When nothing
+// matching is cached, the host checks are probed and cached; the SDK is never
+// loaded here, so the device fields appear once a process has initialized it.
+extern "C" int rm_platform_inventory(RMPlatformInventory* inventory)
+{
+    if (!inventory)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    const uint64_t stamp = PlatformStamp();
+    if (!LoadPlatformInventory(*inventory, stamp))
+    {
+        ProbeHostInventory(*inventory, stamp);
+        StorePlatformInventory(*inventory);
+    }
+    return RM_STATUS_OK;
+}
+
+// Drops the cached inventory here and in shared memory, for instance after the
+// driver was reinstalled from outside, so the next rm_monitor_init probes again.
+extern "C" void rm_platform_inventory_invalidate()
+{
+    StorePlatformInventory(RMPlatformInventory{});
+}
+
+// Reads one snapshot from the SDK, publishes it over IPC and returns the derived
+// values, so an SDK owner needs a single call per tick to serve every consumer.
+extern "C" int rm_monitor_sample(RMMonitorContext* ctx, double* temperatureC, double* powerW, double* usagePercent)
+{
+    if (!ctx || !temperatureC || !powerW || !usagePercent)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    RMCpuSnapshot& snapshot = ctx->snapshot;
+    snapshot = {};
+    int status = rm_monitor_read_snapshot(ctx, &snapshot);
+    if (status != RM_STATUS_OK)
+    {
+        return status;
+    }
+
+    PublishSnapshot(snapshot, ctx->sockets.get());
+    *temperatureC = snapshot.temperature_c;
+    *powerW = snapshot.power_w;
+    *usagePercent = snapshot.usage_percent;
+    return RM_STATUS_OK;
+}
+
+namespace {
 
+int ReadLegacySample(RMIpcSample& out)
+{
     RMSharedTelemetry* shared = GetSharedTelemetry();
     if (!shared)
     {
@@ -745,46 +2215,190 @@ extern "C" int rm_ipc_read(
         LONG seq1 = AtomicRead(&shared->seq);
         if (seq1 & 1)
         {
+            CountEvent(&RMStats::torn_read_retries);
             continue;
         }
 
         snapshot = *shared;
-        MemoryBarrier();
+        SeqlockReadFence();
         LONG seq2 = AtomicRead(&shared->seq);
         if (seq1 == seq2 && !(seq2 & 1))
         {
-            break;
+            break;
+        }
+        CountEvent(&RMStats::torn_read_retries);
+        if (attempt == 2)
+        {
+            CountEvent(&RMStats::torn_read_failures);
+            return IPC_NOT_READY;
+        }
+    }
+
+    out = {};
+    out.timestamp_ms = snapshot.timestamp_ms;
+    out.status = static_cast<int32_t>(snapshot.status);
+    out.temperature_c = snapshot.temperature_c;
+    out.power_w = snapshot.power_w;
+    out.usage_percent = snapshot.usage_percent;
+    return IPC_OK;
+}
+
+// Reads the newest sample from the v3 ring, falling back to the legacy mapping
+// when the writer predates the ring.
+int ReadLatestSample(RMIpcSample& out)
+{
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    if (ring && IsRingCompatible(ring) && ReadRingLatest(ring, out, GetStatsPage()->stats))
+    {
+        return IPC_OK;
+    }
+
+    return ReadLegacySample(out);
+}
+
+} // namespace
+
+extern "C" int rm_ipc_read(
+    double* temperatureC,
+    double* powerW,
+    double* usagePercent,
+    int* status,
+    unsigned int max_age_ms)
+{
+    if (!temperatureC || !powerW || !usagePercent)
+    {
+        return IPC_ERROR;
+    }
+
+    RMIpcSample sample{};
+    int result = ReadLatestSample(sample);
+    if (result != IPC_OK)
+    {
+        return result;
+    }
+
+    if (sample.timestamp_ms == 0)
+    {
+        return IPC_NOT_READY;
+    }
+
+    if (max_age_ms > 0)
+    {
+        ULONGLONG now = GetTickCount64();
+        if (now >= sample.timestamp_ms &&
+            now - sample.timestamp_ms > static_cast<ULONGLONG>(max_age_ms))
+        {
+            CountEvent(&RMStats::stale_reads);
+            return IPC_STALE;
+        }
+    }
+
+    *temperatureC = sample.temperature_c;
+    *powerW = sample.power_w;
+    *usagePercent = sample.usage_percent;
+    if (status)
+    {
+        *status = static_cast<int>(sample.status);
+    }
+
+    return IPC_OK;
+}
+
+// Copies every retained sample with cursor >= `cursor` into `samples`, oldest
+// first. `next_cursor` receives the cursor to pass on the next call; samples the
+// writer recycled before they could be copied are counted in `dropped`.
+extern "C" int rm_ipc_read_since(
+    unsigned long long cursor,
+    RMIpcSample* samples,
+    unsigned int capacity,
+    unsigned int* count,
+    unsigned long long* next_cursor,
+    unsigned long long* dropped)
+{
+    if (!samples || !count || !next_cursor)
+    {
+        return IPC_ERROR;
+    }
+
+    *count = 0;
+    *next_cursor = cursor;
+    if (dropped)
+    {
+        *dropped = 0;
+    }
+
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    if (!ring || !IsRingCompatible(ring))
+    {
+        return IPC_NOT_READY;
+    }
+
+    uint64_t end = static_cast<uint64_t>(AtomicRead64(&ring->write_cursor));
+    if (end == 0)
+    {
+        return IPC_NOT_READY;
+    }
+    if (cursor > end)
+    {
+        // Writer restarted with a fresh mapping; resynchronise to what is retained.
+        cursor = 0;
+    }
+
+    uint64_t begin = cursor;
+    if (end - begin > kIpcRingCapacity)
+    {
+        begin = end - kIpcRingCapacity;
+    }
+    uint64_t lost = begin - cursor;
+
+    RMStats& stats = GetStatsPage()->stats;
+    unsigned int copied = 0;
+    uint64_t pos = begin;
+    for (; pos < end && copied < capacity; ++pos)
+    {
+        if (ReadRingSlot(ring, pos, samples[copied], stats))
+        {
+            ++copied;
         }
-        if (attempt == 2)
+        else
         {
-            return IPC_NOT_READY;
+            ++lost;
         }
     }
 
-    if (snapshot.timestamp_ms == 0)
+    *count = copied;
+    *next_cursor = pos;
+    if (dropped)
     {
-        return IPC_NOT_READY;
+        *dropped = lost;
     }
+    return IPC_OK;
+}
 
-    if (max_age_ms > 0)
+// Blocks until the write cursor moves past `seq` or `timeout_ms` elapses
+// (INFINITE waits forever). `current` receives the write cursor observed on
+// return, which is the value to pass on the next call.
+extern "C" int rm_ipc_wait(unsigned long long seq, unsigned int timeout_ms, unsigned long long* current)
+{
+    RMSharedTelemetryV3* ring = GetSharedRing();
+    if (!ring || !IsRingCompatible(ring))
     {
-        ULONGLONG now = GetTickCount64();
-        if (now >= snapshot.timestamp_ms &&
-            now - snapshot.timestamp_ms > static_cast<ULONGLONG>(max_age_ms))
-        {
-            return IPC_STALE;
-        }
+        return IPC_NOT_READY;
     }
 
-    *temperatureC = snapshot.temperature_c;
-    *powerW = snapshot.power_w;
-    *usagePercent = snapshot.usage_percent;
-    if (status)
+    const RingWake* wake = GetSharedRingWake();
+    if (!wake)
     {
-        *status = static_cast<int>(snapshot.status);
+        return IPC_ERROR;
     }
 
-    return IPC_OK;
+    uint64_t cursor = 0;
+    const int result = WaitRing(ring, *wake, seq, timeout_ms, cursor, nullptr);
+    if (current && result != IPC_ERROR)
+    {
+        *current = cursor;
+    }
+    return result;
 }
 
 extern "C" int rm_ipc_service_start()
@@ -839,15 +2453,26 @@ extern "C" int rm_ipc_owner_try_acquire()
     {
         return 0;
     }
+    const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
 
     DWORD wait = WaitForSingleObject(mutex, 0);
     if (wait == WAIT_OBJECT_0 || wait == WAIT_ABANDONED)
     {
         g_ipc_owner_mutex = mutex;
         g_ipc_owner_held = true;
+        CountEvent(&RMStats::owner_acquisitions);
+        if (existed)
+        {
+            CountEvent(&RMStats::owner_handoffs);
+        }
+        if (wait == WAIT_ABANDONED)
+        {
+            CountEvent(&RMStats::owner_abandoned);
+        }
         return 1;
     }
 
+    CountEvent(&RMStats::owner_contended);
     CloseHandle(mutex);
     return 0;
 }
@@ -859,9 +2484,636 @@ extern "C" void rm_ipc_owner_release()
         if (g_ipc_owner_held)
         {
             ReleaseMutex(g_ipc_owner_mutex);
+            CountEvent(&RMStats::owner_releases);
         }
         CloseHandle(g_ipc_owner_mutex);
         g_ipc_owner_mutex = nullptr;
         g_ipc_owner_held = false;
     }
 }
+
+namespace {
+
+// Non-atomic histogram update for histograms owned by one thread.
+void AddLatency(RMLatencyHistogram& histogram, uint64_t value)
+{
+    histogram.count++;
+    histogram.total_us += value;
+    histogram.max_us = std::max(histogram.max_us, value);
+    histogram.buckets[LatencyBucket(value)]++;
+}
+
+void MergeLatency(RMLatencyHistogram& into, const RMLatencyHistogram& from)
+{
+    into.count += from.count;
+    into.failures += from.failures;
+    into.total_us += from.total_us;
+    into.max_us = std::max(into.max_us, from.max_us);
+    for (uint32_t bucket = 0; bucket < RM_LATENCY_BUCKETS; ++bucket)
+    {
+        into.buckets[bucket] += from.buckets[bucket];
+    }
+}
+
+// The waiters keep waiting this long after the last publish, so a wake left
+// behind by the run would show up as spurious wakeups.
+constexpr DWORD kBenchWaitIdleMs = 50;
+
+struct BenchShared
+{
+    RMSharedTelemetryV3* ring = nullptr;
+    RingWake wake;
+    HANDLE start_event = nullptr;
+    volatile LONG stop = 0;
+    volatile LONG stop_waiters = 0;
+};
+
+struct BenchReader
+{
+    BenchShared* shared = nullptr;
+    HANDLE thread = nullptr;
+    uint64_t reads = 0;
+    uint64_t failed_reads = 0;
+    RMStats stats = {};
+    RMLatencyHistogram read_ns = {};
+};
+
+DWORD WINAPI BenchReaderProc(LPVOID param)
+{
+    BenchReader& reader = *static_cast<BenchReader*>(param);
+    WaitForSingleObject(reader.shared->start_event, INFINITE);
+
+    RMIpcSample sample{};
+    // A plain volatile load: an interlocked read of the flag would add a
+    // contended line the real readers do not have.
+    while (reader.shared->stop == 0)
+    {
+        LONGLONG start = QpcNow();
+        bool read = ReadRingLatest(reader.shared->ring, sample, reader.stats);
+        AddLatency(reader.read_ns, QpcToNanoseconds(QpcNow() - start));
+        reader.reads++;
+        if (!read)
+        {
+            reader.failed_reads++;
+        }
+    }
+    return 0;
+}
+
+struct BenchWaiter
+{
+    BenchShared* shared = nullptr;
+    HANDLE thread = nullptr;
+    unsigned int timeout_ms = 0;
+    uint64_t waits = 0;
+    uint64_t timeouts = 0;
+    uint64_t spurious = 0;
+};
+
+DWORD WINAPI BenchWaiterProc(LPVOID param)
+{
+    BenchWaiter& waiter = *static_cast<BenchWaiter*>(param);
+    WaitForSingleObject(waiter.shared->start_event, INFINITE);
+
+    uint64_t cursor = static_cast<uint64_t>(AtomicRead64(&waiter.shared->ring->write_cursor));
+    while (waiter.shared->stop_waiters == 0)
+    {
+        const int result = WaitRing(waiter.shared->ring, waiter.shared->wake, cursor, waiter.timeout_ms, cursor,
+            &waiter.spurious);
+        if (result == IPC_OK)
+        {
+            waiter.waits++;
+        }
+        else if (result == IPC_TIMEOUT)
+        {
+            waiter.timeouts++;
+        }
+        else
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+template <typename Worker>
+void StopBenchThreads(BenchShared& shared, volatile LONG& stop, Worker* workers, uint32_t count)
+{
+    InterlockedExchange(&stop, 1);
+    SetEvent(shared.start_event);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (workers[i].thread)
+        {
+            WaitForSingleObject(workers[i].thread, INFINITE);
+            CloseHandle(workers[i].thread);
+            workers[i].thread = nullptr;
+        }
+    }
+}
+
+} // namespace
+
+// Measures the sample publish/read path: the calling thread publishes into a
+// private ring laid out like the shared one while reader threads read the
+// newest sample through the same code as rm_ipc_read, and waiter threads block
+// through the same code as rm_ipc_wait on private events. Nothing is published
+// to the real mappings.
+extern "C" int rm_ipc_bench(const RMIpcBenchConfig* config, RMIpcBenchStats* stats)
+{
+    if (!config || !stats || config->reader_threads == 0 || config->reader_threads > RM_IPC_BENCH_MAX_READERS ||
+        config->waiter_threads > RM_IPC_BENCH_MAX_READERS || config->duration_ms == 0)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    std::unique_ptr<RMSharedTelemetryV3> ring(new (std::nothrow) RMSharedTelemetryV3());
+    std::unique_ptr<BenchReader[]> readers(new (std::nothrow) BenchReader[config->reader_threads]);
+    std::unique_ptr<BenchWaiter[]> waiters(new (std::nothrow) BenchWaiter[config->waiter_threads]);
+    if (!ring || !readers || !waiters)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+    ring->version = kIpcRingVersion;
+    ring->size = sizeof(RMSharedTelemetryV3);
+    ring->capacity = kIpcRingCapacity;
+    ring->slot_size = sizeof(RMSharedSlot);
+
+    BenchShared shared;
+    shared.ring = ring.get();
+    shared.start_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!shared.start_event || !CreateRingWake(shared.wake, false))
+    {
+        if (shared.start_event)
+        {
+            CloseHandle(shared.start_event);
+        }
+        CloseRingWake(shared.wake);
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    const uint32_t reader_count = config->reader_threads;
+    const uint32_t waiter_count = config->waiter_threads;
+    uint32_t started_readers = 0;
+    uint32_t started_waiters = 0;
+    for (; started_readers < reader_count; ++started_readers)
+    {
+        BenchReader& reader = readers[started_readers];
+        reader.shared = &shared;
+        reader.thread = CreateThread(nullptr, 0, BenchReaderProc, &reader, 0, nullptr);
+        if (!reader.thread)
+        {
+            break;
+        }
+    }
+    for (; started_readers == reader_count && started_waiters < waiter_count; ++started_waiters)
+    {
+        BenchWaiter& waiter = waiters[started_waiters];
+        waiter.shared = &shared;
+        waiter.timeout_ms = started_waiters % 4;
+        waiter.thread = CreateThread(nullptr, 0, BenchWaiterProc, &waiter, 0, nullptr);
+        if (!waiter.thread)
+        {
+            break;
+        }
+    }
+    if (started_readers < reader_count || started_waiters < waiter_count)
+    {
+        StopBenchThreads(shared, shared.stop, readers.get(), started_readers);
+        StopBenchThreads(shared, shared.stop_waiters, waiters.get(), started_waiters);
+        CloseHandle(shared.start_event);
+        CloseRingWake(shared.wake);
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    *stats = {};
+    const LONGLONG interval = config->publish_rate_hz ? std::max<LONGLONG>(QpcFrequency() / config->publish_rate_hz, 1) : 0;
+    const LONGLONG spin_window = MicrosecondsToQpc(50);
+    // Readers never see an empty ring; a failed read is one the writer kept
+    // overwriting.
+    RMIpcSample sample{};
+    sample.timestamp_ms = GetTickCount64();
+    PublishAndWake(ring.get(), shared.wake, sample);
+    SetEvent(shared.start_event);
+    const LONGLONG begin = QpcNow();
+    const LONGLONG end = begin + MicrosecondsToQpc(static_cast<uint64_t>(config->duration_ms) * 1000);
+    LONGLONG next = begin;
+    for (;;)
+    {
+        LONGLONG now = QpcNow();
+        if (now >= end)
+        {
+            break;
+        }
+        if (interval)
+        {
+            if (now < next)
+            {
+                if (next - now > spin_window)
+                {
+                    SwitchToThread();
+                }
+                else
+                {
+                    YieldProcessor();
+                }
+                continue;
+            }
+            // Publishes the writer fell behind on are dropped, not bunched.
+            next = std::max(next + interval, now);
+        }
+
+        sample.timestamp_ms = GetTickCount64();
+        sample.temperature_c = static_cast<double>(stats->publishes);
+        LONGLONG start = QpcNow();
+        PublishAndWake(ring.get(), shared.wake, sample);
+        AddLatency(stats->publish_ns, QpcToNanoseconds(QpcNow() - start));
+        stats->publishes++;
+    }
+    StopBenchThreads(shared, shared.stop, readers.get(), reader_count);
+    stats->elapsed_us = QpcToMicroseconds(QpcNow() - begin);
+    if (waiter_count)
+    {
+        Sleep(kBenchWaitIdleMs);
+    }
+    StopBenchThreads(shared, shared.stop_waiters, waiters.get(), waiter_count);
+    CloseHandle(shared.start_event);
+    CloseRingWake(shared.wake);
+
+    for (uint32_t i = 0; i < reader_count; ++i)
+    {
+        const BenchReader& reader = readers[i];
+        stats->reads += reader.reads;
+        stats->failed_reads += reader.failed_reads;
+        stats->torn_retries += reader.stats.torn_read_retries;
+        stats->torn_failures += reader.stats.torn_read_failures;
+        MergeLatency(stats->read_ns, reader.read_ns);
+    }
+    for (uint32_t i = 0; i < waiter_count; ++i)
+    {
+        const BenchWaiter& waiter = waiters[i];
+        stats->waits += waiter.waits;
+        stats->wait_timeouts += waiter.timeouts;
+        stats->spurious_wakeups += waiter.spurious;
+    }
+    const LONG left = AtomicRead(&ring->waiters);
+    stats->leaked_waiters = static_cast<uint64_t>(left < 0 ? -left : left);
+    const double seconds = std::max<double>(static_cast<double>(stats->elapsed_us), 1.0) / 1000000.0;
+    stats->publishes_per_s = static_cast<double>(stats->publishes) / seconds;
+    stats->reads_per_s = static_cast<double>(stats->reads) / seconds;
+    return RM_STATUS_OK;
+}
+
+namespace {
+
+// Slopes are taken between samples at least this far apart, so the jitter of
+// back-to-back fast ticks does not read as a trend.
+constexpr uint64_t kSlopeWindowUs = 250000;
+// Weight of the newest read in the SDK cost average.
+constexpr double kReadCostAlpha = 0.125;
+
+constexpr RMSamplerPolicy kDefaultSamplerPolicy = {
+    50000,      // min_period_us
+    3000000,    // max_period_us
+    2.0,        // fast_temp_c_per_s
+    15.0,       // fast_power_w_per_s
+    0.5,        // flat_temp_c_per_s
+    3.0,        // flat_power_w_per_s
+    1.25,       // backoff_factor
+    0.10        // max_sdk_duty: min_period_us holds for reads up to 5 ms
+};
+
+// Period selection. Only the sampler thread touches it.
+struct RateController
+{
+    RMSamplerPolicy policy = {};
+    bool adaptive = false;
+    double period_us = 0.0;
+    double avg_read_us = 0.0;
+    bool has_reference = false;
+    LONGLONG reference_time = 0;
+    double reference_temp = 0.0;
+    double reference_power = 0.0;
+    double temp_slope = 0.0;
+    double power_slope = 0.0;
+};
+
+struct SamplerState
+{
+    HANDLE thread = nullptr;
+    HANDLE stop_event = nullptr;
+    RMMonitorContext* ctx = nullptr;
+    RMSamplerPolicy policy = {};
+    bool adaptive = false;
+    SRWLOCK stats_lock = SRWLOCK_INIT;
+    RMSamplerStats stats = {};
+};
+
+static SamplerState g_sampler;
+
+HANDLE CreateSamplerTimer()
+{
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer)
+    {
+        // High-resolution timers need Windows 10 1803 or later.
+        timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    return timer;
+}
+
+// Arms the timer for an absolute QPC deadline. The due time is converted to a
+// relative interval at arm time so wall-clock adjustments cannot shift the grid.
+bool ArmSamplerTimer(HANDLE timer, LONGLONG deadline)
+{
+    const uint64_t due_100ns = QpcTo100ns(deadline - QpcNow());
+    LARGE_INTEGER due{};
+    due.QuadPart = -std::max<LONGLONG>(static_cast<LONGLONG>(due_100ns), 1);
+    return SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE) != FALSE;
+}
+
+struct TickOutcome
+{
+    bool speedup;
+    bool clamped;
+};
+
+// Picks the period until the next tick from the sample just taken (null when
+// the read failed) and the cost of taking it.
+TickOutcome UpdateSamplerRate(RateController& rate, const RMCpuSnapshot* snapshot, LONGLONG sample_time, uint64_t read_us)
+{
+    TickOutcome outcome = {};
+    rate.avg_read_us = rate.avg_read_us > 0.0
+        ? rate.avg_read_us + kReadCostAlpha * (static_cast<double>(read_us) - rate.avg_read_us)
+        : static_cast<double>(read_us);
+    if (!rate.adaptive)
+    {
+        return outcome;
+    }
+
+    const RMSamplerPolicy& policy = rate.policy;
+    if (snapshot && std::isfinite(snapshot->temperature_c) && std::isfinite(snapshot->power_w))
+    {
+        const uint64_t elapsed_us = rate.has_reference ? QpcToMicroseconds(sample_time - rate.reference_time) : 0;
+        if (rate.has_reference && elapsed_us >= kSlopeWindowUs)
+        {
+            const double elapsed_s = static_cast<double>(elapsed_us) / 1000000.0;
+            rate.temp_slope = (snapshot->temperature_c - rate.reference_temp) / elapsed_s;
+            rate.power_slope = (snapshot->power_w - rate.reference_power) / elapsed_s;
+            const double temp_rate = std::fabs(rate.temp_slope);
+            const double power_rate = std::fabs(rate.power_slope);
+            if (temp_rate >= policy.fast_temp_c_per_s || power_rate >= policy.fast_power_w_per_s)
+            {
+                outcome.speedup = rate.period_us > policy.min_period_us;
+                rate.period_us = policy.min_period_us;
+            }
+            else if (temp_rate < policy.flat_temp_c_per_s && power_rate < policy.flat_power_w_per_s)
+            {
+                rate.period_us = std::min(rate.period_us * policy.backoff_factor, static_cast<double>(policy.max_period_us));
+            }
+        }
+        if (!rate.has_reference || elapsed_us >= kSlopeWindowUs)
+        {
+            rate.has_reference = true;
+            rate.reference_time = sample_time;
+            rate.reference_temp = snapshot->temperature_c;
+            rate.reference_power = snapshot->power_w;
+        }
+    }
+
+    // The budget wins over max_period_us: a slow SDK is sampled less often
+    // rather than allowed to take more than its share.
+    const double floor_us = rate.avg_read_us / policy.max_sdk_duty;
+    if (rate.period_us < floor_us)
+    {
+        rate.period_us = floor_us;
+        outcome.clamped = true;
+    }
+    return outcome;
+}
+
+uint32_t CurrentPeriodUs(const RateController& rate)
+{
+    return static_cast<uint32_t>(std::clamp(rate.period_us, 1.0, static_cast<double>(UINT32_MAX)));
+}
+
+void RecordSamplerTick(LONGLONG lateness, LONGLONG read_ticks, LONGLONG missed, int status,
+    const RateController& rate, const TickOutcome& outcome, RMSamplerStats& copy)
+{
+    uint64_t lateness_us = QpcToMicroseconds(lateness);
+    uint64_t read_us = QpcToMicroseconds(read_ticks);
+
+    AcquireSRWLockExclusive(&g_sampler.stats_lock);
+    RMSamplerStats& stats = g_sampler.stats;
+    stats.ticks++;
+    if (status != RM_STATUS_OK)
+    {
+        stats.read_failures++;
+    }
+    stats.missed_ticks += static_cast<uint64_t>(missed);
+    stats.last_lateness_us = lateness_us;
+    stats.max_lateness_us = std::max(stats.max_lateness_us, lateness_us);
+    stats.total_lateness_us += lateness_us;
+    stats.last_read_us = read_us;
+    stats.max_read_us = std::max(stats.max_read_us, read_us);
+    stats.last_status = status;
+    stats.current_period_us = CurrentPeriodUs(rate);
+    stats.avg_read_us = static_cast<uint64_t>(rate.avg_read_us);
+    stats.speedups += outcome.speedup ? 1 : 0;
+    stats.budget_clamps += outcome.clamped ? 1 : 0;
+    copy = stats;
+    ReleaseSRWLockExclusive(&g_sampler.stats_lock);
+}
+
+// Only the sampler thread publishes this page.
+void PublishSamplerStatus(const RateController& rate, const RMSamplerStats& stats)
+{
+    RMSharedSampler* shared = GetSharedSampler();
+    if (!shared)
+    {
+        return;
+    }
+
+    LONG next = 0;
+    RMSamplerStatus& target = BeginPageWrite(shared, next);
+    target.timestamp_ms = GetTickCount64();
+    target.ticks = stats.ticks;
+    target.period_us = stats.current_period_us;
+    target.adaptive = rate.adaptive ? 1 : 0;
+    target.rate_hz = 1000000.0 / stats.current_period_us;
+    target.last_read_us = stats.last_read_us;
+    target.avg_read_us = stats.avg_read_us;
+    target.max_read_us = stats.max_read_us;
+    target.sdk_duty = rate.avg_read_us / stats.current_period_us;
+    target.temp_c_per_s = rate.temp_slope;
+    target.power_w_per_s = rate.power_slope;
+    EndPageWrite(shared, next);
+}
+
+DWORD WINAPI SamplerThreadProc(LPVOID)
+{
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    HANDLE timer = CreateSamplerTimer();
+    if (!timer)
+    {
+        return 1;
+    }
+
+    RMMonitorContext* ctx = g_sampler.ctx;
+    RateController rate;
+    rate.policy = g_sampler.policy;
+    rate.adaptive = g_sampler.adaptive;
+    rate.period_us = rate.policy.min_period_us;
+    const HANDLE handles[2] = { g_sampler.stop_event, timer };
+    LONGLONG deadline = QpcNow();
+
+    for (;;)
+    {
+        const LONGLONG scheduled = deadline;
+        LONGLONG start = QpcNow();
+        int status = rm_monitor_read_snapshot(ctx, &ctx->snapshot);
+        LONGLONG read_end = QpcNow();
+        if (status == RM_STATUS_OK)
+        {
+            PublishSnapshot(ctx->snapshot, ctx->sockets.get());
+        }
+        else
+        {
+            rm_ipc_publish(0.0, 0.0, 0.0, status);
+        }
+
+        const TickOutcome outcome = UpdateSamplerRate(rate, status == RM_STATUS_OK ? &ctx->snapshot : nullptr,
+            start, QpcToMicroseconds(read_end - start));
+        const LONGLONG period = std::max<LONGLONG>(MicrosecondsToQpc(CurrentPeriodUs(rate)), 1);
+
+        // Stay on the grid; ticks that are already in the past are skipped
+        // rather than fired back to back.
+        deadline = scheduled + period;
+        LONGLONG missed = 0;
+        LONGLONG now = QpcNow();
+        if (now >= deadline)
+        {
+            missed = (now - deadline) / period + 1;
+            deadline += missed * period;
+        }
+        RMSamplerStats stats = {};
+        RecordSamplerTick(start - scheduled, read_end - start, missed, status, rate, outcome, stats);
+        PublishSamplerStatus(rate, stats);
+
+        if (!ArmSamplerTimer(timer, deadline))
+        {
+            break;
+        }
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+        {
+            break;
+        }
+    }
+
+    CloseHandle(timer);
+    return 0;
+}
+
+bool IsValidPolicy(const RMSamplerPolicy& policy)
+{
+    return policy.min_period_us > 0 &&
+           policy.max_period_us >= policy.min_period_us &&
+           policy.fast_temp_c_per_s >= 0.0 &&
+           policy.fast_power_w_per_s >= 0.0 &&
+           policy.flat_temp_c_per_s >= 0.0 &&
+           policy.flat_power_w_per_s >= 0.0 &&
+           policy.backoff_factor >= 1.0 &&
+           policy.max_sdk_duty > 0.0 && policy.max_sdk_duty <= 1.0;
+}
+
+int StartSampler(RMMonitorContext* ctx, const RMSamplerPolicy& policy, bool adaptive)
+{
+    if (!ctx || !IsValidPolicy(policy) || g_sampler.thread)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    g_sampler.stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!g_sampler.stop_event)
+    {
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    g_sampler.ctx = ctx;
+    g_sampler.policy = policy;
+    g_sampler.adaptive = adaptive;
+    AcquireSRWLockExclusive(&g_sampler.stats_lock);
+    g_sampler.stats = {};
+    g_sampler.stats.period_us = policy.min_period_us;
+    g_sampler.stats.current_period_us = policy.min_period_us;
+    ReleaseSRWLockExclusive(&g_sampler.stats_lock);
+
+    g_sampler.thread = CreateThread(nullptr, 0, SamplerThreadProc, nullptr, 0, nullptr);
+    if (!g_sampler.thread)
+    {
+        CloseHandle(g_sampler.stop_event);
+        g_sampler.stop_event = nullptr;
+        g_sampler.ctx = nullptr;
+        return RM_STATUS_ALLOC_FAILED;
+    }
+
+    return RM_STATUS_OK;
+}
+
+} // namespace
+
+// Starts a thread that samples `ctx` every `period_us` microseconds against
+// absolute deadlines and publishes each snapshot over IPC. While it runs, the
+// caller must not read from `ctx` itself.
+extern "C" int rm_sampler_start(RMMonitorContext* ctx, unsigned int period_us)
+{
+    RMSamplerPolicy policy = kDefaultSamplerPolicy;
+    policy.min_period_us = period_us;
+    policy.max_period_us = period_us;
+    return StartSampler(ctx, policy, false);
+}
+
+// Same, with the period chosen per tick by `policy` (see RMSamplerPolicy);
+// null selects the defaults: 50 ms to 3 s, 10% SDK budget.
+extern "C" int rm_sampler_start_adaptive(RMMonitorContext* ctx, const RMSamplerPolicy* policy)
+{
+    return StartSampler(ctx, policy ? *policy : kDefaultSamplerPolicy, true);
+}
+
+extern "C" void rm_sampler_stop()
+{
+    if (!g_sampler.thread)
+    {
+        return;
+    }
+
+    SetEvent(g_sampler.stop_event);
+    WaitForSingleObject(g_sampler.thread, INFINITE);
+    CloseHandle(g_sampler.thread);
+    CloseHandle(g_sampler.stop_event);
+    g_sampler.thread = nullptr;
+    g_sampler.stop_event = nullptr;
+    g_sampler.ctx = nullptr;
+}
+
+extern "C" int rm_sampler_stats(RMSamplerStats* stats)
+{
+    if (!stats)
+    {
+        return RM_STATUS_INVALID_ARG;
+    }
+
+    AcquireSRWLockShared(&g_sampler.stats_lock);
+    *stats = g_sampler.stats;
+    ReleaseSRWLockShared(&g_sampler.stats_lock);
+    return RM_STATUS_OK;
+}
+
+static void StopSamplerForContext(RMMonitorContext* ctx)
+{
+    if (g_sampler.thread && g_sampler.ctx == ctx)
+    {
+        rm_sampler_stop();
+    }
+}
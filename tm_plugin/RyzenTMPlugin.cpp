@@ -1,21 +1,29 @@
-// TrafficMonitor plugin: Ryzen SDK telemetry (temperature, usage, power).
+// TrafficMonitor plugin: Ryzen SDK telemetry (temperature, usage, power, limits,
+// clocks and voltages), as text or as sparkline graphs.
 #include <windows.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <cwchar>
+#include <limits>
 #include <string>
 
 #include "PluginInterface.h"
+#include "Sparkline.hpp"
+#include "Telemetry.hpp"
 
 struct RMMonitorContext;
 
 extern "C" {
 void rm_monitor_set_sdk_path(const wchar_t* path);
 int rm_monitor_init(RMMonitorContext** out_ctx);
-int rm_monitor_read(RMMonitorContext* ctx, double* temperatureC, double* powerW, double* usagePercent);
+int rm_monitor_sample(RMMonitorContext* ctx, double* temperatureC, double* powerW, double* usagePercent);
 void rm_monitor_shutdown(RMMonitorContext* ctx);
-int rm_ipc_publish(double temperatureC, double powerW, double usagePercent, int status);
 int rm_ipc_read(double* temperatureC, double* powerW, double* usagePercent, int* status, unsigned int max_age_ms);
+int rm_ipc_read_snapshot(RMCpuSnapshot* snapshot, unsigned int max_age_ms);
+int rm_ipc_read_topology(RMTopologySnapshot* topology, unsigned int max_age_ms);
 int rm_ipc_is_service_running();
 int rm_ipc_owner_try_acquire();
 void rm_ipc_owner_release();
@@ -28,21 +36,23 @@ constexpr int kIpcOk = 0;
 constexpr ULONGLONG kInitRetryMs = 10000;
 constexpr unsigned int kIpcMaxAgeMs = 4000;
 constexpr ULONGLONG kCacheGraceMs = 5000;
+constexpr DWORD kWorkerStopTimeoutMs = 2000;
+constexpr size_t kValueTextCapacity = 32;
+constexpr size_t kTooltipCapacity = 64;
+constexpr size_t kItemTextCapacity = 32;
+// Per-core items exposed; cores past the CPU's core count show N/A.
+constexpr uint32_t kCoreItemCount = 32;
+// Per-CCD load graphs exposed.
+constexpr uint32_t kCcdGraphCount = 4;
+// Graph width at 96 DPI, and the samples kept per graph (the widest it draws).
+constexpr int kGraphWidth = 40;
+constexpr uint32_t kGraphHistory = 256;
+// Larger readings are shown clamped; the text always fits kValueTextCapacity.
+constexpr int32_t kMaxShownValue = 999999;
 constexpr wchar_t kNotAvailableText[] = L"N/A";
 constexpr wchar_t kUnavailableTooltip[] = L"Ryzen SDK unavailable";
 constexpr wchar_t kWaitingForServiceTooltip[] = L"Waiting for service data";
 
-enum class ItemIndex {
-    Temp = 0,
-    Usage = 1,
-    Power = 2,
-    Count = 3,
-};
-
-size_t ToIndex(ItemIndex index) {
-    return static_cast<size_t>(index);
-}
-
 std::wstring JoinPath(const std::wstring& base, const wchar_t* suffix) {
     if (base.empty()) {
         return L"";
@@ -151,56 +161,386 @@ std::wstring ResolveSdkRoot() {
     return L"";
 }
 
-const wchar_t* ItemName(ItemIndex index) {
-    switch (index) {
-    case ItemIndex::Temp:
-        return L"Ryzen Temperature";
-    case ItemIndex::Usage:
-        return L"Ryzen Usage";
-    case ItemIndex::Power:
-        return L"Ryzen Power";
-    default:
-        return L"Ryzen Item";
+// "00" to "99", so formatting takes one division per two digits.
+constexpr std::array<wchar_t, 200> kDigitPairs = [] {
+    std::array<wchar_t, 200> pairs{};
+    for (int i = 0; i < 100; ++i) {
+        pairs[2 * i] = static_cast<wchar_t>(L'0' + i / 10);
+        pairs[2 * i + 1] = static_cast<wchar_t>(L'0' + i % 10);
+    }
+    return pairs;
+}();
+
+constexpr double kDecimalScale[] = { 1.0, 10.0, 100.0, 1000.0 };
+
+// Scales by 10^decimals, rounds half away from zero and clamps to
+// +-kMaxShownValue. False for NaN, which is shown as unavailable.
+constexpr bool RoundForDisplay(double value, uint32_t decimals, int32_t& rounded) {
+    if (value != value) {
+        return false;
+    }
+    value *= kDecimalScale[decimals];
+    if (value >= kMaxShownValue) {
+        rounded = kMaxShownValue;
+    } else if (value <= -kMaxShownValue) {
+        rounded = -kMaxShownValue;
+    } else {
+        rounded = value >= 0 ? static_cast<int32_t>(value + 0.5) : -static_cast<int32_t>(-value + 0.5);
+    }
+    return true;
+}
+
+// `value` with its last `decimals` digits after the point, then `suffix`;
+// truncated to fit and always terminated. Replaces swprintf_s on every refresh.
+template <size_t N>
+constexpr void FormatValue(std::array<wchar_t, N>& dst, int32_t value, uint32_t decimals, const wchar_t* suffix) {
+    // Least significant digit first.
+    wchar_t digits[10] = {};
+    uint32_t count = 0;
+    uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    while (magnitude >= 10) {
+        const uint32_t pair = magnitude % 100 * 2;
+        magnitude /= 100;
+        digits[count++] = kDigitPairs[pair + 1];
+        digits[count++] = kDigitPairs[pair];
+    }
+    if (magnitude != 0 || count == 0) {
+        digits[count++] = static_cast<wchar_t>(L'0' + magnitude);
+    }
+    while (count <= decimals) {
+        digits[count++] = L'0';
+    }
+
+    size_t length = 0;
+    const auto put = [&](wchar_t c) {
+        if (length + 1 < N) {
+            dst[length++] = c;
+        }
+    };
+    if (value < 0) {
+        put(L'-');
+    }
+    while (count > 0) {
+        put(digits[--count]);
+        if (count == decimals && decimals != 0) {
+            put(L'.');
+        }
+    }
+    while (*suffix) {
+        put(*suffix++);
+    }
+    dst[length] = L'\0';
+}
+
+template <size_t N>
+constexpr bool TextIs(const std::array<wchar_t, N>& text, const wchar_t* expected) {
+    for (size_t i = 0; i < N; ++i) {
+        if (text[i] != expected[i]) {
+            return false;
+        }
+        if (expected[i] == L'\0') {
+            return true;
+        }
     }
+    return false;
+}
+
+constexpr bool FormatsAs(int32_t value, uint32_t decimals, const wchar_t* suffix, const wchar_t* expected) {
+    std::array<wchar_t, kValueTextCapacity> text{};
+    FormatValue(text, value, decimals, suffix);
+    return TextIs(text, expected);
+}
+
+constexpr int32_t RoundsTo(double value, uint32_t decimals = 0) {
+    int32_t rounded = 0;
+    return RoundForDisplay(value, decimals, rounded) ? rounded : INT32_MIN;
 }
 
-const wchar_t* ItemId(ItemIndex index) {
-    switch (index) {
-    case ItemIndex::Temp:
-        return L"RyzenTemp";
-    case ItemIndex::Usage:
-        return L"RyzenUsage";
-    case ItemIndex::Power:
-        return L"RyzenPower";
-    default:
-        return L"RyzenItem";
+static_assert(FormatsAs(0, 0, L" W", L"0 W"));
+static_assert(FormatsAs(7, 0, L" %", L"7 %"));
+static_assert(FormatsAs(55, 0, L" \u2103", L"55 \u2103"));
+static_assert(FormatsAs(100, 0, L" %", L"100 %"));
+static_assert(FormatsAs(-40, 0, L" \u2103", L"-40 \u2103"));
+static_assert(FormatsAs(1000000, 0, L"", L"1000000"));
+static_assert(FormatsAs(INT32_MIN, 0, L"", L"-2147483648"));
+static_assert(FormatsAs(1100, 3, L" V", L"1.100 V"));
+static_assert(FormatsAs(-50, 3, L" V", L"-0.050 V"));
+static_assert(FormatsAs(0, 2, L"", L"0.00"));
+static_assert(RoundsTo(55.4) == 55 && RoundsTo(55.5) == 56 && RoundsTo(-0.4) == 0 && RoundsTo(-2.5) == -3);
+static_assert(RoundsTo(1e12) == kMaxShownValue && RoundsTo(-1e12) == -kMaxShownValue);
+static_assert(RoundsTo(1.1004, 3) == 1100 && RoundsTo(0.0496, 3) == 50);
+
+// Everything the items show, read once per refresh: the service's (or our
+// own) latest published snapshot and the per-CCD statistics published with
+// it. Without the full snapshot only the three basic values are filled in.
+struct PluginSample {
+    RMCpuSnapshot snapshot;
+    RMTopologySnapshot topology;
+    bool has_snapshot;
+    bool has_topology;
+};
+
+// Reads an item's value from the sample; NaN shows N/A.
+using MetricValueFn = double (*)(const PluginSample& sample, uint32_t core);
+
+constexpr double kNoValue = std::numeric_limits<double>::quiet_NaN();
+
+constexpr double Detail(const PluginSample& sample, double value) {
+    return sample.has_snapshot ? value : kNoValue;
+}
+
+constexpr double PercentOfLimit(const PluginSample& sample, float value, float limit) {
+    return Detail(sample, limit > 0.0f ? 100.0 * value / limit : kNoValue);
+}
+
+constexpr double Headroom(const PluginSample& sample, float value, float limit) {
+    return Detail(sample, limit > 0.0f ? static_cast<double>(limit) - value : kNoValue);
+}
+
+// Effective clock of one core, falling back to the current frequency when the
+// source publishes only that.
+constexpr double CoreClock(const PluginSample& sample, uint32_t core) {
+    const RMCpuSnapshot& snapshot = sample.snapshot;
+    if (!sample.has_snapshot || core >= snapshot.core_count || core >= RM_MAX_CORES) {
+        return kNoValue;
+    }
+    if (snapshot.core_fields & RM_CORE_FIELD_FREQ) {
+        return snapshot.core_freq_mhz[core];
+    }
+    return snapshot.core_fields & RM_CORE_FIELD_CURRENT_FREQ ? snapshot.core_current_freq_mhz[core] : kNoValue;
+}
+
+double HottestCcdTemperature(const PluginSample& sample, uint32_t) {
+    const RMTopologySnapshot& topology = sample.topology;
+    if (!sample.has_topology || topology.hottest_ccd >= topology.topology.ccd_count ||
+        topology.hottest_ccd >= RM_MAX_DOMAINS) {
+        return kNoValue;
+    }
+    return topology.ccd[topology.hottest_ccd].temp_max_c;
+}
+
+double CcdLoad(const PluginSample& sample, uint32_t ccd) {
+    const RMTopologySnapshot& topology = sample.topology;
+    if (!sample.has_topology || ccd >= topology.topology.ccd_count || ccd >= RM_MAX_DOMAINS) {
+        return kNoValue;
+    }
+    return topology.ccd[ccd].usage_percent;
+}
+
+// One scalar item. id is what TrafficMonitor stores in its settings, so
+// existing ids must not change. A graph item draws the value over
+// [graph_min, graph_max] instead of printing it.
+struct MetricDef {
+    const wchar_t* name;
+    const wchar_t* id;
+    const wchar_t* label;
+    const wchar_t* sample;
+    const wchar_t* suffix;
+    uint32_t decimals;
+    MetricValueFn value;
+    bool graph = false;
+    double graph_min = 0.0;
+    double graph_max = 0.0;
+};
+
+constexpr MetricDef kMetrics[] = {
+    { L"Ryzen Temperature", L"RyzenTemp", L"Temp", L"100 \u2103", L" \u2103", 0,
+      [](const PluginSample& s, uint32_t) { return s.snapshot.temperature_c; } },
+    { L"Ryzen Usage", L"RyzenUsage", L"Usage", L"100 %", L" %", 0,
+      [](const PluginSample& s, uint32_t) { return s.snapshot.usage_percent; } },
+    { L"Ryzen Power", L"RyzenPower", L"Power", L"200 W", L" W", 0,
+      [](const PluginSample& s, uint32_t) { return s.snapshot.power_w; } },
+    { L"Ryzen Hottest CCD", L"RyzenHottestCcd", L"CCD", L"100 \u2103", L" \u2103", 0, HottestCcdTemperature },
+    { L"Ryzen PPT Load", L"RyzenPptPercent", L"PPT", L"100 %", L" %", 0,
+      [](const PluginSample& s, uint32_t) { return PercentOfLimit(s, s.snapshot.ppt_value_w, s.snapshot.ppt_limit_w); } },
+    { L"Ryzen TDC Headroom", L"RyzenTdcHeadroom", L"TDC left", L"200 A", L" A", 0,
+      [](const PluginSample& s, uint32_t) { return Headroom(s, s.snapshot.tdc_value_vdd_a, s.snapshot.tdc_limit_vdd_a); } },
+    { L"Ryzen EDC Headroom", L"RyzenEdcHeadroom", L"EDC left", L"200 A", L" A", 0,
+      [](const PluginSample& s, uint32_t) { return Headroom(s, s.snapshot.edc_value_vdd_a, s.snapshot.edc_limit_vdd_a); } },
+    // Mean clock weighted by each core's C0 residency, i.e. while it runs.
+    { L"Ryzen Effective Clock", L"RyzenEffectiveClock", L"Eff", L"5000 MHz", L" MHz", 0,
+      [](const PluginSample& s, uint32_t) {
+          return Detail(s, s.snapshot.active_core_count && (s.snapshot.core_fields & RM_CORE_FIELD_RESIDENCY) ?
+              s.snapshot.core_freq_weighted_mhz : kNoValue);
+      } },
+    { L"Ryzen Peak Speed", L"RyzenPeakSpeed", L"Peak", L"5000 MHz", L" MHz", 0,
+      [](const PluginSample& s, uint32_t) { return Detail(s, s.snapshot.peak_speed_mhz); } },
+    { L"Ryzen FCLK", L"RyzenFclk", L"FCLK", L"2000 MHz", L" MHz", 0,
+      [](const PluginSample& s, uint32_t) { return Detail(s, s.snapshot.fclk_p0_freq_mhz); } },
+    { L"Ryzen SoC Voltage", L"RyzenSocVoltage", L"SoC", L"1.000 V", L" V", 3,
+      [](const PluginSample& s, uint32_t) { return Detail(s, s.snapshot.soc_voltage); } },
+};
+
+constexpr MetricDef kGraphMetrics[] = {
+    { L"Ryzen Temperature Graph", L"RyzenTempGraph", L"Temp", L"100 \u2103", L" \u2103", 0,
+      [](const PluginSample& s, uint32_t) { return s.snapshot.temperature_c; }, true, 30.0, 100.0 },
+    { L"Ryzen Power Graph", L"RyzenPowerGraph", L"Power", L"200 W", L" W", 0,
+      [](const PluginSample& s, uint32_t) { return s.snapshot.power_w; }, true, 0.0, 200.0 },
+};
+
+constexpr size_t kMetricCount = _countof(kMetrics);
+constexpr size_t kFirstGraphItem = kMetricCount + kCoreItemCount;
+constexpr size_t kGraphCount = _countof(kGraphMetrics) + kCcdGraphCount;
+constexpr size_t kItemCount = kFirstGraphItem + kGraphCount;
+
+// An entry of the item table TrafficMonitor sees: a scalar metric, or a
+// per-core or per-CCD one with its number written into the texts. Graph
+// items come last, so item kFirstGraphItem + n is graph n.
+struct ItemDef {
+    std::array<wchar_t, kItemTextCapacity> name;
+    std::array<wchar_t, kItemTextCapacity> id;
+    std::array<wchar_t, kItemTextCapacity> label;
+    const wchar_t* sample;
+    const wchar_t* suffix;
+    uint32_t decimals;
+    MetricValueFn value;
+    uint32_t index;
+    bool graph;
+    double graph_min;
+    double graph_max;
+};
+
+template <size_t N>
+constexpr void ComposeText(std::array<wchar_t, N>& dst, const wchar_t* prefix, uint32_t number, const wchar_t* suffix) {
+    std::array<wchar_t, N> digits{};
+    FormatValue(digits, static_cast<int32_t>(number), 0, suffix);
+    size_t length = 0;
+    while (*prefix && length + 1 < N) {
+        dst[length++] = *prefix++;
+    }
+    for (size_t i = 0; digits[i] && length + 1 < N; ++i) {
+        dst[length++] = digits[i];
     }
+    dst[length] = L'\0';
 }
 
-const wchar_t* ItemLabel(ItemIndex index) {
-    switch (index) {
-    case ItemIndex::Temp:
-        return L"Temp";
-    case ItemIndex::Usage:
-        return L"Usage";
-    case ItemIndex::Power:
-        return L"Power";
-    default:
-        return L"Value";
+template <size_t N>
+constexpr void CopyConstText(std::array<wchar_t, N>& dst, const wchar_t* src) {
+    size_t length = 0;
+    while (*src && length + 1 < N) {
+        dst[length++] = *src++;
     }
+    dst[length] = L'\0';
+}
+
+constexpr ItemDef MetricItem(const MetricDef& metric) {
+    ItemDef item{};
+    CopyConstText(item.name, metric.name);
+    CopyConstText(item.id, metric.id);
+    CopyConstText(item.label, metric.label);
+    item.sample = metric.sample;
+    item.suffix = metric.suffix;
+    item.decimals = metric.decimals;
+    item.value = metric.value;
+    item.graph = metric.graph;
+    item.graph_min = metric.graph_min;
+    item.graph_max = metric.graph_max;
+    return item;
 }
 
-const wchar_t* ItemSample(ItemIndex index) {
-    switch (index) {
-    case ItemIndex::Temp:
-        return L"100 \u2103";
-    case ItemIndex::Usage:
-        return L"100 %";
-    case ItemIndex::Power:
-        return L"200 W";
-    default:
-        return L"0";
+constexpr std::array<ItemDef, kItemCount> kItems = [] {
+    std::array<ItemDef, kItemCount> items{};
+    size_t next = 0;
+    for (const MetricDef& metric : kMetrics) {
+        items[next++] = MetricItem(metric);
+    }
+    for (uint32_t core = 0; core < kCoreItemCount; ++core) {
+        ItemDef& item = items[next++];
+        ComposeText(item.name, L"Ryzen Core ", core, L" Clock");
+        ComposeText(item.id, L"RyzenCore", core, L"Clock");
+        ComposeText(item.label, L"Core ", core, L"");
+        item.sample = L"5000 MHz";
+        item.suffix = L" MHz";
+        item.value = CoreClock;
+        item.index = core;
+    }
+    for (const MetricDef& metric : kGraphMetrics) {
+        items[next++] = MetricItem(metric);
+    }
+    for (uint32_t ccd = 0; ccd < kCcdGraphCount; ++ccd) {
+        ItemDef& item = items[next++];
+        ComposeText(item.name, L"Ryzen CCD ", ccd, L" Load Graph");
+        ComposeText(item.id, L"RyzenCcd", ccd, L"LoadGraph");
+        ComposeText(item.label, L"CCD ", ccd, L"");
+        item.sample = L"100 %";
+        item.suffix = L" %";
+        item.value = CcdLoad;
+        item.index = ccd;
+        item.graph = true;
+        item.graph_max = 100.0;
+    }
+    return items;
+}();
+
+static_assert(TextIs(kItems[0].id, L"RyzenTemp") && TextIs(kItems[1].id, L"RyzenUsage") &&
+              TextIs(kItems[2].id, L"RyzenPower"), "ids saved by TrafficMonitor must not move");
+static_assert(TextIs(kItems[kMetricCount + 12].name, L"Ryzen Core 12 Clock") &&
+              TextIs(kItems[kMetricCount + 12].id, L"RyzenCore12Clock"));
+static_assert(kItems[kFirstGraphItem].graph && !kItems[kFirstGraphItem - 1].graph && kItems[kItemCount - 1].graph &&
+              TextIs(kItems[kItemCount - 1].id, L"RyzenCcd3LoadGraph"));
+
+// Text shown for every item plus the tooltip, in fixed storage so a published
+// set can be handed to TrafficMonitor without allocating.
+struct FormattedValues {
+    std::array<std::array<wchar_t, kValueTextCapacity>, kItemCount> values{};
+    std::array<wchar_t, kTooltipCapacity> tooltip{};
+    // Unrounded values of the graph items; NaN leaves a gap.
+    std::array<float, kGraphCount> graph{};
+};
+
+// Lock-free triple buffer between the worker (producer) and TrafficMonitor's UI
+// thread (consumer). Each side owns one slot outright and the third is handed
+// over with a single atomic exchange, so the UI thread's strings stay valid
+// until its next Acquire no matter how often the worker publishes.
+class ValueExchange {
+public:
+    FormattedValues& Back() { return slots_[back_]; }
+    const FormattedValues& Front() const { return slots_[front_]; }
+
+    void Reset(const FormattedValues& values) {
+        for (auto& slot : slots_) {
+            slot = values;
+        }
+    }
+
+    void Publish() {
+        back_ = ready_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    bool Acquire() {
+        if ((ready_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        front_ = ready_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
     }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<FormattedValues, 3> slots_{};
+    std::atomic<uint8_t> ready_{1};
+    uint8_t front_ = 0;
+    uint8_t back_ = 2;
+};
+
+// A graph item's recent values and the bitmap drawn from them; the column
+// ring of `line` lives in the bitmap's pixels.
+struct GraphCache {
+    std::array<float, kGraphHistory> history{};
+    uint32_t history_head = 0;
+    uint32_t history_count = 0;
+    HDC dc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ old_bitmap = nullptr;
+    bool dark_mode = false;
+    Sparkline line = {};
+};
+
+template <size_t N>
+void CopyText(std::array<wchar_t, N>& dst, const wchar_t* src) {
+    wcsncpy_s(dst.data(), dst.size(), src ? src : L"", _TRUNCATE);
 }
 
 } // namespace
@@ -209,45 +549,263 @@ class RyzenMonitorPlugin;
 
 class RyzenItem final : public IPluginItem {
 public:
-    RyzenItem(RyzenMonitorPlugin& plugin, ItemIndex index)
-        : plugin_(plugin), index_(index) {}
+    void Bind(RyzenMonitorPlugin* plugin, size_t index) {
+        plugin_ = plugin;
+        index_ = index;
+    }
 
-    const wchar_t* GetItemName() const override { return ItemName(index_); }
-    const wchar_t* GetItemId() const override { return ItemId(index_); }
-    const wchar_t* GetItemLableText() const override { return ItemLabel(index_); }
+    const wchar_t* GetItemName() const override { return kItems[index_].name.data(); }
+    const wchar_t* GetItemId() const override { return kItems[index_].id.data(); }
+    const wchar_t* GetItemLableText() const override { return kItems[index_].label.data(); }
     const wchar_t* GetItemValueText() const override;
-    const wchar_t* GetItemValueSampleText() const override { return ItemSample(index_); }
+    const wchar_t* GetItemValueSampleText() const override { return kItems[index_].sample; }
+    bool IsCustomDraw() const override { return kItems[index_].graph; }
+    int GetItemWidthEx(void* hDC) const override;
+    void DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode) override;
 
 private:
-    RyzenMonitorPlugin& plugin_;
-    ItemIndex index_;
+    RyzenMonitorPlugin* plugin_ = nullptr;
+    size_t index_ = 0;
 };
 
 class RyzenMonitorPlugin final : public ITMPlugin {
 public:
+    // Never destroyed: a static destructor would run during DLL unload, under
+    // the loader lock, while the worker may still be inside the SDK. The
+    // worker is stopped by Shutdown instead.
     static RyzenMonitorPlugin& Instance() {
-        static RyzenMonitorPlugin instance;
-        return instance;
+        static RyzenMonitorPlugin* instance = new RyzenMonitorPlugin();
+        return *instance;
+    }
+
+    // Explicit exit path (TMPluginShutdown), called outside DllMain on the
+    // thread that calls DataRequired. The worker releases SDK ownership itself
+    // because the owner mutex belongs to the thread that acquired it. If it
+    // does not finish within kWorkerStopTimeoutMs, everything it uses is left
+    // in place and a later call waits again.
+    bool Shutdown() {
+        if (worker_) {
+            SetEvent(stop_event_);
+            if (WaitForSingleObject(worker_, kWorkerStopTimeoutMs) != WAIT_OBJECT_0) {
+                return false;
+            }
+            CloseHandle(worker_);
+            worker_ = nullptr;
+        }
+        if (request_event_) {
+            CloseHandle(request_event_);
+            request_event_ = nullptr;
+        }
+        if (stop_event_) {
+            CloseHandle(stop_event_);
+            stop_event_ = nullptr;
+        }
+        for (GraphCache& graph : graphs_) {
+            ReleaseGraph(graph);
+        }
+        return true;
     }
 
     IPluginItem* GetItem(int index) override {
-        if (index < 0 || index >= static_cast<int>(ItemIndex::Count)) {
+        if (index < 0 || index >= static_cast<int>(kItemCount)) {
             return nullptr;
         }
         return &items_[static_cast<size_t>(index)];
     }
 
+    // Runs on TrafficMonitor's UI thread: wake the worker and pick up whatever
+    // it finished since the last call. SDK init and reads never happen here.
     void DataRequired() override {
-        double temp = 0.0;
-        double power = 0.0;
-        double usage = 0.0;
+        if (!EnsureWorker()) {
+            return;
+        }
+        SetEvent(request_event_);
+        exchange_.Acquire();
+        AdvanceGraphs();
+    }
+
+    const wchar_t* GetInfo(PluginInfoIndex index) override {
+        switch (index) {
+        case TMI_NAME:
+            return L"Ryzen SDK Monitor";
+        case TMI_DESCRIPTION:
+            return L"Reads Ryzen temperature, usage, and power via Ryzen SDK.";
+        case TMI_AUTHOR:
+            return L"Deepcool";
+        case TMI_COPYRIGHT:
+            return L"Copyright (c) 2025";
+        case TMI_VERSION:
+            return L"1.0.0";
+        case TMI_URL:
+            return L"";
+        default:
+            return L"";
+        }
+    }
+
+    const wchar_t* GetTooltipInfo() override { return exchange_.Front().tooltip.data(); }
+
+    const wchar_t* ValueText(size_t index) const {
+        return exchange_.Front().values[index].data();
+    }
+
+    // UI thread. Paints the cached bitmap in two copies, oldest column first;
+    // the bitmap is rebuilt from the history only when the size or theme
+    // changes.
+    void DrawGraph(size_t index, HDC dc, int x, int y, int w, int h, bool dark_mode) {
+        if (w <= 0 || h <= 0) {
+            return;
+        }
+        GraphCache& graph = graphs_[index - kFirstGraphItem];
+        const uint32_t width = std::min(static_cast<uint32_t>(w), kGraphHistory);
+        const uint32_t height = static_cast<uint32_t>(h);
+        if (!graph.bitmap || graph.line.width != width || graph.line.height != height || graph.dark_mode != dark_mode) {
+            if (!RebuildGraph(graph, kItems[index], dc, width, height, dark_mode)) {
+                return;
+            }
+        }
+
+        const int head = static_cast<int>(graph.line.head);
+        const int older = static_cast<int>(width) - head;
+        BitBlt(dc, x, y, older, h, graph.dc, head, 0, SRCCOPY);
+        if (head != 0) {
+            BitBlt(dc, x + older, y, head, h, graph.dc, 0, 0, SRCCOPY);
+        }
+    }
+
+private:
+    RyzenMonitorPlugin() {
+        for (size_t i = 0; i < items_.size(); ++i) {
+            items_[i].Bind(this, i);
+        }
+        SetUnavailable(nullptr);
+        exchange_.Reset(current_);
+        dirty_ = false;
+    }
+
+    // UI thread: every DataRequired adds one column to each graph, from the
+    // values published last, so the graphs scroll at TrafficMonitor's rate.
+    void AdvanceGraphs() {
+        const FormattedValues& values = exchange_.Front();
+        GdiFlush();
+        for (size_t i = 0; i < kGraphCount; ++i) {
+            GraphCache& graph = graphs_[i];
+            const float value = values.graph[i];
+            graph.history[graph.history_head] = value;
+            graph.history_head = (graph.history_head + 1) % kGraphHistory;
+            graph.history_count = std::min(graph.history_count + 1, kGraphHistory);
+            if (graph.bitmap) {
+                SparklinePush(graph.line, value);
+            }
+        }
+    }
+
+    bool RebuildGraph(GraphCache& graph, const ItemDef& item, HDC dc, uint32_t width, uint32_t height, bool dark_mode) {
+        ReleaseGraph(graph);
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(info.bmiHeader);
+        info.bmiHeader.biWidth = static_cast<LONG>(width);
+        info.bmiHeader.biHeight = -static_cast<LONG>(height);
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        void* bits = nullptr;
+        graph.dc = CreateCompatibleDC(dc);
+        graph.bitmap = graph.dc ? CreateDIBSection(dc, &info, DIB_RGB_COLORS, &bits, nullptr, 0) : nullptr;
+        if (!graph.bitmap || !bits) {
+            ReleaseGraph(graph);
+            return false;
+        }
+        graph.old_bitmap = SelectObject(graph.dc, graph.bitmap);
+        graph.dark_mode = dark_mode;
+
+        const SparklineStyle style = dark_mode ? SparklineStyle{ 0x000000, 0x1E465A, 0x5AC8FA }
+                                               : SparklineStyle{ 0xFFFFFF, 0xC8E1F5, 0x0078D7 };
+        SparklineInit(graph.line, static_cast<uint32_t*>(bits), width, height, item.graph_min, item.graph_max, style);
+        const uint32_t count = std::min(graph.history_count, width);
+        for (uint32_t i = count; i > 0; --i) {
+            SparklinePush(graph.line, graph.history[(graph.history_head + kGraphHistory - i) % kGraphHistory]);
+        }
+        return true;
+    }
+
+    void ReleaseGraph(GraphCache& graph) {
+        if (graph.dc) {
+            if (graph.old_bitmap) {
+                SelectObject(graph.dc, graph.old_bitmap);
+            }
+            DeleteDC(graph.dc);
+        }
+        if (graph.bitmap) {
+            DeleteObject(graph.bitmap);
+        }
+        graph.dc = nullptr;
+        graph.bitmap = nullptr;
+        graph.old_bitmap = nullptr;
+    }
+
+    bool EnsureWorker() {
+        if (worker_) {
+            return true;
+        }
+        if (!request_event_) {
+            request_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        }
+        if (!stop_event_) {
+            stop_event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        }
+        if (!request_event_ || !stop_event_) {
+            return false;
+        }
+        // The worker holds a reference on this DLL and drops it as it exits,
+        // so unloading the plugin can never unmap code it is running.
+        HMODULE module = nullptr;
+        if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                reinterpret_cast<LPCWSTR>(&RyzenMonitorPlugin::WorkerProc), &module)) {
+            return false;
+        }
+        worker_module_ = module;
+        worker_ = CreateThread(nullptr, 0, &RyzenMonitorPlugin::WorkerProc, this, 0, nullptr);
+        if (!worker_) {
+            FreeLibrary(module);
+            return false;
+        }
+        return true;
+    }
+
+    static DWORD WINAPI WorkerProc(LPVOID param) {
+        RyzenMonitorPlugin* plugin = static_cast<RyzenMonitorPlugin*>(param);
+        const HMODULE module = plugin->worker_module_;
+        plugin->WorkerLoop();
+        FreeLibraryAndExitThread(module, 0);
+    }
+
+    void WorkerLoop() {
+        const HANDLE handles[2] = { stop_event_, request_event_ };
+        for (;;) {
+            // Nothing is copied or handed over when no text changed.
+            Refresh();
+            if (dirty_) {
+                exchange_.Back() = current_;
+                exchange_.Publish();
+                dirty_ = false;
+            }
+            if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+                break;
+            }
+        }
+        ReleaseSdkOwnership();
+    }
+
+    // Worker thread only: everything below touches SDK and ownership state.
+    void Refresh() {
         if (rm_ipc_is_service_running() != 0) {
             if (owns_sdk_) {
                 ReleaseSdkOwnership();
             }
-            if (TryReadIpc(temp, power, usage)) {
-                UpdateValues(temp, power, usage);
-                tooltip_.clear();
+            if (TryReadIpc()) {
+                UpdateValues();
+                SetTooltip(nullptr);
                 return;
             }
             if (UseCachedValuesIfFresh(kCacheGraceMs, kWaitingForServiceTooltip)) {
@@ -258,9 +816,9 @@ public:
         }
 
         if (!owns_sdk_) {
-            if (TryReadIpc(temp, power, usage)) {
-                UpdateValues(temp, power, usage);
-                tooltip_.clear();
+            if (TryReadIpc()) {
+                UpdateValues();
+                SetTooltip(nullptr);
                 return;
             }
             if (rm_ipc_owner_try_acquire() == 0) {
@@ -282,7 +840,10 @@ public:
             return;
         }
 
-        int status = rm_monitor_read(ctx_, &temp, &power, &usage);
+        double temp = 0.0;
+        double power = 0.0;
+        double usage = 0.0;
+        int status = rm_monitor_sample(ctx_, &temp, &power, &usage);
         if (status != kStatusOk) {
             ReleaseSdkOwnership();
             if (UseCachedValuesIfFresh(kCacheGraceMs, kUnavailableTooltip)) {
@@ -292,48 +853,15 @@ public:
             return;
         }
 
-        rm_ipc_publish(temp, power, usage, status);
-        UpdateValues(temp, power, usage);
-        tooltip_.clear();
-    }
-
-    const wchar_t* GetInfo(PluginInfoIndex index) override {
-        switch (index) {
-        case TMI_NAME:
-            return L"Ryzen SDK Monitor";
-        case TMI_DESCRIPTION:
-            return L"Reads Ryzen temperature, usage, and power via Ryzen SDK.";
-        case TMI_AUTHOR:
-            return L"Deepcool";
-        case TMI_COPYRIGHT:
-            return L"Copyright (c) 2025";
-        case TMI_VERSION:
-            return L"1.0.0";
-        case TMI_URL:
-            return L"";
-        default:
-            return L"";
+        // rm_monitor_sample has just published the full snapshot; read it back
+        // instead of asking the SDK for more.
+        if (!TryReadIpc()) {
+            SetBasicSample(temp, power, usage);
         }
+        UpdateValues();
+        SetTooltip(nullptr);
     }
 
-    const wchar_t* GetTooltipInfo() override { return tooltip_.c_str(); }
-
-    const std::wstring& ValueText(ItemIndex index) const {
-        return values_[ToIndex(index)];
-    }
-
-private:
-    RyzenMonitorPlugin()
-        : items_{ {
-              RyzenItem(*this, ItemIndex::Temp),
-              RyzenItem(*this, ItemIndex::Usage),
-              RyzenItem(*this, ItemIndex::Power),
-          } } {
-        SetUnavailable(L"");
-    }
-
-    ~RyzenMonitorPlugin() { ReleaseSdkOwnership(); }
-
     bool EnsureInitialized() {
         if (ctx_) {
             return true;
@@ -363,15 +891,36 @@ private:
         return true;
     }
 
-    bool TryReadIpc(double& temp, double& power, double& usage) {
+    // Fills sample_ from shared memory, which costs no SDK call. A service
+    // that publishes only the three basic values still drives those items.
+    bool TryReadIpc() {
+        RMCpuSnapshot& snapshot = sample_.snapshot;
+        if (rm_ipc_read_snapshot(&snapshot, kIpcMaxAgeMs) == kIpcOk && snapshot.status == kStatusOk) {
+            sample_.has_snapshot = true;
+            sample_.has_topology = rm_ipc_read_topology(&sample_.topology, kIpcMaxAgeMs) == kIpcOk;
+            return true;
+        }
+
+        double temp = 0.0;
+        double power = 0.0;
+        double usage = 0.0;
         int status = kStatusOk;
         int result = rm_ipc_read(&temp, &power, &usage, &status, kIpcMaxAgeMs);
         if (result != kIpcOk || status != kStatusOk) {
             return false;
         }
+        SetBasicSample(temp, power, usage);
         return true;
     }
 
+    void SetBasicSample(double temp, double power, double usage) {
+        sample_.snapshot.temperature_c = temp;
+        sample_.snapshot.power_w = power;
+        sample_.snapshot.usage_percent = usage;
+        sample_.has_snapshot = false;
+        sample_.has_topology = false;
+    }
+
     bool UseCachedValuesIfFresh(ULONGLONG max_age_ms, const wchar_t* tooltip) {
         if (!has_cache_) {
             return false;
@@ -380,11 +929,7 @@ private:
         if (now < last_update_ms_ || now - last_update_ms_ > max_age_ms) {
             return false;
         }
-        if (tooltip) {
-            tooltip_.assign(tooltip);
-        } else {
-            tooltip_.clear();
-        }
+        SetTooltip(tooltip);
         return true;
     }
 
@@ -403,35 +948,93 @@ private:
         }
     }
 
-    void SetUnavailable(const wchar_t* tooltip) {
-        for (auto& value : values_) {
-            value.assign(kNotAvailableText);
+    // Tooltips are the constants above (or nullptr for none), so comparing
+    // pointers tells whether the text changed.
+    void SetTooltip(const wchar_t* tooltip) {
+        if (tooltip == shown_tooltip_) {
+            return;
         }
-        if (tooltip) {
-            tooltip_.assign(tooltip);
+        CopyText(current_.tooltip, tooltip);
+        shown_tooltip_ = tooltip;
+        dirty_ = true;
+    }
+
+    // Rewrites an item's text only when what it shows changes: another rounded
+    // value, or a switch between a value and N/A.
+    void SetValue(size_t index, bool available, int32_t rounded) {
+        ShownValue& shown = shown_[index];
+        if (shown.written && shown.available == available && (!available || shown.rounded == rounded)) {
+            return;
+        }
+        auto& text = current_.values[index];
+        if (available) {
+            FormatValue(text, rounded, kItems[index].decimals, kItems[index].suffix);
         } else {
-            tooltip_.clear();
+            CopyText(text, kNotAvailableText);
         }
+        shown = { true, available, rounded };
+        dirty_ = true;
     }
 
-    void UpdateValues(double temp, double power, double usage) {
-        std::array<wchar_t, 32> buffer{};
-        swprintf_s(buffer.data(), buffer.size(), L"%.0f \u2103", temp);
-        values_[ToIndex(ItemIndex::Temp)] = buffer.data();
+    void SetGraphValue(size_t graph, double value) {
+        const float sample = static_cast<float>(value);
+        float& published = current_.graph[graph];
+        const bool both_gaps = sample != sample && published != published;
+        if (sample != published && !both_gaps) {
+            published = sample;
+            dirty_ = true;
+        }
+    }
 
-        swprintf_s(buffer.data(), buffer.size(), L"%.0f %%", usage);
-        values_[ToIndex(ItemIndex::Usage)] = buffer.data();
+    void SetUnavailable(const wchar_t* tooltip) {
+        for (size_t i = 0; i < kItemCount; ++i) {
+            SetValue(i, false, 0);
+        }
+        for (size_t i = 0; i < kGraphCount; ++i) {
+            SetGraphValue(i, kNoValue);
+        }
+        SetTooltip(tooltip);
+    }
 
-        swprintf_s(buffer.data(), buffer.size(), L"%.0f W", power);
-        values_[ToIndex(ItemIndex::Power)] = buffer.data();
+    // Every item reads the same sample_, so one refresh is one consistent set.
+    void UpdateValues() {
+        for (size_t i = 0; i < kItemCount; ++i) {
+            const ItemDef& item = kItems[i];
+            const double value = item.value(sample_, item.index);
+            int32_t rounded = 0;
+            const bool available = RoundForDisplay(value, item.decimals, rounded);
+            SetValue(i, available, rounded);
+            if (item.graph) {
+                SetGraphValue(i - kFirstGraphItem, value);
+            }
+        }
 
         has_cache_ = true;
         last_update_ms_ = GetTickCount64();
     }
 
-    std::array<RyzenItem, static_cast<size_t>(ItemIndex::Count)> items_;
-    std::array<std::wstring, static_cast<size_t>(ItemIndex::Count)> values_{};
-    std::wstring tooltip_;
+    std::array<RyzenItem, kItemCount> items_;
+    ValueExchange exchange_;
+    // Owned by the UI thread.
+    std::array<GraphCache, kGraphCount> graphs_{};
+    HANDLE worker_ = nullptr;
+    HMODULE worker_module_ = nullptr;
+    HANDLE request_event_ = nullptr;
+    HANDLE stop_event_ = nullptr;
+
+    // What current_ shows, so that an unchanged tick rewrites nothing.
+    struct ShownValue {
+        bool written = false;
+        bool available = false;
+        int32_t rounded = 0;
+    };
+
+    // Owned by the worker thread.
+    FormattedValues current_;
+    PluginSample sample_{};
+    std::array<ShownValue, kItemCount> shown_{};
+    const wchar_t* shown_tooltip_ = nullptr;
+    bool dirty_ = false;
     RMMonitorContext* ctx_ = nullptr;
     ULONGLONG last_init_attempt_ = 0;
     int last_status_ = kStatusOk;
@@ -441,9 +1044,28 @@ private:
 };
 
 const wchar_t* RyzenItem::GetItemValueText() const {
-    return plugin_.ValueText(index_).c_str();
+    return plugin_->ValueText(index_);
+}
+
+int RyzenItem::GetItemWidthEx(void* hDC) const {
+    const int dpi = hDC ? GetDeviceCaps(static_cast<HDC>(hDC), LOGPIXELSX) : 96;
+    return MulDiv(kGraphWidth, dpi, 96);
+}
+
+void RyzenItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark_mode) {
+    if (kItems[index_].graph) {
+        plugin_->DrawGraph(index_, static_cast<HDC>(hDC), x, y, w, h, dark_mode);
+    }
 }
 
 extern "C" __declspec(dllexport) ITMPlugin* TMPluginGetInstance() {
     return &RyzenMonitorPlugin::Instance();
 }
+
+// Stops the worker and releases the SDK. TrafficMonitor's plugin interface has
+// no unload callback, so a host that unloads the plugin calls this first; it
+// returns 0 if the worker is still busy and must be called again. Without it
+// the worker simply keeps the DLL loaded until the process exits.
+extern "C" __declspec(dllexport) int TMPluginShutdown() {
+    return RyzenMonitorPlugin::Instance().Shutdown() ? 1 : 0;
+}